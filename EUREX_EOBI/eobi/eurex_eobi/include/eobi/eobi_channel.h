@@ -2,6 +2,7 @@
 #define _EOBI_CHANNEL_H_
 
 #include <algorithm>
+#include <chrono>
 #include <ostream>
 #include <unordered_set>
 #include <unordered_map>
@@ -11,6 +12,8 @@
 #include "eobi_header.h"
 #include "eobi_log.h"
 #include "eobi_product_manager.h"
+#include "eobi_shard.h"
+#include "eobi_snapshot_scheduler.h"
 namespace ns {
 
 class EOBI_Adapter;
@@ -25,18 +28,31 @@ public:
                 TraceLoggerArray_t loggers);
 
     ~EOBI_Channel();
-    bool Init(IAdapterSend* sendApi, std::shared_ptr<Config> config, WorkerThreadPtr workerThread, WorkerThreadPtr networkThread);
+    //logLevel - the level the logger is configured with, lines below it are not even encoded
+    bool Init(IAdapterSend* sendApi, std::shared_ptr<Config> config, WorkerThreadPtr workerThread, WorkerThreadPtr networkThread,
+              const AsyncLogLevel logLevel = AsyncLogLevel::Info);
     void Start();
     void Stop();
     void Post(std::function<void()> fn);
+    //Sharded mode - spreads the product managers round robin over one pinned worker per core (-1 = unpinned).
+    //Sends then come from all the shard threads at once, the IAdapterSend given to Init must be an IConcurrentSend.
+    //Must be called after Init and the product managers are created, before Start
+    bool InitShards(const std::vector<int>& cpuCores,
+                    const size_t queueSize = EOBIShard::DEFAULT_QUEUE_SIZE,
+                    const std::chrono::microseconds maxPostWait = EOBIShard::DEFAULT_MAX_POST_WAIT);
+    //Hot standby mode - the snapshot feed runs for the whole session on shadowThread and keeps the last cycle
+    //of every segment, so a gapped segment recovers as soon as a covering cycle is available. Must be called before Init
+    void EnableShadowSnapshots(WorkerThreadPtr shadowThread);
 
 public:
-    MulticastFeedPtrT CreateFeed(const std::string& feedName, MulticastReceiver::ProcessMessageFunc_t callback, std::shared_ptr<Config> config);
+    MulticastFeedPtrT CreateFeed(const std::string& feedName, MulticastReceiver::ProcessMessageFunc_t callback, std::shared_ptr<Config> config, WorkerThreadPtr processingThread = WorkerThreadPtr());
     void OnIncrementalFeedData(const MessageMeta& mm);
     void OnSnapshotFeedData(const MessageMeta& mm);
     void OnReplayTcpData(const char* buf, size_t len);
     void ProcessReplayData(char* readPtr, size_t len);
     void _StartSnapshot(const ID id);
+    void _OnSnapshotComplete(const ID id);
+    void _OnShadowPublished(const ID id);
 
     //Data Members
     IAdapterSend* _sendApi = nullptr;
@@ -44,8 +60,12 @@ public:
     MulticastFeedPtrT _snapshotFeed;
     WorkerThreadPtr _workerThread;
     WorkerThreadPtr _networkThread;
+    WorkerThreadPtr _shadowThread;
     std::map<MarketSegmentIdT, EOBIProductManger> _productManagers;
-    std::unordered_set<ID> _snapshotIds;
+    EOBISnapshotScheduler _snapshotScheduler;
+    EOBIShadowSnapshots _shadowSnapshots;
+    std::vector<std::unique_ptr<EOBIShard>> _shards;
+    std::unordered_map<MarketSegmentIdT, EOBIShard*> _shardBySegment;
    
     ChannelID_t _channelId;
     ChannelTags _tags;
@@ -2,12 +2,23 @@
 #define _EOBI_LOG_H_
 
 #include "logger/logger.h"
+#include "common/async_log.h"
 
 #define EOBI_ID 30090
+
+//DEBUG/INFO/WARN/ERR only encode their arguments, after a level check, and are formatted on the async log thread.
+//One per thread ring keeps them in order, WARN/ERR are never dropped. Build with EOBI_SYNC_LOGGING to format everything inline
+#ifdef EOBI_SYNC_LOGGING
 #define EOBI_DEBUG() LOG(DEBUG, EOBI_ID)
 #define EOBI_INFO() LOG(INFO, EOBI_ID)
-#define EOBI_LOCAL() LOG_LOCAL(INFO, EOBI_ID)
 #define EOBI_WARN() LOG(WARNING, EOBI_ID)
 #define EOBI_ERR() LOG(ERROR, EOBI_ID)
+#else
+#define EOBI_DEBUG() ASYNC_LOG(ns::AsyncLogLevel::Debug, EOBI_ID)
+#define EOBI_INFO() ASYNC_LOG(ns::AsyncLogLevel::Info, EOBI_ID)
+#define EOBI_WARN() ASYNC_LOG(ns::AsyncLogLevel::Warn, EOBI_ID)
+#define EOBI_ERR() ASYNC_LOG(ns::AsyncLogLevel::Error, EOBI_ID)
+#endif
+#define EOBI_LOCAL() LOG_LOCAL(INFO, EOBI_ID)
 
 #endif
@@ -0,0 +1,198 @@
+#ifndef _EOBI_ORDER_INDEX_H_
+#define _EOBI_ORDER_INDEX_H_
+
+#include <memory>
+#include <vector>
+
+#include "eobi_common.h"
+#include "eobi_log.h"
+
+namespace ns {
+
+using OrderIdT = uint64_t;
+
+//Pooled order node. prev/next link the orders of a single book, next doubles as the free list link
+struct EOBIOrder {
+    OrderIdT orderId = 0;
+    SecurityIdT securityId = 0;
+    int64_t price = 0;
+    int64_t qty = 0;
+    EOBIOrder* prev = nullptr;
+    EOBIOrder* next = nullptr;
+    uint8_t side = 0;
+};
+
+/** Fixed size chunks of order nodes with an intrusive free list.
+    Nodes are recycled on delete so the steady state add/delete/modify path does not allocate
+*/
+class EOBIOrderPool {
+public:
+    static constexpr size_t CHUNK_SIZE = 4096;
+
+    void Reserve(const size_t ordersNum) {
+        while(_capacity < ordersNum) {
+            _AllocateChunk();
+        }
+    }
+
+    EOBIOrder* Acquire() {
+        if(!_freeList) {
+            EOBI_WARN() << "EOBIOrderPool exhausted, growing - capacity=" << _capacity;
+            _AllocateChunk();
+        }
+
+        EOBIOrder* order = _freeList;
+        _freeList = order->next;
+        order->prev = order->next = nullptr;
+        return order;
+    }
+
+    void Release(EOBIOrder* order) {
+        order->prev = nullptr;
+        order->next = _freeList;
+        _freeList = order;
+    }
+
+    size_t GetCapacity() const {
+        return _capacity;
+    }
+
+private:
+    void _AllocateChunk() {
+        _chunks.emplace_back(new EOBIOrder[CHUNK_SIZE]);
+        EOBIOrder* chunk = _chunks.back().get();
+        for(size_t i = 0; i < CHUNK_SIZE; ++i) {
+            chunk[i].next = _freeList;
+            _freeList = &chunk[i];
+        }
+        _capacity += CHUNK_SIZE;
+    }
+
+    std::vector<std::unique_ptr<EOBIOrder[]>> _chunks;
+    EOBIOrder* _freeList = nullptr;
+    size_t _capacity = 0;
+};
+
+/** Flat open addressing hash table from TrdRegTSTimePriority to pooled order nodes.
+    Linear probing over a power of two table. Erase uses backward shift deletion
+    so there are no tombstones and probe sequences never degrade over the day
+*/
+class EOBIOrderIndex {
+public:
+    explicit EOBIOrderIndex(const size_t expectedOrdersNum = 0) {
+        Reserve(expectedOrdersNum);
+    }
+
+    //Sizes the table so that expectedOrdersNum orders stay under the max load factor
+    void Reserve(const size_t expectedOrdersNum) {
+        size_t capacity = MIN_CAPACITY;
+        while(capacity * MAX_LOAD_NUMERATOR / MAX_LOAD_DENOMINATOR < expectedOrdersNum) {
+            capacity <<= 1;
+        }
+
+        if(capacity > _slots.size()) {
+            _Rehash(capacity);
+        }
+    }
+
+    EOBIOrder* Find(const SecurityIdT securityId, const OrderIdT orderId) const {
+        for(size_t i = _Home(orderId); ; i = (i + 1) & _mask) {
+            const Slot& slot = _slots[i];
+            if(!slot.order) {
+                return nullptr;
+            }
+            if(slot.orderId == orderId && slot.order->securityId == securityId) {
+                return slot.order;
+            }
+        }
+    }
+
+    //Caller guarantees the order is not already present
+    void Insert(EOBIOrder* order) {
+        if((_size + 1) * MAX_LOAD_DENOMINATOR > _slots.size() * MAX_LOAD_NUMERATOR) {
+            EOBI_WARN() << "EOBIOrderIndex above max load, growing - capacity=" << _slots.size() << ", size=" << _size;
+            _Rehash(_slots.size() << 1);
+        }
+
+        _Insert(order->orderId, order);
+        ++_size;
+    }
+
+    bool Erase(const EOBIOrder* order) {
+        size_t i = _Home(order->orderId);
+        for(; _slots[i].order != order; i = (i + 1) & _mask) {
+            if(!_slots[i].order) {
+                return false;
+            }
+        }
+
+        //Backward shift - pull later entries of the cluster into the hole unless that would move them before their home slot
+        for(size_t j = (i + 1) & _mask; _slots[j].order; j = (j + 1) & _mask) {
+            const size_t home = _Home(_slots[j].orderId);
+            const bool homeInHoleRange = i <= j ? (i < home && home <= j)
+                                                : (i < home || home <= j);
+            if(!homeInHoleRange) {
+                _slots[i] = _slots[j];
+                i = j;
+            }
+        }
+
+        _slots[i] = Slot{};
+        --_size;
+        return true;
+    }
+
+    size_t GetSize() const {
+        return _size;
+    }
+
+    size_t GetCapacity() const {
+        return _slots.size();
+    }
+
+private:
+    static constexpr size_t MIN_CAPACITY = 1024;
+    static constexpr size_t MAX_LOAD_NUMERATOR = 1;
+    static constexpr size_t MAX_LOAD_DENOMINATOR = 2;
+
+    struct Slot {
+        OrderIdT orderId = 0;
+        EOBIOrder* order = nullptr;
+    };
+
+    //TrdRegTSTimePriority is a nanosecond timestamp - fibonacci hashing spreads the low order bits
+    size_t _Home(const OrderIdT orderId) const {
+        return (orderId * 0x9E3779B97F4A7C15ULL) >> _shift;
+    }
+
+    void _Insert(const OrderIdT orderId, EOBIOrder* order) {
+        size_t i = _Home(orderId);
+        while(_slots[i].order) {
+            i = (i + 1) & _mask;
+        }
+        _slots[i].orderId = orderId;
+        _slots[i].order = order;
+    }
+
+    void _Rehash(const size_t capacity) {
+        std::vector<Slot> previous(capacity);
+        previous.swap(_slots);
+        _mask = capacity - 1;
+        _shift = 64 - __builtin_ctzll(capacity);
+
+        for(const Slot& slot: previous) {
+            if(slot.order) {
+                _Insert(slot.orderId, slot.order);
+            }
+        }
+    }
+
+    std::vector<Slot> _slots;
+    size_t _mask = 0;
+    unsigned _shift = 64;
+    size_t _size = 0;
+};
+
+}//end namespace
+
+#endif
@@ -0,0 +1,367 @@
+#ifndef _EOBI_ORDERBOOK_H_
+#define _EOBI_ORDERBOOK_H_
+
+#include <unordered_map>
+#include <vector>
+
+#include "eobi_common.h"
+#include "eobi_log.h"
+#include "eobi_order_index.h"
+#include "eobi_price_ladder.h"
+
+namespace ns {
+
+struct EOBIBookConfig {
+    //Orders resting across the whole market segment, used to pre-size the order index and node pool
+    size_t expectedOrdersNum = 64 * 1024;
+    //Price grid in 1e-8 fixed point per SecurityID, from the instrument definitions. Prices off the grid fall back
+    //to the ladder overflow map
+    std::unordered_map<SecurityIdT, int64_t> tickSizes;
+    //Grid of the instruments without a definition
+    int64_t tickSize = 1000000;
+    //Width of the array part of the ladder, per side. Must be a multiple of 64
+    size_t ladderTicks = 256;
+    //Aggregated levels published per side as LevelBook events, level 1 is the BBO. 0 - order events only
+    size_t publishDepth = 5;
+};
+
+/** Order by order book for a single SecurityID.
+    Order nodes are owned by EOBIOrderbooks, the book links its own orders and aggregates them into price levels per side
+*/
+class EOBIOrderbook {
+public:
+    EOBIOrderbook(const int64_t tickSize, const size_t ladderTicks, const size_t publishDepth)
+        : _bids(tickSize, ladderTicks)
+        , _asks(tickSize, ladderTicks)
+        , _publishedBids(publishDepth)
+        , _publishedAsks(publishDepth)
+        , _depthLevels(publishDepth)
+    {
+    }
+
+    void AddOrder(EOBIOrder* order) {
+        order->prev = nullptr;
+        order->next = _orders;
+        if(_orders) {
+            _orders->prev = order;
+        }
+        _orders = order;
+        ++_ordersNum;
+
+        EOBILevel& level = _GetLevel(order->side, order->price);
+        level.qty += order->qty;
+        ++level.ordersNum;
+    }
+
+    void RemoveOrder(EOBIOrder* order) {
+        if(order->prev)     order->prev->next = order->next;
+        else                _orders = order->next;
+        if(order->next)     order->next->prev = order->prev;
+        --_ordersNum;
+
+        _RemoveFromLevel(order->side, order->price, order->qty, true);
+    }
+
+    //Same priority modify - only the qty can change. A resting order always has its level, false if it does not
+    bool ModifyOrder(EOBIOrder* order, const int64_t newQty) {
+        EOBILevel* level = _FindLevel(order->side, order->price);
+        if(!level) {
+            assert(!"ModifyOrder - level not found");
+            EOBI_WARN() << "ModifyOrder - level not found, book inconsistent - securityId=" << order->securityId
+            << ", orderId=" << order->orderId
+            << ", side=" << +order->side
+            << ", price=" << order->price;
+            return false;
+        }
+
+        level->qty += newQty - order->qty;
+        order->qty = newQty;
+        return true;
+    }
+
+    //Returns true if the order is fully filled and has been unlinked from the book
+    bool ExecuteOrder(EOBIOrder* order, const int64_t executedQty, const bool isFullExecution) {
+        if(isFullExecution || executedQty >= order->qty) {
+            RemoveOrder(order);
+            return true;
+        }
+
+        _RemoveFromLevel(order->side, order->price, executedQty, false);
+        order->qty -= executedQty;
+        return false;
+    }
+
+    //Unlinks every order, handing each node to onOrder so the owner can recycle it
+    template<typename OnOrderT>
+    void Clear(OnOrderT onOrder) {
+        EOBIOrder* order = _orders;
+        while(order) {
+            EOBIOrder* next = order->next;
+            onOrder(order);
+            order = next;
+        }
+
+        _orders = nullptr;
+        _ordersNum = 0;
+        _bids.Clear();
+        _asks.Clear();
+        _publishedBids.count = 0;
+        _publishedAsks.count = 0;
+    }
+
+    bool GetBestBid(EOBILevel& level) const {
+        return _bids.GetBest(level);
+    }
+
+    bool GetBestAsk(EOBILevel& level) const {
+        return _asks.GetBest(level);
+    }
+
+    //Fills up to maxDepth aggregated levels, best first. Returns the number of levels written
+    size_t GetLevels(const uint8_t side, EOBILevel* levels, const size_t maxDepth) const {
+        if(side == 1)       return _bids.CopyLevels(levels, maxDepth);
+        else if(side == 2)  return _asks.CopyLevels(levels, maxDepth);
+
+        assert(!"GetLevels - unhandled side");
+        return 0;
+    }
+
+    /** After a change of the level at price on side - the published levels that differ from the book now, best first,
+        as onLevel(levelNum, level) from levelNum 1. A side that got shallower ends with onLevel(levelNum, nullptr),
+        every level from levelNum on is gone. Changes past the published depth are not looked at
+    */
+    template<typename OnLevelT>
+    void PublishDepth(const uint8_t side, const int64_t price, OnLevelT onLevel) {
+        EOBIPublishedDepth* published = side == 1 ? &_publishedBids : side == 2 ? &_publishedAsks : nullptr;
+        if(!published || published->levels.empty() || !_IsPublished(side, *published, price)) {
+            return;
+        }
+
+        const size_t count = GetLevels(side, _depthLevels.data(), _depthLevels.size());
+        for(size_t i = 0; i < count; ++i) {
+            const EOBILevel& level = _depthLevels[i];
+            EOBILevel& last = published->levels[i];
+            if(i >= published->count || level.price != last.price || level.qty != last.qty || level.ordersNum != last.ordersNum) {
+                last = level;
+                onLevel(i + 1, &level);
+            }
+        }
+        if(count < published->count) {
+            onLevel(count + 1, nullptr);
+        }
+        published->count = count;
+    }
+
+    size_t GetOrdersNum() const {
+        return _ordersNum;
+    }
+
+    int64_t GetTickSize() const {
+        return _bids.GetTickSize();
+    }
+
+    //Moves the book to another price grid, the levels are rebuilt from the resting orders
+    void SetTickSize(const int64_t tickSize) {
+        if(tickSize == GetTickSize()) {
+            return;
+        }
+        _bids.Reset(tickSize);
+        _asks.Reset(tickSize);
+        for(const EOBIOrder* order = _orders; order; order = order->next) {
+            EOBILevel& level = _GetLevel(order->side, order->price);
+            level.qty += order->qty;
+            ++level.ordersNum;
+        }
+    }
+
+private:
+    struct EOBIPublishedDepth {
+        explicit EOBIPublishedDepth(const size_t depth)
+            : levels(depth)
+        {
+        }
+
+        std::vector<EOBILevel> levels;
+        size_t count = 0;
+    };
+
+    //Published side not full yet, or price at or better than its last level
+    static bool _IsPublished(const uint8_t side, const EOBIPublishedDepth& published, const int64_t price) {
+        if(published.count < published.levels.size()) {
+            return true;
+        }
+        const int64_t lastPrice = published.levels[published.count - 1].price;
+        return side == 1 ? price >= lastPrice : price <= lastPrice;
+    }
+
+    EOBILevel& _GetLevel(const uint8_t side, const int64_t price) {
+        return side == 1 ? _bids.GetOrCreate(price) : _asks.GetOrCreate(price);
+    }
+
+    EOBILevel* _FindLevel(const uint8_t side, const int64_t price) {
+        if(side == 1)       return _bids.Find(price);
+        else if(side == 2)  return _asks.Find(price);
+        return nullptr;
+    }
+
+    void _RemoveFromLevel(const uint8_t side, const int64_t price, const int64_t qty, const bool removeOrder) {
+        if(side == 1)       _RemoveFromLevel(_bids, price, qty, removeOrder);
+        else if(side == 2)  _RemoveFromLevel(_asks, price, qty, removeOrder);
+        else {
+            assert(!"_RemoveFromLevel - unhandled side");
+        }
+    }
+
+    template<typename LadderT>
+    void _RemoveFromLevel(LadderT& ladder, const int64_t price, const int64_t qty, const bool removeOrder) {
+        EOBILevel* level = ladder.Find(price);
+        if(!level) {
+            assert(!"_RemoveFromLevel - level not found");
+            return;
+        }
+
+        level->qty -= qty;
+        if(removeOrder) {
+            --level->ordersNum;
+        }
+
+        if(level->ordersNum <= 0) {
+            ladder.Erase(price);
+        }
+    }
+
+    EOBIOrder* _orders = nullptr;
+    size_t _ordersNum = 0;
+    EOBIPriceLadder<true> _bids;
+    EOBIPriceLadder<false> _asks;
+    EOBIPublishedDepth _publishedBids;
+    EOBIPublishedDepth _publishedAsks;
+    std::vector<EOBILevel> _depthLevels;    //book side as of now, compared against the published one
+};
+
+
+/** All books of a market segment. Owns the order node pool and the segment wide order index
+    so lookups by TrdRegTSTimePriority never touch std::unordered_map and deletes never allocate
+*/
+class EOBIOrderbooks {
+public:
+    explicit EOBIOrderbooks(const EOBIBookConfig& config = EOBIBookConfig())
+        : _config(config)
+        , _index(config.expectedOrdersNum)
+    {
+        _pool.Reserve(config.expectedOrdersNum);
+    }
+
+    bool AddOrder(const SecurityIdT securityId, const uint8_t side, const int64_t price, const int64_t qty, const OrderIdT orderId) {
+        if(_index.Find(securityId, orderId)) {
+            assert(!"AddOrder - duplicate orderId");
+            return false;
+        }
+
+        EOBIOrder* order = _pool.Acquire();
+        order->orderId = orderId;
+        order->securityId = securityId;
+        order->price = price;
+        order->qty = qty;
+        order->side = side;
+
+        _index.Insert(order);
+        CreateOrGetOrderbook(securityId).AddOrder(order);
+        return true;
+    }
+
+    //price - of the deleted order, for the level it left
+    bool DeleteOrder(const SecurityIdT securityId, const OrderIdT orderId, int64_t& price) {
+        EOBIOrder* order = _index.Find(securityId, orderId);
+        if(!order) {
+            return false;
+        }
+
+        price = order->price;
+        CreateOrGetOrderbook(securityId).RemoveOrder(order);
+        _Recycle(order);
+        return true;
+    }
+
+    bool ModifyOrder(const SecurityIdT securityId, const OrderIdT orderId, const int64_t newQty) {
+        EOBIOrder* order = _index.Find(securityId, orderId);
+        if(!order) {
+            return false;
+        }
+
+        return CreateOrGetOrderbook(securityId).ModifyOrder(order, newQty);
+    }
+
+    bool ExecuteOrder(const SecurityIdT securityId, const OrderIdT orderId, const int64_t executedQty, const bool isFullExecution) {
+        EOBIOrder* order = _index.Find(securityId, orderId);
+        if(!order) {
+            return false;
+        }
+
+        if(CreateOrGetOrderbook(securityId).ExecuteOrder(order, executedQty, isFullExecution)) {
+            _Recycle(order);
+        }
+        return true;
+    }
+
+    void Clear(const SecurityIdT securityId) {
+        auto it = _orderbooks.find(securityId);
+        if(it != std::end(_orderbooks)) {
+            it->second.Clear([this](EOBIOrder* order) { _Recycle(order); });
+        }
+    }
+
+    template<typename OnLevelT>
+    void PublishDepth(const SecurityIdT securityId, const uint8_t side, const int64_t price, OnLevelT onLevel) {
+        auto it = _orderbooks.find(securityId);
+        if(it != std::end(_orderbooks)) {
+            it->second.PublishDepth(side, price, onLevel);
+        }
+    }
+
+    const EOBIOrderbook* GetOrderbook(const SecurityIdT securityId) const {
+        auto it = _orderbooks.find(securityId);
+        return it != std::end(_orderbooks) ? &it->second : nullptr;
+    }
+
+    EOBIOrderbook& CreateOrGetOrderbook(const SecurityIdT securityId) {
+        auto it = _orderbooks.find(securityId);
+        if(it != std::end(_orderbooks)) {
+            return it->second;
+        }
+        return _orderbooks.try_emplace(securityId, _GetTickSize(securityId), _config.ladderTicks, _config.publishDepth).first->second;
+    }
+
+    //Instrument definition received after the start - the book, if any, moves to the new grid
+    void SetTickSize(const SecurityIdT securityId, const int64_t tickSize) {
+        if(tickSize <= 0) {
+            EOBI_WARN() << "Invalid tick size - securityId=" << securityId << ", tickSize=" << tickSize;
+            return;
+        }
+        _config.tickSizes[securityId] = tickSize;
+        auto it = _orderbooks.find(securityId);
+        if(it != std::end(_orderbooks)) {
+            it->second.SetTickSize(tickSize);
+        }
+    }
+
+private:
+    int64_t _GetTickSize(const SecurityIdT securityId) const {
+        auto it = _config.tickSizes.find(securityId);
+        return it != std::end(_config.tickSizes) ? it->second : _config.tickSize;
+    }
+
+    void _Recycle(EOBIOrder* order) {
+        _index.Erase(order);
+        _pool.Release(order);
+    }
+
+    EOBIBookConfig _config;                 //tickSizes grows with the definitions received later
+    EOBIOrderPool _pool;
+    EOBIOrderIndex _index;
+    std::unordered_map<SecurityIdT, EOBIOrderbook> _orderbooks;
+};
+
+}//end namespace
+
+#endif
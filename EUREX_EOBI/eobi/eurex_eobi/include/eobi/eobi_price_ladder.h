@@ -0,0 +1,373 @@
+#ifndef _EOBI_PRICE_LADDER_H_
+#define _EOBI_PRICE_LADDER_H_
+
+#include <algorithm>
+#include <functional>
+#include <map>
+#include <type_traits>
+#include <vector>
+
+#include "eobi_common.h"
+#include "eobi_log.h"
+
+namespace ns {
+
+struct EOBILevel {
+    int64_t price = 0;
+    int64_t qty = 0;
+    int32_t ordersNum = 0;
+};
+
+/** One side of a book as a tick indexed array.
+    Prices (1e-8 fixed point) are converted to tick indexes and stored in a window of windowTicks
+    contiguous levels that slides to follow the best price. A bitmap of occupied slots keeps best price
+    tracking to a few word scans. Prices outside the window or off the tick grid go to a sparse overflow map.
+    Sliding the window shifts the levels in place, only the ones leaving it go to the overflow map
+*/
+template<bool IsBid>
+class EOBIPriceLadder {
+public:
+    EOBIPriceLadder(const int64_t tickSize, const size_t windowTicks)
+        : _tickSize(tickSize)
+        , _windowTicks(windowTicks)
+    {
+        assert(_tickSize > 0 && _windowTicks > 0 && _windowTicks % 64 == 0);
+    }
+
+    EOBILevel& GetOrCreate(const int64_t price) {
+        int64_t tick = 0;
+        if(_ToTick(price, tick)) {
+            //A new best outside the window moves the window, anything else outside it is an outlier
+            if(!_InWindow(tick) && _IsBetterThanBest(price)) {
+                _Recenter(tick);
+            }
+
+            size_t slot = 0;
+            if(_ToSlot(tick, slot)) {
+                EOBILevel& level = _levels[slot];
+                if(!_IsOccupied(slot)) {
+                    _Occupy(slot);
+                    level = EOBILevel{};
+                    level.price = price;
+                }
+                return level;
+            }
+        }
+
+        EOBILevel& level = _overflow[price];
+        level.price = price;
+        return level;
+    }
+
+    EOBILevel* Find(const int64_t price) {
+        int64_t tick = 0;
+        size_t slot = 0;
+        if(_ToTick(price, tick) && _ToSlot(tick, slot)) {
+            return _IsOccupied(slot) ? &_levels[slot] : nullptr;
+        }
+
+        auto it = _overflow.find(price);
+        return it != std::end(_overflow) ? &it->second : nullptr;
+    }
+
+    void Erase(const int64_t price) {
+        int64_t tick = 0;
+        size_t slot = 0;
+        if(_ToTick(price, tick) && _ToSlot(tick, slot)) {
+            if(_IsOccupied(slot)) {
+                _Vacate(slot);
+            }
+        } else {
+            _overflow.erase(price);
+        }
+
+        //Keep the hot end of the book in the array
+        if(_windowCount == 0 && !_overflow.empty()) {
+            int64_t bestTick = 0;
+            if(_ToTick(_overflow.begin()->first, bestTick)) {
+                _Recenter(bestTick);
+            }
+        }
+    }
+
+    void Clear() {
+        std::fill(std::begin(_occupied), std::end(_occupied), 0);
+        _windowCount = 0;
+        _overflow.clear();
+    }
+
+    //Empties the ladder and moves it to another price grid
+    void Reset(const int64_t tickSize) {
+        assert(tickSize > 0);
+        Clear();
+        _tickSize = tickSize;
+    }
+
+    int64_t GetTickSize() const {
+        return _tickSize;
+    }
+
+    bool Empty() const {
+        return _windowCount == 0 && _overflow.empty();
+    }
+
+    bool GetBest(EOBILevel& level) const {
+        const EOBILevel* windowBest = _windowCount > 0 ? &_levels[_bestSlot] : nullptr;
+        const EOBILevel* overflowBest = _overflow.empty() ? nullptr : &_overflow.begin()->second;
+
+        if(windowBest && overflowBest) {
+            level = _IsBetter(overflowBest->price, windowBest->price) ? *overflowBest : *windowBest;
+            return true;
+        }
+        if(windowBest || overflowBest) {
+            level = windowBest ? *windowBest : *overflowBest;
+            return true;
+        }
+        return false;
+    }
+
+    //Fills up to maxDepth levels, best first. Returns the number of levels written
+    size_t CopyLevels(EOBILevel* levels, const size_t maxDepth) const {
+        size_t count = 0;
+        size_t slot = _bestSlot;
+        bool windowValid = _windowCount > 0;
+        auto overflowIt = std::begin(_overflow);
+
+        while(count < maxDepth && (windowValid || overflowIt != std::end(_overflow))) {
+            const bool takeWindow = windowValid
+                                    && (overflowIt == std::end(_overflow) || !_IsBetter(overflowIt->first, _levels[slot].price));
+            if(takeWindow) {
+                levels[count++] = _levels[slot];
+                windowValid = _NextWorseSlot(slot, slot);
+            } else {
+                levels[count++] = overflowIt->second;
+                ++overflowIt;
+            }
+        }
+        return count;
+    }
+
+private:
+    using OverflowT = std::map<int64_t, EOBILevel, typename std::conditional<IsBid, std::greater<int64_t>, std::less<int64_t>>::type>;
+
+    static bool _IsBetter(const int64_t lhs, const int64_t rhs) {
+        return IsBid ? lhs > rhs : lhs < rhs;
+    }
+
+    bool _IsBetterThanBest(const int64_t price) const {
+        EOBILevel best;
+        return !GetBest(best) || _IsBetter(price, best.price);
+    }
+
+    bool _ToTick(const int64_t price, int64_t& tick) const {
+        if(price % _tickSize != 0) {
+            return false;
+        }
+        tick = price / _tickSize;
+        return true;
+    }
+
+    bool _InWindow(const int64_t tick) const {
+        return !_levels.empty() && tick >= _baseTick && tick < _baseTick + static_cast<int64_t>(_windowTicks);
+    }
+
+    bool _ToSlot(const int64_t tick, size_t& slot) const {
+        if(!_InWindow(tick)) {
+            return false;
+        }
+        slot = static_cast<size_t>(tick - _baseTick);
+        return true;
+    }
+
+    bool _IsOccupied(const size_t slot) const {
+        return (_occupied[slot >> 6] >> (slot & 63)) & 1;
+    }
+
+    void _Occupy(const size_t slot) {
+        _occupied[slot >> 6] |= 1ULL << (slot & 63);
+        if(_windowCount == 0 || _IsBetter(static_cast<int64_t>(slot), static_cast<int64_t>(_bestSlot))) {
+            _bestSlot = slot;
+        }
+        ++_windowCount;
+    }
+
+    void _Vacate(const size_t slot) {
+        _occupied[slot >> 6] &= ~(1ULL << (slot & 63));
+        --_windowCount;
+        if(_windowCount > 0 && slot == _bestSlot) {
+            _NextWorseSlot(slot, _bestSlot);
+        }
+    }
+
+    //Next occupied slot strictly worse than from - downwards for bids, upwards for asks
+    bool _NextWorseSlot(const size_t from, size_t& slot) const {
+        if(IsBid) {
+            if(from == 0) {
+                return false;
+            }
+            size_t word = (from - 1) >> 6;
+            uint64_t bits = _occupied[word] & (~0ULL >> (63 - ((from - 1) & 63)));
+            while(true) {
+                if(bits) {
+                    slot = (word << 6) + 63 - __builtin_clzll(bits);
+                    return true;
+                }
+                if(word == 0) {
+                    return false;
+                }
+                bits = _occupied[--word];
+            }
+        } else {
+            const size_t start = from + 1;
+            if(start >= _windowTicks) {
+                return false;
+            }
+            size_t word = start >> 6;
+            uint64_t bits = _occupied[word] & (~0ULL << (start & 63));
+            while(true) {
+                if(bits) {
+                    slot = (word << 6) + __builtin_ctzll(bits);
+                    return true;
+                }
+                if(++word == _occupied.size()) {
+                    return false;
+                }
+                bits = _occupied[word];
+            }
+        }
+    }
+
+    //Slides the window so that tick sits in its middle. Levels still inside it are shifted in place, the ones leaving
+    //it are spilled to the overflow map and the overflow levels it now covers are pulled in
+    void _Recenter(const int64_t tick) {
+        if(_levels.empty()) {
+            _levels.resize(_windowTicks);
+            _occupied.resize(_windowTicks / 64, 0);
+        }
+
+        const int64_t window = static_cast<int64_t>(_windowTicks);
+        const int64_t baseTick = tick - window / 2;
+        const int64_t shift = baseTick - _baseTick;
+        _baseTick = baseTick;
+
+        if(shift >= window || shift <= -window) {
+            _SpillSlots(0, _windowTicks);
+        } else if(shift > 0) {
+            //Window moves up - the lowest slots leave, the rest move down
+            _SpillSlots(0, static_cast<size_t>(shift));
+            _ShiftDown(static_cast<size_t>(shift));
+        } else if(shift < 0) {
+            //Window moves down - the highest slots leave, the rest move up
+            _SpillSlots(_windowTicks - static_cast<size_t>(-shift), _windowTicks);
+            _ShiftUp(static_cast<size_t>(-shift));
+        }
+
+        _FillFromOverflow();
+        _FindBestSlot();
+    }
+
+    //Moves the occupied slots in [from, to) to the overflow map
+    void _SpillSlots(const size_t from, const size_t to) {
+        for(size_t slot = from; slot < to; ++slot) {
+            if(_IsOccupied(slot)) {
+                _overflow.emplace(_levels[slot].price, _levels[slot]);
+                _occupied[slot >> 6] &= ~(1ULL << (slot & 63));
+                --_windowCount;
+            }
+        }
+    }
+
+    //Slot s moves to s - shift, the slots below shift are already spilled
+    void _ShiftDown(const size_t shift) {
+        const size_t words = _occupied.size();
+        for(size_t word = 0; word < words; ++word) {
+            for(uint64_t bits = _occupied[word]; bits; bits &= bits - 1) {
+                const size_t slot = (word << 6) + __builtin_ctzll(bits);
+                _levels[slot - shift] = _levels[slot];
+            }
+        }
+
+        const size_t wordShift = shift >> 6;
+        const size_t bitShift = shift & 63;
+        for(size_t word = 0; word < words; ++word) {
+            const size_t from = word + wordShift;
+            const uint64_t low = from < words ? _occupied[from] >> bitShift : 0;
+            const uint64_t high = bitShift && from + 1 < words ? _occupied[from + 1] << (64 - bitShift) : 0;
+            _occupied[word] = low | high;
+        }
+    }
+
+    //Slot s moves to s + shift, the slots from windowTicks - shift are already spilled
+    void _ShiftUp(const size_t shift) {
+        const size_t words = _occupied.size();
+        for(size_t word = words; word-- > 0; ) {
+            for(uint64_t bits = _occupied[word]; bits; bits &= ~(1ULL << (63 - __builtin_clzll(bits)))) {
+                const size_t slot = (word << 6) + 63 - __builtin_clzll(bits);
+                _levels[slot + shift] = _levels[slot];
+            }
+        }
+
+        const size_t wordShift = shift >> 6;
+        const size_t bitShift = shift & 63;
+        for(size_t word = words; word-- > 0; ) {
+            const uint64_t low = word >= wordShift ? _occupied[word - wordShift] << bitShift : 0;
+            const uint64_t high = bitShift && word >= wordShift + 1 ? _occupied[word - wordShift - 1] >> (64 - bitShift) : 0;
+            _occupied[word] = low | high;
+        }
+    }
+
+    //The overflow levels on the grid the window now covers - a price range of the map, best first
+    void _FillFromOverflow() {
+        const int64_t lowPrice = _baseTick * _tickSize;
+        const int64_t highPrice = (_baseTick + static_cast<int64_t>(_windowTicks) - 1) * _tickSize;
+        auto it = _overflow.lower_bound(IsBid ? highPrice : lowPrice);
+        const auto end = _overflow.upper_bound(IsBid ? lowPrice : highPrice);
+        while(it != end) {
+            int64_t tick = 0;
+            size_t slot = 0;
+            if(_ToTick(it->first, tick) && _ToSlot(tick, slot)) {
+                _levels[slot] = it->second;
+                _occupied[slot >> 6] |= 1ULL << (slot & 63);
+                ++_windowCount;
+                it = _overflow.erase(it);
+            } else {
+                ++it;
+            }
+        }
+    }
+
+    //Highest occupied slot for bids, lowest for asks
+    void _FindBestSlot() {
+        if(_windowCount == 0) {
+            return;
+        }
+        if(IsBid) {
+            for(size_t word = _occupied.size(); word-- > 0; ) {
+                if(_occupied[word]) {
+                    _bestSlot = (word << 6) + 63 - __builtin_clzll(_occupied[word]);
+                    return;
+                }
+            }
+        } else {
+            for(size_t word = 0; word < _occupied.size(); ++word) {
+                if(_occupied[word]) {
+                    _bestSlot = (word << 6) + __builtin_ctzll(_occupied[word]);
+                    return;
+                }
+            }
+        }
+    }
+
+    int64_t _tickSize;
+    const size_t _windowTicks;
+    int64_t _baseTick = 0;
+    std::vector<EOBILevel> _levels;
+    std::vector<uint64_t> _occupied;
+    size_t _windowCount = 0;
+    size_t _bestSlot = 0;
+    OverflowT _overflow;
+};
+
+}//end namespace
+
+#endif
@@ -1,29 +1,50 @@
 #ifndef _EOBI_PRODUCT_MANAGER_H_
 #define _EOBI_PRODUCT_MANAGER_H_
 
+#include <algorithm>
 #include <unordered_set>
 
 #include "eobi_common.h"
+#include "common/event_batch.h"
 #include "eobi_log.h"
+#include "eobi_orderbook.h"
+#include "common/packet_ring.h"
+#include "eobi_shadow_snapshot.h"
+#include "eobi_templates.h"
 
 using namespace ns;
 
 class EOBIProductManger {
 public:
-    EOBIProductManger(IAdapterSend* sendApi, const ID id);
+    EOBIProductManger(IAdapterSend* sendApi, 
+                        const ID id, 
+                        const EOBIBookConfig& bookConfig = EOBIBookConfig(),
+                        const PacketRingConfig& bufferConfig = PacketRingConfig());
     ~EOBIProductManger();
     void OnIncrementalData(const MessageMeta& mm);
     void OnSnapshotData(const MessageMeta& mm);
     bool RequireSnapshot() const;
+    const EOBIOrderbook* GetOrderbook(const SecurityIdT securityId) const;
+    //Instrument definition received after the start, tickSize in 1e-8 fixed point. On the thread processing the segment
+    void SetTickSize(const SecurityIdT securityId, const int64_t tickSize);
+    //Hot standby mode - recover from the last shadow cycle instead of waiting for the snapshot feed
+    void SetShadowSnapshots(const EOBIShadowSnapshots* shadowSnapshots);
+    bool TryRecoverFromShadow();
+    //Packets of the segment were lost before reaching the product manager
+    void OnPacketsDropped();
 
 private:
     void _OnEOBIPacket(const PacketBufferPtr packetBuffer);
     void _OnEOBIMsg(char* msgPtr, const uint16_t templateId, const MsgSeqNumT msgSeqNum);
+    bool _IsStaleMsg(const uint16_t templateId, const MsgSeqNumT msgSeqNum) const;
+    bool _IsValidMsg(const MessageHeaderCompT* header, const size_t bytesLeft) const;
+    void _OnSnapshotPacket(const char* buffer, const size_t len);
     void _Process(const ProductSummaryT* msg);
     void _Process(const InstrumentSummaryT* msg);
     void _Process(const SnapshotOrderT* msg);
     void _OnSnapshotComplete();
     void _ProcessEOBIBufferedMsgs();
+    void _RestartRecovery(const MessageMeta& mm, const MsgSeqNumT msgSeqNum);
 
     void _Process(const OrderAddT* msg);
     void _Process(const OrderDeleteT* msg);
@@ -34,7 +55,7 @@ private:
     void _Process(const FullOrderExecutionT* msg);
     void _Process(const ExecutionSummaryT* msg);
     template<typename OrderExecutionMsgT>
-    void _ProcessOrderExecution(const OrderExecutionMsgT* msg);
+    void _ProcessOrderExecution(const OrderExecutionMsgT* msg, const bool isFullExecution);
     void _Process(const TradeReportT* msg);
     void _Process(const ProductStateChangeT* msg);
     void _Process(const InstrumentStateChangeT* msg);
@@ -47,18 +68,24 @@ private:
 
     //Helper methods
     MsgSeqNumT _GetMsgSeqNum(const PacketBufferPtr packetBuffer) const;
-    template <typename MsgT>
-    void _ProcessAndAddSecurityId(char* msgPtr);
+    using MsgHandlerFn = void (*)(EOBIProductManger& self, char* msgPtr);
+    template<typename MsgT>
+    static void _DispatchMsg(EOBIProductManger& self, char* msgPtr);
+    static void _IgnoreMsg(EOBIProductManger& self, char* msgPtr);
     template<typename MsgT>
     void _AddSecurityId(const MsgT* msg);
     void _AddOrder(const SecurityIdT securityId,
                     const uint8_t side, 
                     const int64_t price, 
-                    const int32_t qty, 
+                    const int64_t qty, 
                     const uint64_t orderId);
     void _DeleteOrder(const SecurityIdT securityId, 
                         const uint8_t side, 
                         const uint64_t orderId);
+    void _PublishDepth(const SecurityIdT securityId,
+                        const uint8_t side,
+                        const int64_t price,
+                        const bool isSnapshot = false);
     void _ClearOrderBook(const SecurityIdT securityId, 
                         const bool inRecovery = false);
     void _HandleInstrumentStatus(const SecurityIdT securityId, 
@@ -91,10 +118,12 @@ private:
 private:
     //Data Members
     IAdapterSend* _sendApi = nullptr;
+    mutable EventBatch _eventBatch;     //incremental events of the packet being decoded
     ID _id = 0;
     MsgSeqNumT _lastSeqNum = 0;
     std::unordered_set<SecurityIdT> _securityIds;
     std::set<SecurityIdT> _currentDescs;
+    EOBIOrderbooks _orderbooks;
     uint64_t _bufferingSkipLogCounter = 0;
     ns::ChannelID_t _channelId;
 
@@ -102,7 +131,11 @@ private:
     MsgSeqNumT _snapshotSeqNum = NO_VALUE_UINT;
     LastMsgSeqNumT _snapshotLastMsgSeqNum = NO_VALUE_UINT;
     SecurityIdT _snapshotSecurityId = NO_VALUE_SLONG;
-    std::deque<MessageMeta> _bufferedEOBIMsgs;
+    PacketRing _bufferedEOBIMsgs;
+    const EOBIShadowSnapshots* _shadowSnapshots = nullptr;
+
+    //Incremental handlers indexed by TemplateID - EOBI_EOBI_TID_MIN
+    static const std::array<MsgHandlerFn, EOBI_TEMPLATE_TABLE_SIZE> _incrementalHandlers;
     
 
 };
@@ -0,0 +1,126 @@
+#ifndef _EOBI_SHADOW_SNAPSHOT_H_
+#define _EOBI_SHADOW_SNAPSHOT_H_
+
+#include <cstring>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <unordered_map>
+#include <vector>
+
+#include "eobi_common.h"
+#include "eobi_log.h"
+
+namespace ns {
+
+/** Last complete snapshot cycle of one market segment, stamped with ProductSummaryT::LastMsgSeqNumProcessed.
+    Packets are copied out of the feed buffers so the packet pool is not pinned between cycles.
+    Layout is [uint32_t len][packet bytes] repeated packetsNum times
+*/
+struct EOBIShadowSnapshot {
+    ID id = 0;
+    LastMsgSeqNumT lastMsgSeqNumProcessed = NO_VALUE_UINT;
+    std::vector<char> packets;
+    size_t packetsNum = 0;
+
+    template<typename OnPacketT>
+    void ForEachPacket(OnPacketT onPacket) const {
+        const char* readPtr = packets.data();
+        const char* endPtr = readPtr + packets.size();
+        while(readPtr < endPtr) {
+            uint32_t len = 0;
+            std::memcpy(&len, readPtr, sizeof(len));
+            readPtr += sizeof(len);
+            onPacket(readPtr, static_cast<size_t>(len));
+            readPtr += len;
+        }
+    }
+};
+
+using EOBIShadowSnapshotPtr = std::shared_ptr<const EOBIShadowSnapshot>;
+
+/** Shadow copies of the snapshot feed, one per market segment.
+    OnSnapshotPacket is fed continuously from the background snapshot thread. A segment is published once its
+    CompletionIndicator=Complete packet arrives. Get may be called from any thread - publishing only swaps a pointer
+    under the lock, readers keep the previous cycle alive for as long as they replay it
+*/
+class EOBIShadowSnapshots {
+public:
+    using OnPublishedFn = std::function<void(const ID id, const LastMsgSeqNumT lastMsgSeqNumProcessed)>;
+
+    void SetOnPublished(OnPublishedFn onPublished) {
+        _onPublished = onPublished;
+    }
+
+    //Snapshot thread only
+    void OnSnapshotPacket(const char* packet, const size_t len) {
+        if(len < sizeof(PacketHeaderT) + sizeof(MessageHeaderCompT)) {
+            return;
+        }
+
+        const PacketHeaderT* packetHeader = reinterpret_cast<const PacketHeaderT*>(packet);
+        const MessageHeaderCompT* header = reinterpret_cast<const MessageHeaderCompT*>(packet + sizeof(PacketHeaderT));
+        const ID id = packetHeader->MarketSegmentID;
+
+        std::unique_ptr<EOBIShadowSnapshot>& builder = _builders[id];
+        if(header->TemplateID == TID_PRODUCTSUMMARY) {
+            const ProductSummaryT* msg = reinterpret_cast<const ProductSummaryT*>(header);
+            if(builder && builder->packetsNum > 0) {
+                EOBI_WARN() << "Shadow snapshot - cycle restarted before completion, id=" << id;
+            }
+            builder.reset(new EOBIShadowSnapshot());
+            builder->id = id;
+            builder->lastMsgSeqNumProcessed = msg->LastMsgSeqNumProcessed;
+        }
+
+        //Joined mid cycle - wait for the next ProductSummary of this segment
+        if(!builder) {
+            return;
+        }
+
+        const uint32_t packetLen = static_cast<uint32_t>(len);
+        const size_t offset = builder->packets.size();
+        builder->packets.resize(offset + sizeof(packetLen) + len);
+        std::memcpy(builder->packets.data() + offset, &packetLen, sizeof(packetLen));
+        std::memcpy(builder->packets.data() + offset + sizeof(packetLen), packet, len);
+        ++builder->packetsNum;
+
+        if(packetHeader->CompletionIndicator == ENUM_COMPLETION_INDICATOR_COMPLETE) {
+            _Publish(std::move(builder));
+        }
+    }
+
+    EOBIShadowSnapshotPtr Get(const ID id) const {
+        std::lock_guard<std::mutex> lock(_mutex);
+        auto it = _published.find(id);
+        return it != std::end(_published) ? it->second : EOBIShadowSnapshotPtr{};
+    }
+
+private:
+    void _Publish(std::unique_ptr<EOBIShadowSnapshot> snapshot) {
+        const ID id = snapshot->id;
+        const LastMsgSeqNumT lastMsgSeqNumProcessed = snapshot->lastMsgSeqNumProcessed;
+        EOBI_DEBUG() << "Shadow snapshot - published id=" << id
+        << ", lastMsgSeqNum=" << lastMsgSeqNumProcessed
+        << ", packets=" << snapshot->packetsNum
+        << ", bytes=" << snapshot->packets.size();
+
+        {
+            std::lock_guard<std::mutex> lock(_mutex);
+            _published[id] = EOBIShadowSnapshotPtr(std::move(snapshot));
+        }
+
+        if(_onPublished) {
+            _onPublished(id, lastMsgSeqNumProcessed);
+        }
+    }
+
+    std::unordered_map<ID, std::unique_ptr<EOBIShadowSnapshot>> _builders;     //snapshot thread only
+    mutable std::mutex _mutex;
+    std::unordered_map<ID, EOBIShadowSnapshotPtr> _published;
+    OnPublishedFn _onPublished;
+};
+
+}//end namespace
+
+#endif
@@ -0,0 +1,95 @@
+#ifndef _EOBI_SHARD_H_
+#define _EOBI_SHARD_H_
+
+#include <atomic>
+#include <chrono>
+#include <functional>
+#include <thread>
+#include <unordered_map>
+#include <unordered_set>
+
+#include "eobi_common.h"
+#include "eobi_log.h"
+#include "eobi_product_manager.h"
+#include "eobi_spsc_queue.h"
+
+namespace ns {
+
+/** Worker shard owning a subset of the channel's market segments.
+    The channel worker thread is the single producer - it routes incremental and snapshot packets by
+    MarketSegmentID into the shard queue, so per segment ordering is the feed ordering.
+    The shard thread is optionally pinned to a core and is the only thread touching its product managers.
+    A full queue holds the producer for at most maxPostWait, then packets are dropped until the shard catches up.
+    Drops are queued in order as markers per segment, the product manager recovers the segment from them
+*/
+class EOBIShard {
+public:
+    //Every queued packet pins a PacketBufferPool buffer - shards * queueSize has to stay well below the pool size
+    static constexpr size_t DEFAULT_QUEUE_SIZE = 4 * 1024;
+    static constexpr std::chrono::microseconds DEFAULT_MAX_POST_WAIT{500};
+
+    using OnSegmentEventFn = std::function<void(const ID)>;
+
+    EOBIShard(const size_t shardId,
+              const int cpuCore,
+              const size_t queueSize = DEFAULT_QUEUE_SIZE,
+              const std::chrono::microseconds maxPostWait = DEFAULT_MAX_POST_WAIT);
+    ~EOBIShard();
+
+    //Must be called before Start
+    void AddProductManager(const MarketSegmentIdT marketSegmentId, EOBIProductManger* productManager);
+
+    //Callbacks are invoked on the shard thread, the owner is responsible for moving them to its own thread
+    void Start(OnSegmentEventFn onSnapshotRequired, OnSegmentEventFn onSnapshotComplete);
+    void Stop();
+
+    //Producer side, called from the channel worker thread only
+    void PostIncremental(const MessageMeta& mm);
+    void PostSnapshot(const MessageMeta& mm);
+    void PostShadowPublished(const MarketSegmentIdT marketSegmentId);
+
+    size_t GetShardId() const {
+        return _shardId;
+    }
+
+private:
+    enum class ItemType : uint8_t {
+        Incremental,
+        Snapshot,
+        ShadowPublished,
+        Dropped             //items of marketSegmentId were dropped before this one
+    };
+
+    struct Item {
+        MessageMeta mm;
+        ItemType type = ItemType::Incremental;
+        MarketSegmentIdT marketSegmentId = 0;
+    };
+
+    void _Post(const Item& item);
+    bool _TryPost(const Item& item);
+    bool _PostDropped();
+    void _Drop(const Item& item);
+    MarketSegmentIdT _GetMarketSegmentId(const Item& item) const;
+    void _Run();
+    void _Process(const Item& item);
+    void _PinThread();
+
+    const size_t _shardId;
+    const int _cpuCore;
+    const std::chrono::microseconds _maxPostWait;
+    EOBISpscQueue<Item> _queue;
+    std::unordered_map<MarketSegmentIdT, EOBIProductManger*> _productManagers;
+    std::unordered_set<MarketSegmentIdT> _pendingSnapshots;    //shard thread only
+    OnSegmentEventFn _onSnapshotRequired;
+    OnSegmentEventFn _onSnapshotComplete;
+    std::atomic<bool> _running{false};
+    std::thread _thread;
+    std::unordered_set<MarketSegmentIdT> _droppedSegments;     //producer only, markers not queued yet
+    bool _overloaded = false;                                  //producer only, last wait timed out
+    uint64_t _droppedCounter = 0;                              //producer only
+};
+
+}//end namespace
+
+#endif
@@ -0,0 +1,152 @@
+#ifndef _EOBI_SNAPSHOT_SCHEDULER_H_
+#define _EOBI_SNAPSHOT_SCHEDULER_H_
+
+#include <unordered_map>
+#include <unordered_set>
+
+#include "eobi_common.h"
+#include "eobi_log.h"
+
+namespace ns {
+
+/** Tracks every market segment waiting for a snapshot on the shared snapshot feed.
+    Segments can be requested at any time, also while the feed is already running - a segment that gaps
+    mid cycle simply starts at its next ProductSummaryT instead of waiting for the feed to be restarted.
+    A segment's pass through the cycle runs from its ProductSummaryT to its packet with CompletionIndicator complete,
+    only those packets go to its product manager. A segment seen twice marks the cycle boundary, so after a burst of
+    loss all affected segments recover in the same pass
+*/
+class EOBISnapshotScheduler {
+public:
+    struct SegmentProgress {
+        uint32_t requestCycle = 0;
+        uint32_t startCycle = 0;
+        uint32_t endCycle = 0;
+        bool started = false;       //ProductSummaryT of the current pass seen
+        bool ended = false;         //last packet of the current pass seen
+        MsgSeqNumT lastMsgSeqNumProcessed = NO_VALUE_UINT;     //of the current pass
+    };
+
+    //Returns true if the segment was not already pending
+    bool Request(const ID id) {
+        auto pair = _pending.try_emplace(id);
+        if(pair.second) {
+            pair.first->second.requestCycle = _cycle;
+        }
+        return pair.second;
+    }
+
+    //Returns the number of full cycles the segment waited for
+    uint32_t Complete(const ID id) {
+        auto it = _pending.find(id);
+        if(std::end(_pending) == it) {
+            return 0;
+        }
+
+        const SegmentProgress& progress = it->second;
+        EOBI_INFO() << "Snapshot scheduler - segment complete - id=" << id
+        << ", requestCycle=" << progress.requestCycle
+        << ", startCycle=" << progress.startCycle
+        << ", endCycle=" << progress.endCycle
+        << ", passEnded=" << progress.ended
+        << ", lastMsgSeqNumProcessed=" << progress.lastMsgSeqNumProcessed;
+
+        const uint32_t cycles = _cycle - progress.requestCycle;
+        _pending.erase(it);
+        ++_completedInCycle;
+        return cycles;
+    }
+
+    //Called for every snapshot packet. Returns true if it belongs to the pass of a pending segment and is to be dispatched
+    bool OnSnapshotPacket(const char* packet, const size_t len) {
+        if(len < sizeof(PacketHeaderT) + sizeof(MessageHeaderCompT)) {
+            return false;
+        }
+
+        const PacketHeaderT* packetHeader = reinterpret_cast<const PacketHeaderT*>(packet);
+        const MessageHeaderCompT* header = reinterpret_cast<const MessageHeaderCompT*>(packet + sizeof(PacketHeaderT));
+        const ID id = packetHeader->MarketSegmentID;
+        if(header->TemplateID == TID_PRODUCTSUMMARY) {
+            if(_cycleSegments.count(id) != 0) {
+                _OnCycleEnd();
+            }
+            _cycleSegments.insert(id);
+        }
+
+        auto it = _pending.find(id);
+        if(std::end(_pending) == it) {
+            return false;
+        }
+
+        SegmentProgress& progress = it->second;
+        if(header->TemplateID == TID_PRODUCTSUMMARY) {
+            _OnPassStart(id, progress, reinterpret_cast<const ProductSummaryT*>(header));
+        } else if(!progress.started || progress.ended) {
+            //Joined mid segment, or past the end of a pass its product manager did not complete on
+            return false;
+        }
+
+        if(packetHeader->CompletionIndicator == ENUM_COMPLETION_INDICATOR_COMPLETE) {
+            progress.ended = true;
+            progress.endCycle = _cycle;
+        }
+        return true;
+    }
+
+    bool IsPending(const ID id) const {
+        return _pending.count(id) != 0;
+    }
+
+    bool Empty() const {
+        return _pending.empty();
+    }
+
+    size_t GetPendingNum() const {
+        return _pending.size();
+    }
+
+    //Forget the cycle layout once the feed is stopped - the next start may join mid cycle
+    void OnFeedStopped() {
+        _cycleSegments.clear();
+        _completedInCycle = 0;
+    }
+
+private:
+    //A pass still open was cut short, one that ended did not recover the segment - its LastMsgSeqNumProcessed was
+    //behind the gap. Either way the segment goes again from this ProductSummaryT
+    void _OnPassStart(const ID id, SegmentProgress& progress, const ProductSummaryT* msg) {
+        if(progress.started) {
+            EOBI_WARN() << "Snapshot scheduler - segment did not complete in its pass, retrying - id=" << id
+            << ", cycle=" << _cycle
+            << ", startCycle=" << progress.startCycle
+            << ", passEnded=" << progress.ended
+            << ", endCycle=" << progress.endCycle
+            << ", lastMsgSeqNumProcessed=" << progress.lastMsgSeqNumProcessed
+            << ", newLastMsgSeqNumProcessed=" << msg->LastMsgSeqNumProcessed;
+        }
+        progress.started = true;
+        progress.ended = false;
+        progress.startCycle = _cycle;
+        progress.lastMsgSeqNumProcessed = msg->LastMsgSeqNumProcessed;
+    }
+
+    void _OnCycleEnd() {
+        EOBI_INFO() << "Snapshot scheduler - cycle=" << _cycle
+        << " complete, segments=" << _cycleSegments.size()
+        << ", recovered=" << _completedInCycle
+        << ", pending=" << _pending.size();
+
+        ++_cycle;
+        _completedInCycle = 0;
+        _cycleSegments.clear();
+    }
+
+    std::unordered_map<ID, SegmentProgress> _pending;
+    std::unordered_set<ID> _cycleSegments;
+    uint32_t _cycle = 0;
+    size_t _completedInCycle = 0;
+};
+
+}//end namespace
+
+#endif
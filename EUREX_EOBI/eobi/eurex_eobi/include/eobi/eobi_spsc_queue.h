@@ -0,0 +1,92 @@
+#ifndef _EOBI_SPSC_QUEUE_H_
+#define _EOBI_SPSC_QUEUE_H_
+
+#include <atomic>
+#include <cstddef>
+#include <vector>
+
+namespace ns {
+
+//Spin wait hint, a compiler barrier only on targets without one
+inline void EOBICpuRelax() {
+#if defined(__x86_64__) || defined(__i386__)
+    __builtin_ia32_pause();
+#elif defined(__aarch64__) || defined(__arm__)
+    asm volatile("yield" ::: "memory");
+#else
+    std::atomic_signal_fence(std::memory_order_seq_cst);
+#endif
+}
+
+/** Bounded lock free single producer / single consumer ring.
+    Capacity is rounded up to a power of two. Each side keeps a cached copy of the other side's index
+    so the shared cache lines are only touched when the ring looks full or empty
+*/
+template<typename T>
+class EOBISpscQueue {
+public:
+    explicit EOBISpscQueue(const size_t capacity)
+        : _slots(_RoundUp(capacity))
+        , _mask(_slots.size() - 1)
+    {
+    }
+
+    EOBISpscQueue(const EOBISpscQueue&) = delete;
+    EOBISpscQueue& operator=(const EOBISpscQueue&) = delete;
+
+    //Producer side. Returns false if the ring is full
+    bool TryPush(const T& item) {
+        const size_t tail = _tail.load(std::memory_order_relaxed);
+        if(tail - _cachedHead > _mask) {
+            _cachedHead = _head.load(std::memory_order_acquire);
+            if(tail - _cachedHead > _mask) {
+                return false;
+            }
+        }
+
+        _slots[tail & _mask] = item;
+        _tail.store(tail + 1, std::memory_order_release);
+        return true;
+    }
+
+    //Consumer side. Returns false if the ring is empty
+    bool TryPop(T& item) {
+        const size_t head = _head.load(std::memory_order_relaxed);
+        if(head == _cachedTail) {
+            _cachedTail = _tail.load(std::memory_order_acquire);
+            if(head == _cachedTail) {
+                return false;
+            }
+        }
+
+        item = std::move(_slots[head & _mask]);
+        _head.store(head + 1, std::memory_order_release);
+        return true;
+    }
+
+    size_t GetCapacity() const {
+        return _slots.size();
+    }
+
+private:
+    static size_t _RoundUp(const size_t capacity) {
+        size_t result = 2;
+        while(result < capacity) {
+            result <<= 1;
+        }
+        return result;
+    }
+
+    std::vector<T> _slots;
+    const size_t _mask;
+
+    alignas(64) std::atomic<size_t> _head{0};
+    size_t _cachedTail = 0;     //consumer owned
+
+    alignas(64) std::atomic<size_t> _tail{0};
+    size_t _cachedHead = 0;     //producer owned
+};
+
+}//end namespace
+
+#endif
@@ -0,0 +1,143 @@
+#ifndef _EOBI_TEMPLATES_H_
+#define _EOBI_TEMPLATES_H_
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <type_traits>
+#include <utility>
+
+#include "eobi_messages.h"
+
+namespace ns {
+
+enum class EOBITemplateRole : uint8_t {
+    Unknown,
+    Packet,         //PacketHeader, not a message on its own
+    Incremental,
+    Snapshot,
+    Reference       //instrument definitions, not consumed by the book builder
+};
+
+template<typename MsgT, typename = void>
+struct EOBIHasSecurityId : std::false_type {};
+
+template<typename MsgT>
+struct EOBIHasSecurityId<MsgT, decltype(void(std::declval<MsgT>().SecurityID))> : std::true_type {};
+
+/** Static description of one EOBI template.
+    Fixed layouts arrive with BodyLen >= sizeof(MsgT) - later protocol versions append fields, BodyLen steps over them.
+    Messages ending in a repeating group are sent without the unused entries, so their BodyLen only has to reach the
+    offset of the group
+*/
+template<typename MsgT, uint16_t TemplateId, EOBITemplateRole Role, size_t MinBodyLen = sizeof(MsgT)>
+struct EOBITemplateDef {
+    static_assert(TemplateId >= EOBI_EOBI_TID_MIN && TemplateId <= EOBI_EOBI_TID_MAX, "TemplateID out of the EOBI range");
+    static_assert(MinBodyLen <= sizeof(MsgT), "MinBodyLen larger than the message");
+
+    using MsgType = MsgT;
+    static constexpr uint16_t TEMPLATE_ID = TemplateId;
+    static constexpr EOBITemplateRole ROLE = Role;
+    static constexpr bool HAS_SECURITY_ID = EOBIHasSecurityId<MsgT>::value;
+    static constexpr uint16_t MIN_BODY_LEN = static_cast<uint16_t>(MinBodyLen);
+};
+
+template<typename MsgT>
+struct EOBITemplate;
+
+template<> struct EOBITemplate<HeartbeatT>                  : EOBITemplateDef<HeartbeatT, TID_HEARTBEAT, EOBITemplateRole::Incremental> {};
+template<> struct EOBITemplate<PacketHeaderT>               : EOBITemplateDef<PacketHeaderT, TID_PACKET_HEADER, EOBITemplateRole::Packet> {};
+template<> struct EOBITemplate<OrderAddT>                   : EOBITemplateDef<OrderAddT, TID_ORDER_ADD, EOBITemplateRole::Incremental> {};
+template<> struct EOBITemplate<OrderModifyT>                : EOBITemplateDef<OrderModifyT, TID_ORDER_MODIFY, EOBITemplateRole::Incremental> {};
+template<> struct EOBITemplate<OrderDeleteT>                : EOBITemplateDef<OrderDeleteT, TID_ORDER_DELETE, EOBITemplateRole::Incremental> {};
+template<> struct EOBITemplate<OrderMassDeleteT>            : EOBITemplateDef<OrderMassDeleteT, TID_ORDER_MASS_DELETE, EOBITemplateRole::Incremental> {};
+template<> struct EOBITemplate<FullOrderExecutionT>         : EOBITemplateDef<FullOrderExecutionT, TID_FULL_ORDER_EXECUTION, EOBITemplateRole::Incremental> {};
+template<> struct EOBITemplate<PartialOrderExecutionT>      : EOBITemplateDef<PartialOrderExecutionT, TID_PARTIAL_ORDER_EXECUTION, EOBITemplateRole::Incremental> {};
+template<> struct EOBITemplate<OrderModifySamePrioT>        : EOBITemplateDef<OrderModifySamePrioT, TID_ORDER_MODIFY_SAME_PRIO, EOBITemplateRole::Incremental> {};
+template<> struct EOBITemplate<TradeReversalT>              : EOBITemplateDef<TradeReversalT, TID_TRADE_REVERSAL, EOBITemplateRole::Incremental, offsetof(TradeReversalT, MDTradeEntryGrp)> {};
+template<> struct EOBITemplate<TradeReportT>                : EOBITemplateDef<TradeReportT, TID_TRADE_REPORT, EOBITemplateRole::Incremental> {};
+template<> struct EOBITemplate<ExecutionSummaryT>           : EOBITemplateDef<ExecutionSummaryT, TID_EXECUTION_SUMMARY, EOBITemplateRole::Incremental> {};
+template<> struct EOBITemplate<TESTradeReportT>             : EOBITemplateDef<TESTradeReportT, TID_TES_TRADE_REPORT, EOBITemplateRole::Incremental> {};
+template<> struct EOBITemplate<ProductStateChangeT>         : EOBITemplateDef<ProductStateChangeT, TID_PRODUCT_STATE_CHANGE, EOBITemplateRole::Incremental> {};
+template<> struct EOBITemplate<InstrumentStateChangeT>      : EOBITemplateDef<InstrumentStateChangeT, TID_INSTRUMENT_STATE_CHANGE, EOBITemplateRole::Incremental> {};
+template<> struct EOBITemplate<MassInstrumentStateChangeT>  : EOBITemplateDef<MassInstrumentStateChangeT, TID_MASS_INSTRUMENT_STATE_CHANGE, EOBITemplateRole::Incremental, offsetof(MassInstrumentStateChangeT, SecMassStatGrp)> {};
+template<> struct EOBITemplate<AddComplexInstrumentT>       : EOBITemplateDef<AddComplexInstrumentT, TID_ADD_COMPLEX_INSTRUMENT, EOBITemplateRole::Reference, offsetof(AddComplexInstrumentT, InstrmtLegGrp)> {};
+template<> struct EOBITemplate<AddFlexibleInstrumentT>      : EOBITemplateDef<AddFlexibleInstrumentT, TID_ADD_FLEXIBLE_INSTRUMENT, EOBITemplateRole::Reference> {};
+template<> struct EOBITemplate<AddScaledSimpleInstrumentT>  : EOBITemplateDef<AddScaledSimpleInstrumentT, TID_ADD_SCALED_SIMPLE_INSTRUMENT, EOBITemplateRole::Reference> {};
+template<> struct EOBITemplate<AuctionBBOT>                 : EOBITemplateDef<AuctionBBOT, TID_AUCTION_BBO, EOBITemplateRole::Incremental> {};
+template<> struct EOBITemplate<AuctionClearingPriceT>       : EOBITemplateDef<AuctionClearingPriceT, TID_AUCTION_CLEARING_PRICE, EOBITemplateRole::Incremental> {};
+template<> struct EOBITemplate<CrossRequestT>               : EOBITemplateDef<CrossRequestT, TID_CROSS_REQUEST, EOBITemplateRole::Incremental> {};
+template<> struct EOBITemplate<QuoteRequestT>               : EOBITemplateDef<QuoteRequestT, TID_QUOTE_REQUEST, EOBITemplateRole::Incremental> {};
+template<> struct EOBITemplate<TopOfBookT>                  : EOBITemplateDef<TopOfBookT, TID_TOP_OF_BOOK, EOBITemplateRole::Incremental> {};
+template<> struct EOBITemplate<ProductSummaryT>             : EOBITemplateDef<ProductSummaryT, TID_PRODUCT_SUMMARY, EOBITemplateRole::Snapshot> {};
+template<> struct EOBITemplate<InstrumentSummaryT>          : EOBITemplateDef<InstrumentSummaryT, TID_INSTRUMENT_SUMMARY, EOBITemplateRole::Snapshot, offsetof(InstrumentSummaryT, MDInstrumentEntryGrp)> {};
+template<> struct EOBITemplate<SnapshotOrderT>              : EOBITemplateDef<SnapshotOrderT, TID_SNAPSHOT_ORDER, EOBITemplateRole::Snapshot> {};
+
+template<typename... MsgTs>
+struct EOBITemplateList {};
+
+using EOBIAllTemplates = EOBITemplateList<HeartbeatT, PacketHeaderT,
+                                          OrderAddT, OrderModifyT, OrderDeleteT, OrderMassDeleteT,
+                                          FullOrderExecutionT, PartialOrderExecutionT, OrderModifySamePrioT,
+                                          TradeReversalT, TradeReportT, ExecutionSummaryT, TESTradeReportT,
+                                          ProductStateChangeT, InstrumentStateChangeT, MassInstrumentStateChangeT,
+                                          AddComplexInstrumentT, AddFlexibleInstrumentT, AddScaledSimpleInstrumentT,
+                                          AuctionBBOT, AuctionClearingPriceT, CrossRequestT, QuoteRequestT, TopOfBookT,
+                                          ProductSummaryT, InstrumentSummaryT, SnapshotOrderT>;
+
+constexpr size_t EOBI_TEMPLATE_TABLE_SIZE = EOBI_EOBI_TID_MAX - EOBI_EOBI_TID_MIN + 1;
+
+inline constexpr size_t GetEOBITemplateIndex(const uint16_t templateId) {
+    return static_cast<size_t>(templateId - EOBI_EOBI_TID_MIN);
+}
+
+//Unsigned wrap makes ids below EOBI_EOBI_TID_MIN fail the same compare
+inline constexpr bool IsEOBITemplateIdInRange(const uint16_t templateId) {
+    return GetEOBITemplateIndex(templateId) < EOBI_TEMPLATE_TABLE_SIZE;
+}
+
+//Runtime view of EOBITemplate, one entry per TemplateID of the EOBI range
+struct EOBITemplateInfo {
+    uint16_t minBodyLen = sizeof(MessageHeaderCompT);
+    bool hasSecurityId = false;
+    EOBITemplateRole role = EOBITemplateRole::Unknown;
+
+    constexpr bool IsValidBodyLen(const uint16_t bodyLen) const {
+        return bodyLen >= minBodyLen;
+    }
+};
+
+template<typename... MsgTs>
+constexpr std::array<EOBITemplateInfo, EOBI_TEMPLATE_TABLE_SIZE> MakeEOBITemplateInfos(EOBITemplateList<MsgTs...>) {
+    std::array<EOBITemplateInfo, EOBI_TEMPLATE_TABLE_SIZE> infos{};
+    ((infos[GetEOBITemplateIndex(EOBITemplate<MsgTs>::TEMPLATE_ID)] = EOBITemplateInfo{EOBITemplate<MsgTs>::MIN_BODY_LEN,
+                                                                                       EOBITemplate<MsgTs>::HAS_SECURITY_ID,
+                                                                                       EOBITemplate<MsgTs>::ROLE}), ...);
+    return infos;
+}
+
+inline constexpr std::array<EOBITemplateInfo, EOBI_TEMPLATE_TABLE_SIZE> EOBI_TEMPLATE_INFOS = MakeEOBITemplateInfos(EOBIAllTemplates{});
+
+inline const EOBITemplateInfo& GetEOBITemplateInfo(const uint16_t templateId) {
+    static constexpr EOBITemplateInfo unknown{};
+    return IsEOBITemplateIdInRange(templateId) ? EOBI_TEMPLATE_INFOS[GetEOBITemplateIndex(templateId)] : unknown;
+}
+
+/** TemplateID indexed table of handlers, filled at compile time.
+    MakeHandler<MsgT>() supplies the entry of every template in the list, all other ids get the fallback
+*/
+template<typename HandlerT, typename... MsgTs, typename MakeHandlerT>
+constexpr std::array<HandlerT, EOBI_TEMPLATE_TABLE_SIZE> MakeEOBIDispatchTable(EOBITemplateList<MsgTs...>,
+                                                                               const HandlerT fallback,
+                                                                               MakeHandlerT makeHandler) {
+    std::array<HandlerT, EOBI_TEMPLATE_TABLE_SIZE> table{};
+    for(size_t i = 0; i < EOBI_TEMPLATE_TABLE_SIZE; ++i) {
+        table[i] = fallback;
+    }
+    ((table[GetEOBITemplateIndex(EOBITemplate<MsgTs>::TEMPLATE_ID)] = makeHandler(static_cast<const MsgTs*>(nullptr))), ...);
+    return table;
+}
+
+}//end namespace
+
+#endif
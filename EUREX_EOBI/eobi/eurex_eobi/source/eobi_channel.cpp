@@ -28,7 +28,9 @@ EOBI_Channel::~EOBI_Channel()
 {
 }
 
-bool EOBI_Channel::Init(IAdapterSend* sendApi, std::shared_ptr<Config> config, WorkerThreadPtr workerThread, WorkerThreadPtr networkThread) {
+bool EOBI_Channel::Init(IAdapterSend* sendApi, std::shared_ptr<Config> config, WorkerThreadPtr workerThread, WorkerThreadPtr networkThread,
+                        const AsyncLogLevel logLevel) {
+    AsyncLogger::SetLevel(logLevel);
     _sendApi = sendApi;
     _workerThread = workerThread;
     _networkThread = networkThread;
@@ -44,7 +46,7 @@ bool EOBI_Channel::Init(IAdapterSend* sendApi, std::shared_ptr<Config> config, W
     _incrementalFeed->EnableArbitration(EOBIPacketSequenceGetter, ArbitrationType::Packet);
     _incrementalFeed->EnableResetLogic(EOBIPacketResetGetter);
     
-    _snapshotFeed = CreateFeed("SnapshotFeed", std::bind(&EOBI_Channel::OnSnapshotFeedData, this, _1), config);
+    _snapshotFeed = CreateFeed("SnapshotFeed", std::bind(&EOBI_Channel::OnSnapshotFeedData, this, _1), config, _shadowThread);
     if (!_snapshotFeed) {
         EOBI_ERR() << "channelId=" << _channelId << ", snapshot feed create failed";
         return false;
@@ -55,12 +57,12 @@ bool EOBI_Channel::Init(IAdapterSend* sendApi, std::shared_ptr<Config> config, W
     return true;
 }
 
-MulticastFeedPtrT EOBI_Channel::CreateFeed(const std::string& feedName, MulticastReceiver::ProcessMessageFunc_t callback, std::shared_ptr<Config> config) {
+MulticastFeedPtrT EOBI_Channel::CreateFeed(const std::string& feedName, MulticastReceiver::ProcessMessageFunc_t callback, std::shared_ptr<Config> config, WorkerThreadPtr processingThread) {
     auto feedPtr = std::make_unique<MulticastFeed>(_tags, 
                                                     feedName,
                                                     _bufferPool, 
                                                     _networkThread, 
-                                                    _workerThread, 
+                                                    processingThread ? processingThread : _workerThread, 
                                                     callback
                                                     );
 
@@ -88,12 +90,65 @@ MulticastFeedPtrT EOBI_Channel::CreateFeed(const std::string& feedName, Multicas
                    : MulticastFeedPtrT{};
 }
 
+bool EOBI_Channel::InitShards(const std::vector<int>& cpuCores, const size_t queueSize, const std::chrono::microseconds maxPostWait) {
+    if(cpuCores.empty() || !_shards.empty()) {
+        EOBI_ERR() << "channelId=" << _channelId << ", invalid shard setup - cores=" << cpuCores.size() << ", shards=" << _shards.size();
+        return false;
+    }
+    //No lock on the output path - every shard sends on its own
+    if(!dynamic_cast<IConcurrentSend*>(_sendApi)) {
+        EOBI_ERR() << "channelId=" << _channelId << ", sharded mode needs an IConcurrentSend consumer";
+        return false;
+    }
+
+    for(size_t i = 0; i < cpuCores.size(); ++i) {
+        _shards.emplace_back(std::make_unique<EOBIShard>(i, cpuCores[i], queueSize, maxPostWait));
+    }
+
+    //std::map keeps the assignment stable across restarts for the same segment set
+    size_t next = 0;
+    for(auto& pair: _productManagers) {
+        EOBIShard* shard = _shards[next++ % _shards.size()].get();
+        shard->AddProductManager(pair.first, &pair.second);
+        _shardBySegment[pair.first] = shard;
+        EOBI_INFO() << "channelId=" << _channelId << ", marketSegmentId=" << pair.first << " assigned to shardId=" << shard->GetShardId();
+    }
+    return true;
+}
+
+void EOBI_Channel::EnableShadowSnapshots(WorkerThreadPtr shadowThread) {
+    assert(shadowThread && !_snapshotFeed);
+    _shadowThread = shadowThread;
+    //Published on the shadow thread - the worker thread owns the scheduler and the product managers
+    _shadowSnapshots.SetOnPublished([this](const ID id, const LastMsgSeqNumT) {
+        Post([this, id]() { _OnShadowPublished(id); });
+    });
+}
+
 void EOBI_Channel::Start() {
+    if(_shadowThread) {
+        for(auto& pair: _productManagers) {
+            pair.second.SetShadowSnapshots(&_shadowSnapshots);
+        }
+        _snapshotFeed->StartFeed();
+    }
+
+    for(auto& shard: _shards) {
+        //Shard callbacks come in on the shard thread - hop back to the worker thread which owns the snapshot feed
+        shard->Start([this](const ID id) { Post([this, id]() { _StartSnapshot(id); }); },
+                     [this](const ID id) { Post([this, id]() { _OnSnapshotComplete(id); }); });
+    }
     _incrementalFeed->StartFeed();
 }
 
 void EOBI_Channel::Stop() {
     _incrementalFeed->StopFeed();
+    if(_shadowThread && _snapshotFeed->IsEnabled()) {
+        _snapshotFeed->StopFeed();
+    }
+    for(auto& shard: _shards) {
+        shard->Stop();
+    }
 }
 
 void EOBI_Channel::OnIncrementalFeedData(const MessageMeta& mm) {
@@ -104,6 +159,16 @@ void EOBI_Channel::OnIncrementalFeedData(const MessageMeta& mm) {
     const PacketHeaderT* packetHeader = reinterpret_cast<const PacketHeaderT*>(readPtr);
     const MarketSegmentIdT marketSegmentId = packetHeader->MarketSegmentID;
 
+    if(!_shards.empty()) {
+        auto shardIt = _shardBySegment.find(marketSegmentId);
+        if(std::end(_shardBySegment) == shardIt) {
+            EOBI_WARN() << "Failed to find shard - marketSegmentId=" << marketSegmentId;
+            return;
+        }
+        shardIt->second->PostIncremental(mm);
+        return;
+    }
+
     auto it = _productManagers.find(marketSegmentId);
     if(std::end(_productManagers) == it) {
         EOBI_WARN() << "Failed to find product manager - marketSegmentId=" << marketSegmentId;
@@ -116,10 +181,19 @@ void EOBI_Channel::OnIncrementalFeedData(const MessageMeta& mm) {
     }
 }
 
+//Segments join the running feed, the scheduler picks them up at their next ProductSummaryT
 void EOBI_Channel::_StartSnapshot(const ID id) {
-    if(_snapshotFeed && !_snapshotFeed->IsEnabled() && _snapshotIds.count(id) == 0) {
-        EOBI_INFO() << "channelId=" << _channelId << ", Starting snapshot for id=" << id;
-        _snapshotIds.insert(id);
+    if(!_snapshotFeed) {
+        return;
+    }
+
+    if(_snapshotScheduler.Request(id)) {
+        EOBI_INFO() << "channelId=" << _channelId << ", Starting snapshot for id=" << id
+        << ", pending=" << _snapshotScheduler.GetPendingNum()
+        << ", feedEnabled=" << _snapshotFeed->IsEnabled();
+    }
+
+    if(!_snapshotFeed->IsEnabled()) {
         _snapshotFeed->StartFeed();
     }
 }
@@ -136,22 +210,72 @@ void EOBI_Channel::OnSnapshotFeedData(const MessageMeta& mm) {
     const PacketHeaderT* packetHeader = reinterpret_cast<const PacketHeaderT*>(readPtr);
     const MarketSegmentIdT marketSegmentId = packetHeader->MarketSegmentID;
 
-    auto it = _snapshotIds.find(marketSegmentId);
-    if(std::end(_snapshotIds) != it) {
-        auto productManagerIt = _productManagers.find(*it);
-        if(std::end(_productManagers) == productManagerIt) {
-            EOBI_WARN() << "Failed to find product manager Id=" << *it;
-            return;
-        }
+    //Shadow thread - product managers pick the cycle up through _OnShadowPublished
+    if(_shadowThread) {
+        _shadowSnapshots.OnSnapshotPacket(readPtr, packetBuffer->m_bytesReceived);
+        return;
+    }
+
+    //Only the pass of a pending segment, from its ProductSummaryT to its last packet
+    if(!_snapshotScheduler.OnSnapshotPacket(readPtr, packetBuffer->m_bytesReceived)) {
+        return;
+    }
 
-        productManagerIt->second.OnSnapshotData(mm);
-        if(!productManagerIt->second.RequireSnapshot()) {
-            _snapshotIds.erase(marketSegmentId);
+    if(!_shards.empty()) {
+        //Completion is reported back through _OnSnapshotComplete
+        auto shardIt = _shardBySegment.find(marketSegmentId);
+        if(std::end(_shardBySegment) != shardIt) {
+            shardIt->second->PostSnapshot(mm);
         }
-    }   
+        return;
+    }
+
+    auto productManagerIt = _productManagers.find(marketSegmentId);
+    if(std::end(_productManagers) == productManagerIt) {
+        EOBI_WARN() << "Failed to find product manager Id=" << marketSegmentId;
+        return;
+    }
+
+    productManagerIt->second.OnSnapshotData(mm);
+    if(!productManagerIt->second.RequireSnapshot()) {
+        _OnSnapshotComplete(marketSegmentId);
+    }
+}
+
+void EOBI_Channel::_OnSnapshotComplete(const ID id) {
+    const uint32_t cycles = _snapshotScheduler.Complete(id);
+    EOBI_INFO() << "channelId=" << _channelId << ", snapshot complete for id=" << id
+    << ", cyclesWaited=" << cycles
+    << ", pending=" << _snapshotScheduler.GetPendingNum();
 
-    if(_snapshotIds.size() == 0){
+    if(_snapshotScheduler.Empty() && _snapshotFeed->IsEnabled() && !_shadowThread) {
         _snapshotFeed->StopFeed();
+        _snapshotScheduler.OnFeedStopped();
+    }
+}
+
+void EOBI_Channel::_OnShadowPublished(const ID id) {
+    if(!_snapshotScheduler.IsPending(id)) {
+        return;
+    }
+
+    if(!_shards.empty()) {
+        auto shardIt = _shardBySegment.find(id);
+        if(std::end(_shardBySegment) != shardIt) {
+            shardIt->second->PostShadowPublished(id);
+        }
+        return;
+    }
+
+    auto productManagerIt = _productManagers.find(id);
+    if(std::end(_productManagers) == productManagerIt) {
+        EOBI_WARN() << "Failed to find product manager Id=" << id;
+        return;
+    }
+
+    productManagerIt->second.TryRecoverFromShadow();
+    if(!productManagerIt->second.RequireSnapshot()) {
+        _OnSnapshotComplete(id);
     }
 }
 
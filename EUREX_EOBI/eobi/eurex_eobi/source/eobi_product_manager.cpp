@@ -1,21 +1,31 @@
 #include "eobi/eobi_product_manager.h"
 
-EOBIProductManger::EOBIProductManger(IAdapterSend* sendApi, const ID id) 
+EOBIProductManger::EOBIProductManger(IAdapterSend* sendApi, 
+                                    const ID id, 
+                                    const EOBIBookConfig& bookConfig,
+                                    const PacketRingConfig& bufferConfig) 
     : _sendApi(sendApi)
     , _id(id)
+    , _orderbooks(bookConfig)
+    , _bufferedEOBIMsgs(bufferConfig)
 {
+    _eventBatch.SetSendApi(sendApi);
 }
 
 EOBIProductManger::~EOBIProductManger() {
 }
 
 void EOBIProductManger::OnSnapshotData(const MessageMeta& mm) {
+    const auto& packetBuffer = mm.pb;
+    _OnSnapshotPacket(packetBuffer->m_buffer, packetBuffer->m_bytesReceived);
+}
+
+void EOBIProductManger::_OnSnapshotPacket(const char* buffer, const size_t len) {
     if(!_inRecovery) {
         return;
     }
 
-    const auto& packetBuffer = mm.pb;
-    char* readPtr = packetBuffer->m_buffer;
+    const char* readPtr = buffer;
     const PacketHeaderT* packetHeader = reinterpret_cast<const PacketHeaderT*>(readPtr);
     const MarketSegmentIdT marketSegmentId = packetHeader->MarketSegmentID;
 
@@ -23,8 +33,11 @@ void EOBIProductManger::OnSnapshotData(const MessageMeta& mm) {
     
     bool exitSnapshot = false;
     readPtr += sizeof(PacketHeaderT);
-    while(!exitSnapshot && readPtr - packetBuffer->m_buffer < packetBuffer->m_bytesReceived) {
+    while(!exitSnapshot && static_cast<size_t>(readPtr - buffer) < len) {
         const MessageHeaderCompT* header = reinterpret_cast<const MessageHeaderCompT*>(readPtr);
+        if(!_IsValidMsg(header, len - (readPtr - buffer))) {
+            break;
+        }
         const uint16_t templateId = header->TemplateID;
 
         EOBI_INFO() << "Snapshot -"
@@ -71,6 +84,12 @@ void EOBIProductManger::OnSnapshotData(const MessageMeta& mm) {
         readPtr += header->BodyLen;
     }//end while loop
 
+    //The last packet of the segment in this cycle - no need to wait for the next ProductSummary a full cycle later
+    if(!exitSnapshot && IsValid(_snapshotLastMsgSeqNum)
+        && packetHeader->CompletionIndicator == ENUM_COMPLETION_INDICATOR_COMPLETE) {
+        exitSnapshot = true;
+    }
+
     if(exitSnapshot) {
         EOBI_INFO() << "Snapshot - exiting";
         _OnSnapshotComplete();
@@ -93,6 +112,7 @@ void EOBIProductManger::_Process(const InstrumentSummaryT* msg) {
 
     const bool isSnapshot = true;
     _snapshotSecurityId = msg->SecurityID;
+    _orderbooks.Clear(msg->SecurityID);
     
     const uint64_t now = ns::GetNowEpoch(std::chrono::nanoseconds());
     _HandleInstrumentStatus(msg->SecurityID, 
@@ -102,7 +122,9 @@ void EOBIProductManger::_Process(const InstrumentSummaryT* msg) {
                             now,
                             isSnapshot);
 
-    const int statEntriesCount = msg->NoMDEntries;
+    //Only the entries the msg carries - BodyLen was checked down to the offset of the group
+    const size_t sentEntries = (msg->MessageHeader.BodyLen - offsetof(InstrumentSummaryT, MDInstrumentEntryGrp)) / sizeof(msg->MDInstrumentEntryGrp[0]);
+    const int statEntriesCount = static_cast<int>(std::min<size_t>({msg->NoMDEntries, sentEntries, MAX_INSTRUMENT_SUMMARY_MD_INSTRUMENT_ENTRY_GRP}));
     for(int i = 0; i < statEntriesCount; ++i) {
         auto currentEntry = msg->MDInstrumentEntryGrp[i];
 
@@ -152,10 +174,21 @@ void EOBIProductManger::_Process(const SnapshotOrderT* msg) {
     event.entry.order_book.orderId = msg->OrderDetails.TrdRegTSTimePriority;
     event.entry.order_book.priority = msg->OrderDetails.TrdRegTSTimePriority;
 
+    _orderbooks.AddOrder(_snapshotSecurityId,
+                         msg->OrderDetails.Side,
+                         msg->OrderDetails.Price,
+                         msg->OrderDetails.DisplayQty,
+                         msg->OrderDetails.TrdRegTSTimePriority);
     _SendOnSnapshot(event);
+    _PublishDepth(_snapshotSecurityId, msg->OrderDetails.Side, msg->OrderDetails.Price, true);
 }
 
+//Live and shadow snapshots both end here. The book is as of the snapshot LMSN - the buffered tail moves on from there,
+//and when all of it is stale the next packet still has to follow on from the snapshot, not from the msg before the gap
 void EOBIProductManger::_OnSnapshotComplete() {
+    if(_snapshotLastMsgSeqNum != NO_VALUE_UINT) {
+        _lastSeqNum = _snapshotLastMsgSeqNum;
+    }
     _ProcessEOBIBufferedMsgs();
     _snapshotLastMsgSeqNum = NO_VALUE_UINT;
     _snapshotSecurityId = NO_VALUE_SLONG;
@@ -167,24 +200,28 @@ void EOBIProductManger::_OnSnapshotComplete() {
 }
 
 void EOBIProductManger::_ProcessEOBIBufferedMsgs() {
-    EOBI_INFO() << "Snapshot - beginning processing buffered msgs, size=" << _bufferedEOBIMsgs.size() 
+    EOBI_INFO() << "Snapshot - beginning processing buffered msgs, size=" << _bufferedEOBIMsgs.GetSize() 
+    << ", bytes=" << _bufferedEOBIMsgs.GetBytes()
+    << ", arenaBytes=" << _bufferedEOBIMsgs.GetArenaBytes()
+    << ", highWaterPackets=" << _bufferedEOBIMsgs.GetHighWaterPackets()
+    << ", highWaterBytes=" << _bufferedEOBIMsgs.GetHighWaterBytes()
     << ", inRecovery=" << _inRecovery;
 
-    while(!_bufferedEOBIMsgs.empty()) {
-        const auto& currentPacket = _bufferedEOBIMsgs.front();
-        const auto& packetBuffer = currentPacket.pb;
-
-        char* readPtr = packetBuffer->m_buffer;
+    _bufferedEOBIMsgs.Drain([this](char* buffer, const size_t len) {
+        char* readPtr = buffer;
         const PacketHeaderT* packetHeader = reinterpret_cast<const PacketHeaderT*>(readPtr);
         const MarketSegmentIdT marketSegmentId = packetHeader->MarketSegmentID;
         assert(_id == marketSegmentId);
        
         readPtr += sizeof(PacketHeaderT);
-        while(readPtr - packetBuffer->m_buffer < packetBuffer->m_bytesReceived) {
+        while(static_cast<size_t>(readPtr - buffer) < len) {
             const MessageHeaderCompT* header = reinterpret_cast<const MessageHeaderCompT*>(readPtr);
+            if(!_IsValidMsg(header, len - (readPtr - buffer))) {
+                break;
+            }
             const uint32_t msgSeqNum = header->MsgSeqNum;
 
-            if(msgSeqNum > _snapshotLastMsgSeqNum) {
+            if(msgSeqNum > _snapshotLastMsgSeqNum && !_IsStaleMsg(header->TemplateID, msgSeqNum)) {
                 EOBI_INFO() << "Processing buffered msg - Id=" << _id 
                 << ", TemplateId=" << header->TemplateID 
                 << ", MsgSeqNum=" << msgSeqNum
@@ -202,15 +239,32 @@ void EOBIProductManger::_ProcessEOBIBufferedMsgs() {
 
             readPtr += header->BodyLen; //Move to the next msg
         }
+        _eventBatch.Flush();
+    });
 
-        _bufferedEOBIMsgs.pop_front();
-    }
-
-    assert(_bufferedEOBIMsgs.size() == 0);
-    EOBI_INFO() << "Snapshot - finished processing buffered msgs, size=" << _bufferedEOBIMsgs.size() 
+    assert(_bufferedEOBIMsgs.Empty());
+    EOBI_INFO() << "Snapshot - finished processing buffered msgs, size=" << _bufferedEOBIMsgs.GetSize() 
     << ", inRecovery=" << _inRecovery;
 }
 
+//Buffer limit hit - the buffered tail can no longer be trusted to follow a snapshot, start over from this packet
+void EOBIProductManger::_RestartRecovery(const MessageMeta& mm, const MsgSeqNumT msgSeqNum) {
+    EOBI_WARN() << "Recovery buffer full, restarting recovery - Id=" << _id
+    << ", buffered=" << _bufferedEOBIMsgs.GetSize()
+    << ", bytes=" << _bufferedEOBIMsgs.GetBytes()
+    << ", snapshotSeqNum=" << _snapshotSeqNum
+    << ", newSnapshotSeqNum=" << msgSeqNum
+    << ", overflows=" << _bufferedEOBIMsgs.GetOverflows();
+
+    _bufferedEOBIMsgs.Clear();
+    _snapshotSeqNum = msgSeqNum;
+    _snapshotLastMsgSeqNum = NO_VALUE_UINT;
+    _snapshotSecurityId = NO_VALUE_SLONG;
+
+    if(!_bufferedEOBIMsgs.Push(mm)) {
+        assert(!"_RestartRecovery - empty buffer rejected a packet");
+    }
+}
 
 void EOBIProductManger::OnIncrementalData(const MessageMeta& mm) {
     const auto& packetBuffer = mm.pb;
@@ -230,11 +284,17 @@ void EOBIProductManger::OnIncrementalData(const MessageMeta& mm) {
         }
         ++_bufferingSkipLogCounter;
 
-        _bufferedEOBIMsgs.push_back(mm);
+        if(!_bufferedEOBIMsgs.Push(mm)) {
+            _RestartRecovery(mm, msgSeqNum);
+        }
 
         if(!_inRecovery) {
             _inRecovery = true;
             _snapshotSeqNum = msgSeqNum;
+            TryRecoverFromShadow();
+        } else if(!IsValid(_snapshotSeqNum)) {
+            //Buffering restarted by OnPacketsDropped
+            _snapshotSeqNum = msgSeqNum;
         }
         
         return;
@@ -260,9 +320,23 @@ void EOBIProductManger::_OnEOBIPacket(const PacketBufferPtr packetBuffer) {
     readPtr += sizeof(PacketHeaderT);
     while(readPtr - packetBuffer->m_buffer < packetBuffer->m_bytesReceived) {
         const MessageHeaderCompT* header = reinterpret_cast<const MessageHeaderCompT*>(readPtr);
+        if(!_IsValidMsg(header, packetBuffer->m_bytesReceived - (readPtr - packetBuffer->m_buffer))) {
+            break;
+        }
         const uint16_t templateId = header->TemplateID;
         const MsgSeqNumT msgSeqNum = header->MsgSeqNum;
 
+        //Live packets queued behind a recovery may still carry msgs the recovered book already holds
+        if(_IsStaleMsg(templateId, msgSeqNum)) {
+            EOBI_INFO() << "Stale msg - Id=" << _id
+            << ", TemplateId=" << templateId
+            << ", MsgSeqNum=" << msgSeqNum
+            << ", lastSeqNum=" << _lastSeqNum
+            ;
+            readPtr += header->BodyLen;
+            continue;
+        }
+
         EOBI_INFO() << "Incremental msg - Id=" << _id 
         << ", TemplateId=" << templateId 
         << ", MsgSeqNum=" << msgSeqNum 
@@ -276,92 +350,78 @@ void EOBIProductManger::_OnEOBIPacket(const PacketBufferPtr packetBuffer) {
     if(packetHeader->CompletionIndicator == ENUM_COMPLETION_INDICATOR_COMPLETE) {
         _OnCompletionIndicatorComplete();
     }
+    _eventBatch.Flush();
 }
 
+template<typename MsgT>
+void EOBIProductManger::_DispatchMsg(EOBIProductManger& self, char* msgPtr) {
+    const MsgT* msg = reinterpret_cast<const MsgT*>(msgPtr);
+    self._Process(msg);
+    if constexpr (EOBITemplate<MsgT>::HAS_SECURITY_ID) {
+        self._AddSecurityId(msg);
+    }
+}
+
+void EOBIProductManger::_IgnoreMsg(EOBIProductManger& self, char* msgPtr) {
+}
+
+const std::array<EOBIProductManger::MsgHandlerFn, EOBI_TEMPLATE_TABLE_SIZE> EOBIProductManger::_incrementalHandlers =
+    MakeEOBIDispatchTable(EOBITemplateList<OrderAddT,
+                                           OrderDeleteT,
+                                           OrderModifyT,
+                                           OrderModifySamePrioT,
+                                           OrderMassDeleteT,
+                                           TradeReportT,
+                                           FullOrderExecutionT,
+                                           PartialOrderExecutionT,
+                                           ExecutionSummaryT,
+                                           InstrumentStateChangeT,
+                                           QuoteRequestT,
+                                           CrossRequestT,
+                                           AuctionBBOT,
+                                           AuctionClearingPriceT,
+                                           ProductStateChangeT,
+                                           HeartbeatT>{},
+                          &EOBIProductManger::_IgnoreMsg,
+                          [](auto tag) -> MsgHandlerFn {
+                              using MsgT = typename std::remove_cv<typename std::remove_pointer<decltype(tag)>::type>::type;
+                              return &EOBIProductManger::_DispatchMsg<MsgT>;
+                          });
+
 void EOBIProductManger::_OnEOBIMsg(char* msgPtr, const uint16_t templateId, const MsgSeqNumT msgSeqNum) {
 
-    _lastSeqNum = msgSeqNum;
+    //Heartbeats are not filtered as stale and must not move the sequence back
+    _lastSeqNum = std::max(_lastSeqNum, msgSeqNum);
 
-    switch(templateId) {
-    case TID_ORDER_ADD: {
-        _ProcessAndAddSecurityId<OrderAddT>(msgPtr);
-    }
-    break;
-    case TID_ORDER_DELETE: {
-        _ProcessAndAddSecurityId<OrderDeleteT>(msgPtr);        
-    }
-    break;
-    case TID_ORDER_MODIFY: {
-        _ProcessAndAddSecurityId<OrderModifyT>(msgPtr); 
-    }
-    break;
-    case TID_ORDER_MODIFY_SAME_PRIO: {
-        _ProcessAndAddSecurityId<OrderModifySamePrioT>(msgPtr); 
-    }
-    break;
-    case TID_ORDER_MASS_DELETE: {
-        _ProcessAndAddSecurityId<OrderMassDeleteT>(msgPtr);
-    }
-    break;
-    case TID_TRADE_REPORT: {
-        _ProcessAndAddSecurityId<TradeReportT>(msgPtr);
-    }
-    break;
-    case TID_FULL_ORDER_EXECUTION: {
-        _ProcessAndAddSecurityId<FullOrderExecutionT>(msgPtr);
+    //Templates we do not consume and ids outside the EOBI range are skipped
+    if(IsEOBITemplateIdInRange(templateId)) {
+        _incrementalHandlers[GetEOBITemplateIndex(templateId)](*this, msgPtr);
     }
-    break;
-    case TID_PARTIAL_ORDER_EXECUTION: {
-        _ProcessAndAddSecurityId<PartialOrderExecutionT>(msgPtr);
-    }
-    break;
-    case TID_EXECUTION_SUMMARY: {
-        _ProcessAndAddSecurityId<ExecutionSummaryT>(msgPtr);
-    }
-    break;
-    case TID_INSTRUMENT_STATE_CHANGE: {
-        _ProcessAndAddSecurityId<InstrumentStateChangeT>(msgPtr);
-    }
-    break;
-    case TID_QUOTE_REQUEST: {
-        _ProcessAndAddSecurityId<QuoteRequestT>(msgPtr);
-    }
-    break;
-    case TID_CROSS_REQUEST: {
-        _ProcessAndAddSecurityId<CrossRequestT>(msgPtr);
-    }
-    break;
-    case TID_AUCTION_BBO: {
-        _ProcessAndAddSecurityId<AuctionBBOT>(msgPtr);
-    }
-    break;
-    case TID_AUCTION_CLEARING_PRICE: {
-        _ProcessAndAddSecurityId<AuctionClearingPriceT>(msgPtr);
-    }
-    break;
-    case TID_PRODUCT_STATE_CHANGE: {
-        const ProductStateChangeT* msg = reinterpret_cast<const ProductStateChangeT*>(msgPtr);
-        _Process(msg);
-    }
-    break;
-    case TID_HEARTBEAT: {
-        const HeartbeatT* msg = reinterpret_cast<const HeartbeatT*>(msgPtr);
-        _Process(msg);
-    }
-    break;
+}
 
-    default: {
+//Heartbeats carry no book update and are always let through for their LastMsgSeqNumProcessed
+bool EOBIProductManger::_IsStaleMsg(const uint16_t templateId, const MsgSeqNumT msgSeqNum) const {
+    return templateId != TID_HEARTBEAT && msgSeqNum <= _lastSeqNum;
+}
 
+//BodyLen drives the walk through the packet - a message too short for its template or running past the packet stops it
+bool EOBIProductManger::_IsValidMsg(const MessageHeaderCompT* header, const size_t bytesLeft) const {
+    if(bytesLeft < sizeof(MessageHeaderCompT)) {
+        EOBI_WARN() << "Truncated msg header - Id=" << _id << ", bytesLeft=" << bytesLeft;
+        return false;
     }
-    break;
-    }//end switch
-}
 
-template <typename MsgT>
-void EOBIProductManger::_ProcessAndAddSecurityId(char* msgPtr) {
-    const MsgT* msg = reinterpret_cast<const MsgT*>(msgPtr);
-    _Process(msg);
-    _AddSecurityId(msg);
+    const EOBITemplateInfo& info = GetEOBITemplateInfo(header->TemplateID);
+    if(header->BodyLen > bytesLeft || !info.IsValidBodyLen(header->BodyLen)) {
+        EOBI_WARN() << "Invalid msg length - Id=" << _id
+        << ", TemplateId=" << header->TemplateID
+        << ", MsgSeqNum=" << header->MsgSeqNum
+        << ", BodyLen=" << header->BodyLen
+        << ", minBodyLen=" << info.minBodyLen
+        << ", bytesLeft=" << bytesLeft;
+        return false;
+    }
+    return true;
 }
 
 template<typename MsgT>
@@ -439,7 +499,13 @@ void EOBIProductManger::_Process(const OrderModifySamePrioT* msg) {
     event.entry.order_book.quantity = msg->OrderDetails.DisplayQty;
     event.entry.order_book.orderId = msg->OrderDetails.TrdRegTSTimePriority;
     event.entry.order_book.priority = msg->OrderDetails.TrdRegTSTimePriority;
+
+    if(!_orderbooks.ModifyOrder(msg->SecurityID, msg->OrderDetails.TrdRegTSTimePriority, msg->OrderDetails.DisplayQty)) {
+        EOBI_WARN() << "OrderModifySamePrioT - order not found or book inconsistent, securityId=" << msg->SecurityID
+        << ", orderId=" << msg->OrderDetails.TrdRegTSTimePriority;
+    }
     _SendMarketEvent(event);
+    _PublishDepth(msg->SecurityID, msg->OrderDetails.Side, msg->OrderDetails.Price);
 }
 
 void EOBIProductManger::_Process(const OrderMassDeleteT* msg) {
@@ -461,7 +527,7 @@ void EOBIProductManger::_Process(const TradeReportT* msg) {
 }
 
 template<typename OrderExecutionMsgT>
-void EOBIProductManger::_ProcessOrderExecution(const OrderExecutionMsgT* msg) {
+void EOBIProductManger::_ProcessOrderExecution(const OrderExecutionMsgT* msg, const bool isFullExecution) {
     EOBI_INFO() << "OrderExecutionMsgT - securityId=" << msg->SecurityID
     << ", side=" << GetSideAsString(msg->Side)
     << ", price=" << msg->Price
@@ -479,14 +545,20 @@ void EOBIProductManger::_ProcessOrderExecution(const OrderExecutionMsgT* msg) {
     event.entry.order_book.quantity = msg->LastQty;
     event.entry.order_book.orderId = msg->TrdRegTSTimePriority;
     event.entry.order_book.priority = msg->TrdRegTSTimePriority;
+
+    if(!_orderbooks.ExecuteOrder(msg->SecurityID, msg->TrdRegTSTimePriority, msg->LastQty, isFullExecution)) {
+        EOBI_WARN() << "OrderExecutionMsgT - order not found, securityId=" << msg->SecurityID
+        << ", orderId=" << msg->TrdRegTSTimePriority;
+    }
     _SendMarketEvent(event);
+    _PublishDepth(msg->SecurityID, msg->Side, msg->Price);
 }
 
 void EOBIProductManger::_Process(const PartialOrderExecutionT* msg) {
-    _ProcessOrderExecution(msg);
+    _ProcessOrderExecution(msg, false);
 }
 void EOBIProductManger::_Process(const FullOrderExecutionT* msg) {
-    _ProcessOrderExecution(msg);
+    _ProcessOrderExecution(msg, true);
 }
 
 void EOBIProductManger::_Process(const ExecutionSummaryT* msg) {
@@ -625,8 +697,12 @@ void EOBIProductManger::_Process(const HeartbeatT* msg) {
 void EOBIProductManger::_AddOrder(const SecurityIdT securityId, 
                         const uint8_t side, 
                         const int64_t price, 
-                        const int32_t qty, 
+                        const int64_t qty, 
                         const uint64_t orderId) {
+    if(!_orderbooks.AddOrder(securityId, side, price, qty, orderId)) {
+        EOBI_WARN() << "AddOrder - duplicate order, securityId=" << securityId << ", orderId=" << orderId;
+    }
+
     MarketEvent event;
     event.type = MarketEventType::OrderBook;
     event.entry.order_book.action = MarketUpdateAction::New;
@@ -637,11 +713,18 @@ void EOBIProductManger::_AddOrder(const SecurityIdT securityId,
     event.entry.order_book.orderId = orderId;
     event.entry.order_book.priority = orderId;
     _SendMarketEvent(event);
+    _PublishDepth(securityId, side, price);
 }
 
 void EOBIProductManger::_DeleteOrder(const SecurityIdT securityId, 
                             const uint8_t side, 
                             const uint64_t orderId) {
+    int64_t price = 0;
+    const bool deleted = _orderbooks.DeleteOrder(securityId, orderId, price);
+    if(!deleted) {
+        EOBI_WARN() << "DeleteOrder - order not found, securityId=" << securityId << ", orderId=" << orderId;
+    }
+
     MarketEvent event;
     event.type = MarketEventType::OrderBook;
     event.entry.order_book.action = MarketUpdateAction::Delete;
@@ -649,11 +732,38 @@ void EOBIProductManger::_DeleteOrder(const SecurityIdT securityId,
     event.entry.order_book.side = GetSide(side);
     event.entry.order_book.orderId = orderId;
     _SendMarketEvent(event);
+    if(deleted) {
+        _PublishDepth(securityId, side, price);
+    }
+}
+
+//Aggregated levels of the book side the order changed, as LevelBook events - only the published ones that moved
+void EOBIProductManger::_PublishDepth(const SecurityIdT securityId,
+                                        const uint8_t side,
+                                        const int64_t price,
+                                        const bool isSnapshot) {
+    MarketEvent event;
+    event.type = MarketEventType::LevelBook;
+    event.indesc = securityId;
+    event.entry.level_book.side = GetSide(side);
+    _orderbooks.PublishDepth(securityId, side, price, [&](const size_t levelNum, const EOBILevel* level) {
+        event.entry.level_book.level = static_cast<int>(levelNum);
+        if(level) {
+            event.entry.level_book.action = MarketUpdateAction::NewOrChange;
+            event.entry.level_book.price = level->price;
+            event.entry.level_book.quantity = level->qty;
+            event.entry.level_book.numOrders = level->ordersNum;
+        } else {
+            event.entry.level_book.action = MarketUpdateAction::DeleteFrom;
+        }
+        isSnapshot ? _SendOnSnapshot(event) : _SendMarketEvent(event);
+    });
 }
 
 void EOBIProductManger::_ClearOrderBook(const SecurityIdT securityId,
                                         const bool inRecovery) {
     EOBI_INFO() << (inRecovery ? "In recovery - " : "") << "Clearing order book for securityId=" << securityId;
+    _orderbooks.Clear(securityId);
 
     MarketEvent event;
     event.type = ns::MarketEventType::BookReset;
@@ -808,19 +918,87 @@ bool EOBIProductManger::RequireSnapshot() const {
     return _inRecovery;
 }
 
+const EOBIOrderbook* EOBIProductManger::GetOrderbook(const SecurityIdT securityId) const {
+    return _orderbooks.GetOrderbook(securityId);
+}
+
+void EOBIProductManger::SetTickSize(const SecurityIdT securityId, const int64_t tickSize) {
+    _orderbooks.SetTickSize(securityId, tickSize);
+}
+
+void EOBIProductManger::SetShadowSnapshots(const EOBIShadowSnapshots* shadowSnapshots) {
+    _shadowSnapshots = shadowSnapshots;
+}
+
+//Out of recovery the next packet shows the gap. In recovery the buffered tail has a hole and the snapshot cycle in
+//progress may miss a packet - buffer again from the next packet and wait for a cycle covering it
+void EOBIProductManger::OnPacketsDropped() {
+    if(!_inRecovery) {
+        return;
+    }
+
+    EOBI_WARN() << "Packets dropped in recovery, restarting recovery - Id=" << _id
+    << ", buffered=" << _bufferedEOBIMsgs.GetSize()
+    << ", snapshotSeqNum=" << _snapshotSeqNum;
+
+    _bufferedEOBIMsgs.Clear();
+    _snapshotSeqNum = NO_VALUE_UINT;
+    _snapshotLastMsgSeqNum = NO_VALUE_UINT;
+    _snapshotSecurityId = NO_VALUE_SLONG;
+}
+
+//Replays the shadow cycle through the regular snapshot path, which then applies the buffered tail
+bool EOBIProductManger::TryRecoverFromShadow() {
+    if(!_inRecovery || !_shadowSnapshots) {
+        return false;
+    }
+
+    const EOBIShadowSnapshotPtr shadow = _shadowSnapshots->Get(_id);
+    if(!shadow) {
+        return false;
+    }
+
+    if(shadow->lastMsgSeqNumProcessed < _snapshotSeqNum - 1) {
+        EOBI_INFO() << "Shadow snapshot too old - Id=" << _id
+        << ", shadowLMSN=" << shadow->lastMsgSeqNumProcessed
+        << ", snapshotSeqNum=" << _snapshotSeqNum;
+        return false;
+    }
+
+    EOBI_INFO() << "Recovering from shadow snapshot - Id=" << _id
+    << ", shadowLMSN=" << shadow->lastMsgSeqNumProcessed
+    << ", snapshotSeqNum=" << _snapshotSeqNum
+    << ", packets=" << shadow->packetsNum
+    << ", buffered=" << _bufferedEOBIMsgs.GetSize();
+
+    _snapshotLastMsgSeqNum = NO_VALUE_UINT;
+    _snapshotSecurityId = NO_VALUE_SLONG;
+    shadow->ForEachPacket([this](const char* packet, const size_t len) {
+        _OnSnapshotPacket(packet, len);
+    });
+
+    if(_inRecovery) {
+        EOBI_WARN() << "Shadow snapshot did not complete, waiting for the next one - Id=" << _id;
+        _snapshotLastMsgSeqNum = NO_VALUE_UINT;
+        _snapshotSecurityId = NO_VALUE_SLONG;
+        return false;
+    }
+    return true;
+}
+
 inline void EOBIProductManger::_SendMarketEvent(MarketEvent& event) const {
-    _sendApi->OnIncremental(&event);
+    _eventBatch.Append(event);
 }
 
 inline void EOBIProductManger::_SendMarketEventEnd(MarketEvent& event) const {
     auto previousType = event.type;
     event.type = MarketEventType::EventEnd;
-    _sendApi->OnIncremental(&event); 
+    _eventBatch.Append(event);
     event.type = previousType;
 }
 
 inline void EOBIProductManger::_SendOnSnapshot(MarketEvent& event) const {
-    _sendApi->OnSnapshot(&event);
+    _eventBatch.SendSnapshot(event);
 }
 
 void EOBIProductManger::_SendSnapshotEnd() const {
@@ -0,0 +1,186 @@
+#include "eobi/eobi_shard.h"
+#include <pthread.h>
+#include <sched.h>
+
+namespace ns {
+
+EOBIShard::EOBIShard(const size_t shardId, const int cpuCore, const size_t queueSize, const std::chrono::microseconds maxPostWait)
+    : _shardId(shardId)
+    , _cpuCore(cpuCore)
+    , _maxPostWait(maxPostWait)
+    , _queue(queueSize)
+{
+}
+
+EOBIShard::~EOBIShard()
+{
+    Stop();
+}
+
+void EOBIShard::AddProductManager(const MarketSegmentIdT marketSegmentId, EOBIProductManger* productManager) {
+    assert(!_running && productManager);
+    _productManagers[marketSegmentId] = productManager;
+}
+
+void EOBIShard::Start(OnSegmentEventFn onSnapshotRequired, OnSegmentEventFn onSnapshotComplete) {
+    if(_running) {
+        return;
+    }
+
+    _onSnapshotRequired = onSnapshotRequired;
+    _onSnapshotComplete = onSnapshotComplete;
+    _running = true;
+    _thread = std::thread(&EOBIShard::_Run, this);
+
+    EOBI_INFO() << "Shard started - shardId=" << _shardId
+    << ", cpuCore=" << _cpuCore
+    << ", segments=" << _productManagers.size()
+    << ", queueCapacity=" << _queue.GetCapacity()
+    << ", maxPostWaitUs=" << _maxPostWait.count();
+}
+
+void EOBIShard::Stop() {
+    if(!_running) {
+        return;
+    }
+
+    _running = false;
+    if(_thread.joinable()) {
+        _thread.join();
+    }
+    EOBI_INFO() << "Shard stopped - shardId=" << _shardId;
+}
+
+void EOBIShard::PostIncremental(const MessageMeta& mm) {
+    _Post(Item{mm, ItemType::Incremental, 0});
+}
+
+void EOBIShard::PostSnapshot(const MessageMeta& mm) {
+    _Post(Item{mm, ItemType::Snapshot, 0});
+}
+
+void EOBIShard::PostShadowPublished(const MarketSegmentIdT marketSegmentId) {
+    _Post(Item{MessageMeta{}, ItemType::ShadowPublished, marketSegmentId});
+}
+
+//Markers of earlier drops go first, so the shard sees them between the last packet before and the first one after
+void EOBIShard::_Post(const Item& item) {
+    if(!_PostDropped() || !_TryPost(item)) {
+        _Drop(item);
+    }
+}
+
+//Back pressure is bounded - the worker thread feeds every shard and the feeds behind it. Once a wait timed out the
+//producer stops waiting until a push goes through again
+bool EOBIShard::_TryPost(const Item& item) {
+    if(_queue.TryPush(item)) {
+        _overloaded = false;
+        return true;
+    }
+    if(_overloaded) {
+        return false;
+    }
+
+    const auto deadline = std::chrono::steady_clock::now() + _maxPostWait;
+    while(std::chrono::steady_clock::now() < deadline) {
+        std::this_thread::yield();
+        if(_queue.TryPush(item)) {
+            return true;
+        }
+    }
+    _overloaded = true;
+    return false;
+}
+
+bool EOBIShard::_PostDropped() {
+    while(!_droppedSegments.empty()) {
+        auto it = std::begin(_droppedSegments);
+        if(!_TryPost(Item{MessageMeta{}, ItemType::Dropped, *it})) {
+            return false;
+        }
+        _droppedSegments.erase(it);
+    }
+    return true;
+}
+
+void EOBIShard::_Drop(const Item& item) {
+    if(_droppedCounter % 1000 == 0) {
+        EOBI_WARN() << "Shard queue full, dropping - shardId=" << _shardId
+        << ", type=" << static_cast<int>(item.type)
+        << ", count=" << _droppedCounter;
+    }
+    ++_droppedCounter;
+    _droppedSegments.insert(_GetMarketSegmentId(item));
+}
+
+MarketSegmentIdT EOBIShard::_GetMarketSegmentId(const Item& item) const {
+    if(item.type == ItemType::ShadowPublished || item.type == ItemType::Dropped) {
+        return item.marketSegmentId;
+    }
+    const PacketHeaderT* packetHeader = reinterpret_cast<const PacketHeaderT*>(item.mm.pb->m_buffer);
+    return packetHeader->MarketSegmentID;
+}
+
+void EOBIShard::_Run() {
+    _PinThread();
+
+    Item item;
+    while(_running) {
+        if(_queue.TryPop(item)) {
+            _Process(item);
+            item = Item{};  //release the packet buffer
+        } else {
+            EOBICpuRelax();
+        }
+    }
+
+    //Drain whatever the producer already handed over
+    while(_queue.TryPop(item)) {
+        _Process(item);
+    }
+}
+
+void EOBIShard::_Process(const Item& item) {
+    const MarketSegmentIdT marketSegmentId = _GetMarketSegmentId(item);
+
+    auto it = _productManagers.find(marketSegmentId);
+    if(std::end(_productManagers) == it) {
+        EOBI_WARN() << "Shard failed to find product manager - shardId=" << _shardId << ", marketSegmentId=" << marketSegmentId;
+        return;
+    }
+
+    EOBIProductManger& productManager = *it->second;
+    switch(item.type) {
+    case ItemType::Incremental:     productManager.OnIncrementalData(item.mm); break;
+    case ItemType::Snapshot:        productManager.OnSnapshotData(item.mm); break;
+    case ItemType::ShadowPublished: productManager.TryRecoverFromShadow(); break;
+    case ItemType::Dropped:         productManager.OnPacketsDropped(); break;
+    }
+
+    //Only report transitions, the channel keeps its own snapshot bookkeeping
+    const bool requireSnapshot = productManager.RequireSnapshot();
+    const bool pending = _pendingSnapshots.count(marketSegmentId) != 0;
+    if(requireSnapshot && !pending) {
+        _pendingSnapshots.insert(marketSegmentId);
+        _onSnapshotRequired(marketSegmentId);
+    } else if(!requireSnapshot && pending) {
+        _pendingSnapshots.erase(marketSegmentId);
+        _onSnapshotComplete(marketSegmentId);
+    }
+}
+
+void EOBIShard::_PinThread() {
+    if(_cpuCore < 0) {
+        return;
+    }
+
+    cpu_set_t cpuSet;
+    CPU_ZERO(&cpuSet);
+    CPU_SET(_cpuCore, &cpuSet);
+    const int result = pthread_setaffinity_np(pthread_self(), sizeof(cpu_set_t), &cpuSet);
+    if(result != 0) {
+        EOBI_WARN() << "Shard failed to pin thread - shardId=" << _shardId << ", cpuCore=" << _cpuCore << ", error=" << result;
+    }
+}
+
+}//end namespace
@@ -3,15 +3,24 @@
 
 #include "mx_common.h"
 #include "mx_message_definitions.h"
+#include "mx_msg_types.h"
 #include "mx_header.h"
 #include "mx_price_indicator_markers.h"
 #include "mx_recovery_handler.h"
 #include "mx_outright_info.h"
 #include "mx_orderbook.h"
+#include "mx_instruments.h"
+#include "mx_descriptors.h"
+#include "common/packet_ring.h"
+#include "mx_sequence_bitmap.h"
+#include "mx_gap_set.h"
+#include "mx_replay_compactor.h"
+#include "mx_definition_cache.h"
+#include "common/event_batch.h"
+#include "mx_framing.h"
 
 #include <algorithm>
 #include <ostream>
-#include <unordered_set>
 #include <unordered_map>
 
 
@@ -37,7 +46,13 @@ public:
             const std::string& recoveryPassword,
             const std::string& recoveryLine,
             const int recoveryTimeout,
-            const int recoveryPageSize);
+            const int recoveryPageSize,
+            const PacketRingConfig& bufferConfig = PacketRingConfig(),
+            const int recoveryPagesInFlight = 1,
+            const bool compactStartupReplay = false,
+            const std::string& definitionCacheDir = "",
+            const bool dropUndefinedInstrumentEvents = false,
+            const AsyncLogLevel logLevel = AsyncLogLevel::Info);
     void Start();
     void Stop();
     void Post(std::function<void()> fn);
@@ -55,17 +70,28 @@ protected:
 
 private:
     void _OnRealtimePacket(const PacketBufferPtr packetBuffer);
+    char* _OnRealtimeMsgs(char* buffer, const MXFrameIndex& frameIndex);
     void _OnRealTimeMsg(char* msg, bool isReplay = false);
-    void _ProcessBufferedMsgs(); 
+    using MsgHandlerFn = void (*)(MX_Channel& self, char* msgPtr);
+    template<typename MsgT>
+    static void _DispatchMsg(MX_Channel& self, char* msgPtr);
+    template<typename MsgT>
+    static void _CompactMsg(MX_Channel& self, char* msgPtr);
+    void _ApplyRetransmissionMsg(char* msg);
+    void _ApplyHeldMsgs(const bool overHoles);
+    bool _CompactReplayMsg(char* msg);
+    void _ApplyCompactedMsgs();
+    bool _ProcessBufferedMsgs();
 
     template<typename MsgT>
-    Descriptor_t _GetIndesc(const MsgT* msg);
+    MXInstrumentState& _GetInstrument(const MsgT* msg);
 
     template<typename MsgT>
-    void _InitMarketEvent(const MsgT* msg, MarketEvent& event);
+    void _InitMarketEvent(const MsgT* msg, MXInstrumentState& instrument, MarketEvent& event);
 
     template<typename InstrumentKeysMsgT>
-    void _CacheGroupInfo(const InstrumentKeysMsgT* msg);
+    void _CacheGroupInfo(const InstrumentKeysMsgT* msg, const MXInstrumentHandle handle);
+    void _AddToGroup(const MXInstrumentHandle handle, const std::string& group, const bool isStrategy);
 
     template<typename MarketDepthMsgT>
     void _ProcessMarketDepthMsg(const MarketDepthMsgT* msg);
@@ -86,14 +112,14 @@ private:
                                             const MarketUpdateAction updateAction,
                                             const int level);
     template<typename MarketDepthMsgT>
-    void _HandleStatusUpdate(const MarketDepthMsgT* msg);
+    void _HandleStatusUpdate(const MarketDepthMsgT* msg, MXInstrumentState& instrument);
     template<typename MarketDepthMsgT>
-    void _HandleTheoreticalOpeningUpdate(const MarketDepthMsgT* msg);
+    void _HandleTheoreticalOpeningUpdate(const MarketDepthMsgT* msg, MXInstrumentState& instrument);
 
     template<typename SummaryMsgT>
     void _ProcessSummaryMsg(const SummaryMsgT* msg);
     template<typename SummaryMsgT>
-    void _HandleSettlementUpdate(const SummaryMsgT* msg, MarketEvent& event);
+    void _HandleSettlementUpdate(const SummaryMsgT* msg, const MXInstrumentState& instrument, MarketEvent& event);
     void _Process(const FuturesSummary* msg);
     void _Process(const OptionSummary* msg);
     void _Process(const FutureOptionsSummary* msg);
@@ -107,9 +133,8 @@ private:
     void _Process(const StrategyTrade* msg);
 
     template<typename InstrumentKeysMsgT>
-    bool _OnInstrumentKeysMsg(const InstrumentKeysMsgT* msg, InstrumentDefinition& defn, bool& usesTickTable, std::string& tickTableName, const bool isOption = false);
-    template<typename InstrumentKeysMsgT>
-    void _CompleteInstrumentSetup(const InstrumentKeysMsgT* msg, const InstrumentDefinition& defn);
+    bool _OnInstrumentKeysMsg(const InstrumentKeysMsgT* msg, MXInstrumentState& instrument, InstrumentDefinition& defn, bool& usesTickTable, std::string& tickTableName, const bool isOption = false);
+    void _CompleteInstrumentSetup(MXInstrumentState& instrument, const InstrumentDefinition& defn);
    
     void _Process(const FuturesInstrumentKeys* msg);
     void _Process(const OptionInstrumentKeys* msg);
@@ -137,12 +162,19 @@ private:
 
     void _Process(const GroupStatus* msg);
     void _Process(const GroupStatusStrategies* msg);
-    void _UpdateGroupStatus(const std::unordered_map<std::string, std::vector<std::string>>& map, 
+    void _UpdateGroupStatus(const std::unordered_map<std::string, std::vector<MXInstrumentHandle>>& map, 
                             const std::string& group, 
                             const char status, 
                             const std::string& log);
-    void _CacheInstrumentStatus(const std::string& identifier, const char status);
-    void _CacheInstrumentDefn(const std::string& identifier, const InstrumentDefinition& defn);
+    void _CacheInstrumentStatus(MXInstrumentState& instrument, const char status);
+    void _CacheInstrumentDefn(MXInstrumentState& instrument, const InstrumentDefinition& defn);
+
+    //Definition cache
+    std::string _GetDefinitionCachePath() const;
+    bool _IsCachedDefinition(const MsgHeader* header) const;
+    void _RestoreDefinitions();
+    bool _RestoreInstrument(const MXDefinitionCache& cache, const MXCachedInstrument& cached);
+    void _SaveDefinitions();
 
     void _Process(const FutureDeliverables* msg);
     void _Process(const TickTable* msg);
@@ -170,7 +202,15 @@ private:
     bool _LegsAvailable(const std::vector<std::string>& legs) const;
     CurrencyCode::Value _ToCurrencyCode(const std::string& currency) const;
     InstrumentStatus::Value _GetStatus(const char status) const;
+    void _BufferRealtimePacket(const MessageMeta& mm, const uint64_t seqNum, const uint64_t lastSeqNum);
+    void _RequestNextGap();
+    void _PostGapRequest(const uint64_t from, const uint64_t to);
+    void _OnGapRecovered();
+    void _CatchUp();
+    void _PostCatchUp();
     void _CompleteRecovery();
+    void _RestartRecovery(const MessageMeta& mm, const uint64_t seqNum, const uint64_t lastSeqNum);
+    bool _RequestMissing();
     void _ResetBook(const Descriptor_t indesc) const;
     bool _IsStartupRetransmission() const;
 
@@ -188,33 +228,36 @@ private:
     int _GetCurrentYear() const;
     int _DecodeYear(const int year) const;
 
+    Descriptor_t _GetDescriptor(MXInstrumentState& instrument);
     void _SendMarketEvent(MarketEvent& event) const;
     void _SendMarketEventEnd(MarketEvent& event) const;
     void _SendEndForChannel();
 
-    void _SanityCheck(const PacketBufferPtr packetBuffer);
-    uint16_t _GetMessageCount(const PacketBufferPtr& packetBuffer, std::string& types) const;
+    void _SanityCheck(char* buffer, const MXFrameIndex& frameIndex);
+    std::string _GetMessageTypes(char* buffer, const MXFrameIndex& frameIndex) const;
 
   
 
     //Data members
     IAdapterSend* _sendApi = nullptr;
+    mutable EventBatch _eventBatch;     //incremental events of the packet being decoded
+    MXFrameIndex _frameIndex;             //message offsets of the packet being decoded
     MulticastFeedPtrT _realtimeFeed;
     WorkerThreadPtr _workerThread;
     WorkerThreadPtr _networkThread;
 
-    std::deque<MessageMeta> _bufferedRealtimeMsgs;
-    std::unordered_map<std::string, int> _decimals;
-    std::unordered_map<std::string, char> _cachedStatusMarkerPerInstrument;
-    std::unordered_map<std::string, std::vector<std::string>> _outrightGroupToDescs, _strategyGroupToDescs;
+    PacketRing _bufferedRealtimeMsgs;
+    std::unordered_map<std::string, std::vector<MXInstrumentHandle>> _outrightGroupToDescs, _strategyGroupToDescs;
     std::unordered_map<std::string, OutrightInfo> _outrights;
-    MXOrderbooks _orderbooks;
     //ID to Ticktable
     std::unordered_map<std::string, TickTable_t> _tickTables;
-    std::set<Descriptor_t> _securityIds;
-    //Identifier to instr defn
-    std::unordered_map<std::string, InstrumentDefinition> _instruments;
-    std::unordered_set<uint64_t> _recoverySequenceNumbers;
+    //Decimals, status, book and defn per instrument, keyed by the wire identifier
+    MXInstruments _instruments;
+    MXDescriptorRegistry _descriptors;
+    MXSequenceBitmap _recoveredSequences;   //over [_fromSeq, _toSeq]
+    MXMsgStash _heldRetransmissionMsgs;     //recovered past a hole, waiting for it to be filled
+    MXGapSet _missingSequences;             //not applied nor buffered yet, this recovery
+    MXReplayCompactor _replayCompactor;     //latest depth and summary per instrument, startup replay only
 
     uint64_t _lastRealtimeSequence = 0; //StartOfDay is always with 1
     bool _inRecovery = false;
@@ -223,11 +266,31 @@ private:
     MXRecoveryHandler<MX_Channel> _mxRecoveryHandler;
     uint64_t _fromSeq = 0;
     uint64_t _toSeq = 0;
+    uint64_t _lastBufferedSequence = 0;     //last seqNum of the last buffered packet
+    bool _recoveryLostMsgs = false;         //a range was given up with holes, this recovery
+    uint32_t _holeRequests = 0;             //re-requests of missing sub ranges, this recovery
+    static constexpr uint32_t MAX_HOLE_REQUESTS = 8;
+    bool _gapInFlight = false;              //[_fromSeq, _toSeq] requested, not done yet
+    uint64_t _gapRequests = 0;              //posted gap requests, the latest one is issued
+    bool _gapRequestPending = false;        //posted, not issued yet - the session in progress is a stale one
+    bool _catchUpPosted = false;
+    static constexpr uint32_t CATCH_UP_PACKETS = 512;  //buffered packets released per worker turn
+    bool _isStartupRetransmission = false;
     std::string _recoveryUsername;
     std::string _recoveryPassword;
     std::string _recoveryLine;
     int _recoveryTimeout;
     int _recoveryPageSize;
+    int _recoveryPagesInFlight;
+    bool _compactStartupReplay = false;   //last value compaction of the startup replay, opt-in
+    bool _compactingReplay = false;       //up to the first catch up of the startup recovery
+    std::string _definitionCacheDir;        //empty - no definition cache
+    bool _dropUndefinedInstrumentEvents = false;    //events of instruments without a definition, opt-in
+    std::string _businessDate;              //from StartOfDay
+    uint64_t _cachedDefinitionsTo = 0;      //definition msgs up to this seqNum were restored from the cache
+    uint64_t _restoredDefinitionsTo = 0;    //the same for the restored instruments only, when some were missing
+    bool _definitionsChanged = false;       //since the cache was read
+    std::unordered_map<std::string, std::string> _tickTableMsgs;    //latest TT msg per short name, as received
 
     const ChannelID_t _channelId;
     ChannelTags _tags;
@@ -236,7 +299,10 @@ private:
     PacketBufferPoolPtr_t _bufferPool;
     TraceLoggerArray_t _loggers;
 
-    
+    //Realtime msg handlers indexed by GetMXMsgTypeIndex(msgType)
+    static const MXDispatchTable<MsgHandlerFn> _realtimeHandlers;
+    //Startup replay msgs folded into _replayCompactor instead
+    static const MXDispatchTable<MsgHandlerFn> _compactionHandlers;
 }; //end class definition
 
 typedef std::shared_ptr<MX_Channel> MX_ChannelPtrT;
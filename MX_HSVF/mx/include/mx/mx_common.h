@@ -8,10 +8,17 @@ namespace ns {
 constexpr char STX = 0x02;
 constexpr char ETX = 0x03;
 
-unsigned constexpr consthash(char const *input, unsigned hash = 5381) {
-    return *input ?
-        consthash(input + 1, hash * 33 + static_cast<unsigned>(*input)): 
-        hash;
+/** msgType field as a 16 bit value - first char in the low byte, second in the high byte.
+    One char types are space padded on the wire, MXMsgTypeCode("H") == MXMsgTypeCode('H', ' ')
+*/
+constexpr uint16_t MXMsgTypeCode(const char first, const char second) {
+    return static_cast<uint16_t>(static_cast<uint8_t>(first) | (static_cast<uint8_t>(second) << 8));
+}
+
+template<size_t N>
+constexpr uint16_t MXMsgTypeCode(const char (&msgType)[N]) {
+    static_assert(N == 2 || N == 3, "HSVF msg types are one or two chars");
+    return MXMsgTypeCode(msgType[0], N == 3 ? msgType[1] : ' ');
 }
 
 inline std::string GetString(std::string input) {
@@ -96,23 +103,40 @@ inline int GetDecimalsToPrecision(const int decimals) {
     }
 }
 
-inline void AdjustPrice(const std::string& identifier, const char fractionIndicator, int64_t& price, const std::unordered_map<std::string, int>& map) {
-    auto it = map.find(identifier);
-    if(std::end(map) == it){
-        //noop if we cannot find it in the map
-        return;
+/** Instrument decimals vs the decimals of a price field, resolved once per instrument. Indexed by the fraction
+    indicator decimals ('0'-'9' or 'A'-'J'): a positive factor multiplies the price, a negative one divides it.
+    Default constructed it leaves prices as they are
+*/
+class MXPriceScale {
+public:
+    static constexpr int MAX_DECIMALS = 10;
+
+    MXPriceScale() {
+        for(int i = 0; i < MAX_DECIMALS; ++i) {
+            _factors[i] = 1;
+        }
     }
 
-    const int instrumentDecimals = it->second;
-    const int msgDecimals = isalpha(fractionIndicator) ? fractionIndicator - 'A' : fractionIndicator - '0';
-    const int diff = instrumentDecimals - msgDecimals;
+    explicit MXPriceScale(const int instrumentDecimals) {
+        for(int msgDecimals = 0; msgDecimals < MAX_DECIMALS; ++msgDecimals) {
+            const int diff = instrumentDecimals - msgDecimals;
+            _factors[msgDecimals] = diff >= 0 ? GetDecimalsToPrecision(diff) : -GetDecimalsToPrecision(-diff);
+        }
+    }
 
-    if(diff > 0) {
-        price = price * GetDecimalsToPrecision(diff);
-    } else if(diff < 0) {
-        price = price / GetDecimalsToPrecision(-diff);
+    void Adjust(const char fractionIndicator, int64_t& price) const {
+        const unsigned msgDecimals = fractionIndicator >= 'A' ? fractionIndicator - 'A' : fractionIndicator - '0';
+        if(msgDecimals >= MAX_DECIMALS) {
+            assert(!"MXPriceScale::Adjust() - unhandled fraction indicator");
+            return;
+        }
+        const int64_t factor = _factors[msgDecimals];
+        price = factor > 0 ? price * factor : price / -factor;
     }
-}
+
+private:
+    int64_t _factors[MAX_DECIMALS];
+};
 
 inline std::string GetMonth(const char monthCode) {
     switch(monthCode) {
@@ -241,22 +265,41 @@ inline uint8_t GetQuarter(const int month) {
 	return 0;
 }
 
-inline DateTime GetExpiryDate(const std::string& expiryDate) {
+//A definition date as decoded from the wire, before it becomes a DateTime - kept so it can be cached
+struct MXDate {
+    int year = 0;
+    int month = 0;
+    int day = 0;
+};
+
+inline DateTime ToDateTime(const MXDate& date) {
+    return DateTime(date.month, date.day, date.year);
+}
+
+inline MXDate DecodeExpiryDate(const std::string& expiryDate) {
     //expiryDate=240816
     assert(expiryDate.size() == 6);
     const int expiryYear = std::stoi(expiryDate.substr(0 ,2)) + 2000;
     const int expiryMonth = std::stoi(expiryDate.substr(2, 2));
     const int expiryDay = std::stoi(expiryDate.substr(4, 2));
-    return DateTime(expiryMonth, expiryDay, expiryYear);
+    return MXDate{expiryYear, expiryMonth, expiryDay};
 }
 
-inline DateTime GetLTD(const std::string& lastTradingDate) {
+inline MXDate DecodeLTD(const std::string& lastTradingDate) {
     //ltd=20250321
     assert(lastTradingDate.size() == 8);
     const int expiryYear = std::stoi(lastTradingDate.substr(0 ,4));
     const int expiryMonth = std::stoi(lastTradingDate.substr(4, 2));
     const int expiryDay = std::stoi(lastTradingDate.substr(6, 2));
-    return DateTime(expiryMonth, expiryDay, expiryYear);
+    return MXDate{expiryYear, expiryMonth, expiryDay};
+}
+
+inline DateTime GetExpiryDate(const std::string& expiryDate) {
+    return ToDateTime(DecodeExpiryDate(expiryDate));
+}
+
+inline DateTime GetLTD(const std::string& lastTradingDate) {
+    return ToDateTime(DecodeLTD(lastTradingDate));
 }
 
 
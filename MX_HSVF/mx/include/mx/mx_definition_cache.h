@@ -0,0 +1,400 @@
+#ifndef _MX_DEFINITION_CACHE_H_
+#define _MX_DEFINITION_CACHE_H_
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <string>
+#include <vector>
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include "mx_common.h"
+#include "mx_instrument_key.h"
+
+namespace ns {
+
+/** On disk records of the MX definition cache. Plain data, strings are offset/length pairs into the
+    string section at the end of the file. Any layout change bumps MX_DEFINITION_CACHE_VERSION
+*/
+constexpr uint32_t MX_DEFINITION_CACHE_VERSION = 1;
+
+struct MXCachedString {
+    uint32_t offset = 0;
+    uint32_t len = 0;
+};
+
+struct MXCachedDate {
+    int32_t year = 0;
+    int32_t month = 0;
+    int32_t day = 0;
+    int32_t padding = 0;
+};
+
+struct MXCachedJsonField {
+    MXCachedString key;
+    MXCachedString value;
+};
+
+struct MXCachedLeg {
+    MXCachedString securityId;
+    int64_t side = 0;
+    double ratioQtyNumerator = 0.0;
+    int64_t ratioQtyDenominator = 0;
+};
+
+//An instrument as the instrument keys msg left it - its InstrumentDefinition plus what the channel keeps beside it
+struct MXCachedInstrument {
+    MXInstrumentKey key;
+    int64_t productType = 0;
+    int64_t currencyCode = 0;
+    int64_t termType = 0;
+    int64_t securityExchange = 0;
+    int64_t priceDisplayType = 0;
+    int64_t syntheticFlags = 0;
+    int64_t persistenceFlags = 0;
+    int64_t tickSizeNumerator = 0;
+    int64_t tickValueNumerator = 0;
+    int32_t decimals = 0;               //instrument decimals, the price scaling
+    int32_t priceFactor = 0;
+    int32_t priceDisplayDecimals = 0;
+    int32_t marketDepth = 0;
+    int32_t impliedDepth = 0;
+    uint8_t isImplieds = 0;
+    uint8_t isStrategy = 0;
+    uint8_t isOption = 0;
+    uint8_t padding = 0;
+    MXCachedDate expiration;
+    MXCachedDate lastTradeDt;
+    MXCachedDate expiryDate;
+    MXCachedString seriesKey;
+    MXCachedString instrumentName;
+    MXCachedString productSymbol;
+    MXCachedString exchangeTicker;
+    MXCachedString securityId;
+    MXCachedString group;
+    MXCachedString tickTableName;
+    MXCachedString currency;
+    uint32_t firstJsonField = 0;
+    uint32_t jsonFields = 0;
+    uint32_t firstLeg = 0;
+    uint32_t legs = 0;
+};
+
+struct MXDefinitionCacheHeader {
+    char magic[8];
+    uint32_t version;
+    uint32_t headerSize;
+    uint32_t instrumentSize;            //record sizes, a build with another layout rejects the file
+    uint32_t legSize;
+    char businessDate[8];
+    uint64_t lastSequence;              //definitions up to this seqNum are in the file
+    uint64_t fileSize;
+    uint32_t tickTables;
+    uint32_t instruments;
+    uint32_t jsonFields;
+    uint32_t legs;
+    uint64_t tickTablesOffset;
+    uint64_t instrumentsOffset;
+    uint64_t jsonFieldsOffset;
+    uint64_t legsOffset;
+    uint64_t stringsOffset;
+    uint64_t stringBytes;
+};
+
+static_assert(sizeof(MXDefinitionCacheHeader) % alignof(MXCachedInstrument) == 0, "MXDefinitionCacheHeader - the sections after it would be misaligned");
+
+constexpr char MX_DEFINITION_CACHE_MAGIC[8] = {'M', 'X', 'D', 'E', 'F', 'S', '\0', '\0'};
+
+//Sections start on the strictest record alignment
+inline uint64_t AlignMXCacheSection(const uint64_t offset) {
+    constexpr uint64_t ALIGNMENT = alignof(MXCachedInstrument);
+    return (offset + ALIGNMENT - 1) / ALIGNMENT * ALIGNMENT;
+}
+
+/** Collects the records of one business date and writes them out in one go - to a temporary file renamed over the
+    previous one, so a reader never maps a half written cache
+*/
+class MXDefinitionCacheWriter {
+public:
+    //A TT msg as received, up to its ETX
+    void AddTickTable(const std::string& msg) {
+        _tickTables.push_back(AddString(msg));
+    }
+
+    //Fill in the record, then the json fields and legs of that same instrument
+    MXCachedInstrument& AddInstrument() {
+        _instruments.emplace_back();
+        MXCachedInstrument& instrument = _instruments.back();
+        instrument.firstJsonField = static_cast<uint32_t>(_jsonFields.size());
+        instrument.firstLeg = static_cast<uint32_t>(_legs.size());
+        return instrument;
+    }
+
+    void AddJsonField(const std::string& key, const std::string& value) {
+        _jsonFields.push_back({AddString(key), AddString(value)});
+        ++_instruments.back().jsonFields;
+    }
+
+    MXCachedLeg& AddLeg() {
+        _legs.emplace_back();
+        ++_instruments.back().legs;
+        return _legs.back();
+    }
+
+    MXCachedString AddString(const std::string& str) {
+        MXCachedString cached;
+        cached.offset = static_cast<uint32_t>(_strings.size());
+        cached.len = static_cast<uint32_t>(str.size());
+        _strings.insert(std::end(_strings), std::begin(str), std::end(str));
+        return cached;
+    }
+
+    static MXCachedDate ToCachedDate(const MXDate& date) {
+        MXCachedDate cached;
+        cached.year = date.year;
+        cached.month = date.month;
+        cached.day = date.day;
+        return cached;
+    }
+
+    bool Write(const std::string& path, const std::string& businessDate, const uint64_t lastSequence) const {
+        MXDefinitionCacheHeader header;
+        std::memset(&header, 0, sizeof(header));
+        std::memcpy(header.magic, MX_DEFINITION_CACHE_MAGIC, sizeof(header.magic));
+        header.version = MX_DEFINITION_CACHE_VERSION;
+        header.headerSize = sizeof(MXDefinitionCacheHeader);
+        header.instrumentSize = sizeof(MXCachedInstrument);
+        header.legSize = sizeof(MXCachedLeg);
+        std::memcpy(header.businessDate, businessDate.data(), std::min(businessDate.size(), sizeof(header.businessDate)));
+        header.lastSequence = lastSequence;
+        header.tickTables = static_cast<uint32_t>(_tickTables.size());
+        header.instruments = static_cast<uint32_t>(_instruments.size());
+        header.jsonFields = static_cast<uint32_t>(_jsonFields.size());
+        header.legs = static_cast<uint32_t>(_legs.size());
+        header.tickTablesOffset = sizeof(header);
+        header.instrumentsOffset = AlignMXCacheSection(header.tickTablesOffset + _tickTables.size() * sizeof(MXCachedString));
+        header.jsonFieldsOffset = header.instrumentsOffset + _instruments.size() * sizeof(MXCachedInstrument);
+        header.legsOffset = header.jsonFieldsOffset + _jsonFields.size() * sizeof(MXCachedJsonField);
+        header.stringsOffset = header.legsOffset + _legs.size() * sizeof(MXCachedLeg);
+        header.stringBytes = _strings.size();
+        header.fileSize = header.stringsOffset + header.stringBytes;
+
+        const std::string tmpPath = path + ".tmp";
+        const int fd = ::open(tmpPath.c_str(), O_WRONLY | O_CREAT | O_TRUNC, 0644);
+        if(fd < 0) {
+            return false;
+        }
+        static const char zeros[alignof(MXCachedInstrument)] = {};
+        const size_t tickTablesBytes = _tickTables.size() * sizeof(MXCachedString);
+        const bool written = _WriteAll(fd, &header, sizeof(header))
+                            && _WriteAll(fd, _tickTables.data(), tickTablesBytes)
+                            && _WriteAll(fd, zeros, header.instrumentsOffset - header.tickTablesOffset - tickTablesBytes)
+                            && _WriteAll(fd, _instruments.data(), _instruments.size() * sizeof(MXCachedInstrument))
+                            && _WriteAll(fd, _jsonFields.data(), _jsonFields.size() * sizeof(MXCachedJsonField))
+                            && _WriteAll(fd, _legs.data(), _legs.size() * sizeof(MXCachedLeg))
+                            && _WriteAll(fd, _strings.data(), _strings.size())
+                            && ::fsync(fd) == 0;
+        ::close(fd);
+        if(!written || ::rename(tmpPath.c_str(), path.c_str()) != 0) {
+            ::unlink(tmpPath.c_str());
+            return false;
+        }
+        return true;
+    }
+
+    size_t GetInstrumentsNum() const {
+        return _instruments.size();
+    }
+
+private:
+    static bool _WriteAll(const int fd, const void* data, size_t len) {
+        const char* ptr = static_cast<const char*>(data);
+        while(len > 0) {
+            const ssize_t ret = ::write(fd, ptr, len);
+            if(ret < 0) {
+                return false;
+            }
+            ptr += ret;
+            len -= static_cast<size_t>(ret);
+        }
+        return true;
+    }
+
+    std::vector<MXCachedString> _tickTables;
+    std::vector<MXCachedInstrument> _instruments;
+    std::vector<MXCachedJsonField> _jsonFields;
+    std::vector<MXCachedLeg> _legs;
+    std::vector<char> _strings;
+};
+
+/** Read only mapping of a cache file. Open() checks the version, the record sizes, the business date and that every
+    section lies within the file - the records are then used in place, nothing is parsed
+*/
+class MXDefinitionCache {
+public:
+    MXDefinitionCache() = default;
+    MXDefinitionCache(const MXDefinitionCache&) = delete;
+    MXDefinitionCache& operator=(const MXDefinitionCache&) = delete;
+
+    ~MXDefinitionCache() {
+        Close();
+    }
+
+    //False if there is no usable cache for this business date
+    bool Open(const std::string& path, const std::string& businessDate) {
+        Close();
+        const int fd = ::open(path.c_str(), O_RDONLY);
+        if(fd < 0) {
+            return false;
+        }
+        struct stat st;
+        if(::fstat(fd, &st) != 0 || static_cast<size_t>(st.st_size) < sizeof(MXDefinitionCacheHeader)) {
+            ::close(fd);
+            return false;
+        }
+        void* data = ::mmap(nullptr, st.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+        ::close(fd);
+        if(data == MAP_FAILED) {
+            return false;
+        }
+        _data = static_cast<const char*>(data);
+        _size = st.st_size;
+
+        if(!_IsValid(businessDate)) {
+            Close();
+            return false;
+        }
+        return true;
+    }
+
+    void Close() {
+        if(_data) {
+            ::munmap(const_cast<char*>(_data), _size);
+        }
+        _data = nullptr;
+        _size = 0;
+    }
+
+    bool IsOpen() const {
+        return _data != nullptr;
+    }
+
+    uint64_t GetLastSequence() const {
+        return _Header().lastSequence;
+    }
+
+    template<typename OnTickTableT>
+    void ForEachTickTable(OnTickTableT onTickTable) const {
+        const MXCachedString* tickTables = _Section<MXCachedString>(_Header().tickTablesOffset);
+        for(uint32_t i = 0; i < _Header().tickTables; ++i) {
+            onTickTable(GetString(tickTables[i]));
+        }
+    }
+
+    //onInstrument(const MXCachedInstrument&), in the order the instruments were defined
+    template<typename OnInstrumentT>
+    void ForEachInstrument(OnInstrumentT onInstrument) const {
+        const MXCachedInstrument* instruments = _Section<MXCachedInstrument>(_Header().instrumentsOffset);
+        for(uint32_t i = 0; i < _Header().instruments; ++i) {
+            onInstrument(instruments[i]);
+        }
+    }
+
+    const MXCachedJsonField& GetJsonField(const MXCachedInstrument& instrument, const uint32_t i) const {
+        return _Section<MXCachedJsonField>(_Header().jsonFieldsOffset)[instrument.firstJsonField + i];
+    }
+
+    const MXCachedLeg& GetLeg(const MXCachedInstrument& instrument, const uint32_t i) const {
+        return _Section<MXCachedLeg>(_Header().legsOffset)[instrument.firstLeg + i];
+    }
+
+    std::string GetString(const MXCachedString& str) const {
+        return std::string(_data + _Header().stringsOffset + str.offset, str.len);
+    }
+
+    uint32_t GetInstrumentsNum() const {
+        return _Header().instruments;
+    }
+
+    static MXDate ToDate(const MXCachedDate& cached) {
+        return MXDate{cached.year, cached.month, cached.day};
+    }
+
+private:
+    const MXDefinitionCacheHeader& _Header() const {
+        return *reinterpret_cast<const MXDefinitionCacheHeader*>(_data);
+    }
+
+    template<typename RecordT>
+    const RecordT* _Section(const uint64_t offset) const {
+        return reinterpret_cast<const RecordT*>(_data + offset);
+    }
+
+    bool _IsValid(const std::string& businessDate) const {
+        const MXDefinitionCacheHeader& header = _Header();
+        if(std::memcmp(header.magic, MX_DEFINITION_CACHE_MAGIC, sizeof(header.magic)) != 0
+            || header.version != MX_DEFINITION_CACHE_VERSION
+            || header.headerSize != sizeof(MXDefinitionCacheHeader)
+            || header.instrumentSize != sizeof(MXCachedInstrument)
+            || header.legSize != sizeof(MXCachedLeg)
+            || header.fileSize != _size
+            || businessDate.size() != sizeof(header.businessDate)
+            || std::memcmp(header.businessDate, businessDate.data(), sizeof(header.businessDate)) != 0) {
+            return false;
+        }
+
+        //Sections back to back, in file order, the strings last
+        const bool sectionsFit = header.tickTablesOffset == sizeof(MXDefinitionCacheHeader)
+            && header.instrumentsOffset == AlignMXCacheSection(header.tickTablesOffset + uint64_t(header.tickTables) * sizeof(MXCachedString))
+            && header.jsonFieldsOffset == header.instrumentsOffset + uint64_t(header.instruments) * sizeof(MXCachedInstrument)
+            && header.legsOffset == header.jsonFieldsOffset + uint64_t(header.jsonFields) * sizeof(MXCachedJsonField)
+            && header.stringsOffset == header.legsOffset + uint64_t(header.legs) * sizeof(MXCachedLeg)
+            && header.stringsOffset + header.stringBytes == _size;
+        if(!sectionsFit) {
+            return false;
+        }
+
+        //Every reference stays inside its section
+        const auto stringFits = [&](const MXCachedString& str) {
+            return uint64_t(str.offset) + str.len <= header.stringBytes;
+        };
+        bool valid = true;
+        const MXCachedString* tickTables = _Section<MXCachedString>(header.tickTablesOffset);
+        for(uint32_t i = 0; i < header.tickTables; ++i) {
+            valid &= stringFits(tickTables[i]);
+        }
+        const MXCachedJsonField* jsonFields = _Section<MXCachedJsonField>(header.jsonFieldsOffset);
+        for(uint32_t i = 0; i < header.jsonFields; ++i) {
+            valid &= stringFits(jsonFields[i].key) && stringFits(jsonFields[i].value);
+        }
+        const MXCachedLeg* legs = _Section<MXCachedLeg>(header.legsOffset);
+        for(uint32_t i = 0; i < header.legs; ++i) {
+            valid &= stringFits(legs[i].securityId);
+        }
+        ForEachInstrument([&](const MXCachedInstrument& instrument) {
+            valid &= uint64_t(instrument.firstJsonField) + instrument.jsonFields <= header.jsonFields
+                    && uint64_t(instrument.firstLeg) + instrument.legs <= header.legs
+                    && stringFits(instrument.seriesKey)
+                    && stringFits(instrument.instrumentName)
+                    && stringFits(instrument.productSymbol)
+                    && stringFits(instrument.exchangeTicker)
+                    && stringFits(instrument.securityId)
+                    && stringFits(instrument.group)
+                    && stringFits(instrument.tickTableName)
+                    && stringFits(instrument.currency);
+        });
+        return valid;
+    }
+
+    const char* _data = nullptr;
+    size_t _size = 0;
+};
+
+}//end namespace
+
+#endif
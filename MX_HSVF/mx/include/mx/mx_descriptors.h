@@ -0,0 +1,92 @@
+#ifndef _MX_DESCRIPTORS_H_
+#define _MX_DESCRIPTORS_H_
+
+#include <cstdint>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+#include "mx_instruments.h"
+#include "mx_log.h"
+
+namespace ns {
+
+//djb2 of the identifier, the descriptor the channel always published - downstream keys books and caches on it
+inline uint32_t HashMXIdentifier(const std::string& identifier) {
+    uint32_t hash = 5381;
+    for(const char c : identifier) {
+        hash = hash * 33 + static_cast<uint32_t>(c);
+    }
+    return hash;
+}
+
+/** Instrument descriptors, assigned once per instrument and cached in its state.
+    The descriptor is the identifier hash, the same one for the instrument across restarts and business days.
+    Two identifiers hashing alike are no longer merged into one book - the later one gets the hash with a probe count
+    in the upper 32 bits, stable as long as the colliding instruments show up in the same order, warned about
+*/
+class MXDescriptorRegistry {
+public:
+    //Returns the descriptor already owned by the instrument, or assigns it one
+    Descriptor_t Assign(MXInstrumentState& instrument, const MXInstrumentHandle handle) {
+        if(instrument.HasDescriptor()) {
+            assert(Find(instrument.indesc) == handle);
+            return instrument.indesc;
+        }
+
+        const Descriptor_t hash = HashMXIdentifier(instrument.identifier);
+        Descriptor_t indesc = hash;
+        for(Descriptor_t probe = 1; indesc == MXInstrumentState::NO_DESCRIPTOR || _entries.count(indesc); ++probe) {
+            indesc = hash | (probe << 32);
+        }
+        if(indesc != hash) {
+            MX_WARN() << "Descriptor collision - identifier=" << instrument.identifier << ", hash=" << hash << ", indesc=" << indesc;
+        }
+
+        _entries.emplace(indesc, Entry{handle, false});
+        instrument.indesc = indesc;
+        return instrument.indesc;
+    }
+
+    //Assign() for an instrument whose definition was processed, true the first time
+    bool Define(MXInstrumentState& instrument, const MXInstrumentHandle handle) {
+        Entry& entry = _entries[Assign(instrument, handle)];
+        if(entry.defined) {
+            return false;
+        }
+        entry.defined = true;
+        _defined.push_back(instrument.indesc);
+        return true;
+    }
+
+    //MX_NO_HANDLE for descriptors this registry did not assign
+    MXInstrumentHandle Find(const Descriptor_t indesc) const {
+        auto it = _entries.find(indesc);
+        return it == std::end(_entries) ? MX_NO_HANDLE : it->second.handle;
+    }
+
+    //Defined instruments only, in definition order
+    template<typename OnDescriptorT>
+    void ForEach(OnDescriptorT onDescriptor) const {
+        for(const Descriptor_t indesc : _defined) {
+            onDescriptor(indesc, _entries.at(indesc).handle);
+        }
+    }
+
+    size_t GetSize() const {
+        return _defined.size();
+    }
+
+private:
+    struct Entry {
+        MXInstrumentHandle handle;
+        bool defined;
+    };
+
+    std::unordered_map<Descriptor_t, Entry> _entries;
+    std::vector<Descriptor_t> _defined;
+};
+
+}//end namespace
+
+#endif
@@ -0,0 +1,104 @@
+#ifndef _MX_FRAMING_H_
+#define _MX_FRAMING_H_
+
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+
+#if defined(__AVX2__) || defined(__SSE2__)
+#include <immintrin.h>
+#endif
+
+#include "mx_common.h"
+
+namespace ns {
+
+/** Calls onEtx(offset) for every ETX byte of buffer, in order.
+    HSVF is plain ASCII so ETX only ever shows up as a message terminator - one vector compare per 32/16 bytes
+    replaces the per message std::find
+*/
+template<typename OnEtxT>
+inline void ForEachMXEtx(const char* buffer, const size_t len, OnEtxT onEtx) {
+    size_t offset = 0;
+#if defined(__AVX2__)
+    const __m256i etx = _mm256_set1_epi8(ETX);
+    for(; offset + 32 <= len; offset += 32) {
+        const __m256i chunk = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(buffer + offset));
+        uint32_t mask = static_cast<uint32_t>(_mm256_movemask_epi8(_mm256_cmpeq_epi8(chunk, etx)));
+        while(mask) {
+            onEtx(offset + __builtin_ctz(mask));
+            mask &= mask - 1;
+        }
+    }
+#endif
+#if defined(__SSE2__)
+    const __m128i etx16 = _mm_set1_epi8(ETX);
+    for(; offset + 16 <= len; offset += 16) {
+        const __m128i chunk = _mm_loadu_si128(reinterpret_cast<const __m128i*>(buffer + offset));
+        uint32_t mask = static_cast<uint32_t>(_mm_movemask_epi8(_mm_cmpeq_epi8(chunk, etx16)));
+        while(mask) {
+            onEtx(offset + __builtin_ctz(mask));
+            mask &= mask - 1;
+        }
+    }
+#endif
+    for(; offset < len; ++offset) {
+        if(buffer[offset] == ETX) {
+            onEtx(offset);
+        }
+    }
+}
+
+/** Message boundaries of one HSVF packet, built with a single pass over the buffer.
+    Message i spans [offsets[i], offsets[i + 1]) including its STX/ETX, offsets[count] is the end of the last one
+*/
+struct MXFrameIndex {
+    static constexpr size_t MAX_MSGS = 256;
+
+    uint32_t offsets[MAX_MSGS + 1];
+    uint32_t count = 0;
+    bool valid = false;
+
+    //Body of message i, past the STX - what the MsgHeader casts expect
+    char* GetMsg(char* buffer, const uint32_t i) const {
+        return buffer + offsets[i] + sizeof(STX);
+    }
+
+    uint32_t GetEnd() const {
+        return offsets[count];
+    }
+};
+
+//Returns false when the packet is not a clean run of STX...ETX messages or has more than MAX_MSGS of them
+inline bool BuildMXFrameIndex(const char* buffer, const size_t len, MXFrameIndex& index) {
+    index.count = 0;
+    index.offsets[0] = 0;
+    index.valid = false;
+
+    bool framed = len > 0;
+    ForEachMXEtx(buffer, len, [&](const size_t etxOffset) {
+        if(!framed) {
+            return;
+        }
+        const uint32_t begin = index.offsets[index.count];
+        if(index.count == MXFrameIndex::MAX_MSGS || buffer[begin] != STX) {
+            framed = false;
+            return;
+        }
+        index.offsets[++index.count] = static_cast<uint32_t>(etxOffset + 1);
+    });
+
+    //Trailing bytes without an ETX
+    index.valid = framed && index.count > 0 && index.GetEnd() == len;
+    return index.valid;
+}
+
+inline uint32_t CountMXMsgs(const char* buffer, const size_t len) {
+    uint32_t count = 0;
+    ForEachMXEtx(buffer, len, [&count](const size_t) { ++count; });
+    return count;
+}
+
+}//end namespace
+
+#endif
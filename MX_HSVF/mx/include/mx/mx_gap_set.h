@@ -0,0 +1,103 @@
+#ifndef _MX_GAP_SET_H_
+#define _MX_GAP_SET_H_
+
+#include <algorithm>
+#include <cstdint>
+#include <iterator>
+#include <map>
+#include <utility>
+
+namespace ns {
+
+/** Ordered set of the sequence ranges still missing during a recovery. Ranges are disjoint and never adjacent -
+    Add() merges, Remove() splits. A handful of ranges at most, one per loss seen while buffering
+*/
+class MXGapSet {
+public:
+    using Range = std::pair<uint64_t, uint64_t>;    //[from, to]
+
+    void Clear() {
+        _ranges.clear();
+    }
+
+    void Add(uint64_t from, uint64_t to) {
+        if(from > to) {
+            return;
+        }
+
+        //First range that could touch [from, to] - the one before it ends earlier than from - 1
+        auto it = _ranges.upper_bound(from);
+        if(it != std::begin(_ranges) && std::prev(it)->second + 1 >= from) {
+            --it;
+        }
+        while(it != std::end(_ranges) && it->first <= to + 1) {
+            from = std::min(from, it->first);
+            to = std::max(to, it->second);
+            it = _ranges.erase(it);
+        }
+        _ranges.emplace(from, to);
+    }
+
+    void Remove(const uint64_t from, const uint64_t to) {
+        if(from > to) {
+            return;
+        }
+
+        auto it = _ranges.upper_bound(from);
+        if(it != std::begin(_ranges) && std::prev(it)->second >= from) {
+            --it;
+        }
+        while(it != std::end(_ranges) && it->first <= to) {
+            const Range range = *it;
+            it = _ranges.erase(it);
+            if(range.first < from) {
+                _ranges.emplace(range.first, from - 1);
+            }
+            if(range.second > to) {
+                _ranges.emplace(to + 1, range.second);
+                break;
+            }
+        }
+    }
+
+    bool Contains(const uint64_t seqNum) const {
+        auto it = _ranges.upper_bound(seqNum);
+        return it != std::begin(_ranges) && std::prev(it)->second >= seqNum;
+    }
+
+    bool Empty() const {
+        return _ranges.empty();
+    }
+
+    /** The first range, extended over the ranges after it that are closer than mergeDistance - re-fetching a few
+        buffered msgs costs less than one more retransmission session. Not to be called on an empty set
+    */
+    Range GetNextRequest(const uint64_t mergeDistance) const {
+        auto it = std::begin(_ranges);
+        Range request = *it;
+        for(++it; it != std::end(_ranges) && it->first - request.second - 1 <= mergeDistance; ++it) {
+            request.second = it->second;
+        }
+        return request;
+    }
+
+    size_t GetRanges() const {
+        return _ranges.size();
+    }
+
+    //Sequence numbers missing over all the ranges
+    uint64_t GetMissing() const {
+        uint64_t missing = 0;
+        for(const auto& range : _ranges) {
+            missing += range.second - range.first + 1;
+        }
+        return missing;
+    }
+
+private:
+    std::map<uint64_t, uint64_t> _ranges;   //from -> to
+};
+
+}//end namespace
+
+#endif
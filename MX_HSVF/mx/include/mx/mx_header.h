@@ -2,27 +2,19 @@
 #define _MX_HEADER_
 
 #include "mx_message_definitions.h"
+#include "mx_framing.h"
 
 namespace ns {
 
+//Only the first header is parsed, the message count is the number of ETX bytes
 inline SequenceMeta MXPacketSequenceGetter(const PacketBufferPtr& packetBuffer) {
     char* readPtr = packetBuffer->m_buffer;
     const uint32_t bytesReceived = packetBuffer->m_bytesReceived;
+    assert(bytesReceived > 0 && *readPtr == STX && readPtr[bytesReceived - 1] == ETX);
 
-    uint64_t seqNum = 0;
-    uint64_t count = 0;
-    while(readPtr - packetBuffer->m_buffer < bytesReceived) {
-        assert(*readPtr == STX);
-        if(count == 0) {
-            const MsgHeader* header = reinterpret_cast<const MsgHeader*>(readPtr + sizeof(STX));
-            seqNum = header->GetSeqNum();
-        }
-
-        ++count; //We have a msg
-        auto it = std::find(readPtr, packetBuffer->m_buffer + bytesReceived, ETX);
-        assert(*it == ETX && (it != packetBuffer->m_buffer + bytesReceived));
-        readPtr = ++it;
-    }
+    const MsgHeader* header = reinterpret_cast<const MsgHeader*>(readPtr + sizeof(STX));
+    const uint64_t seqNum = header->GetSeqNum();
+    const uint64_t count = CountMXMsgs(readPtr, bytesReceived);
 
     assert(seqNum != 0 && count != 0);
     return SequenceMeta(seqNum, count);
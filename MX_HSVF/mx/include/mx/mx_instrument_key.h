@@ -0,0 +1,81 @@
+#ifndef _MX_INSTRUMENT_KEY_H_
+#define _MX_INSTRUMENT_KEY_H_
+
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <string>
+
+namespace ns {
+
+/** Fixed width instrument key - the wire fields GetIdentifier() concatenates, copied as is and zero padded.
+    Outright identifiers are 11 to 20 chars, strategy symbols 30, so the key is two 16 byte halves.
+    Equality and hashing work on four 8 byte words, no string is ever built
+*/
+struct alignas(16) MXInstrumentKey {
+    static constexpr size_t SIZE = 32;
+    static constexpr size_t WORDS = SIZE / sizeof(uint64_t);
+
+    char bytes[SIZE];
+
+    MXInstrumentKey() {
+        std::memset(bytes, 0, SIZE);
+    }
+
+    template<typename... PartsT>
+    explicit MXInstrumentKey(const PartsT&... parts) {
+        std::memset(bytes, 0, SIZE);
+        size_t len = 0;
+        (_Append(len, parts), ...);
+    }
+
+    uint64_t GetWord(const size_t i) const {
+        uint64_t word;
+        std::memcpy(&word, bytes + i * sizeof(uint64_t), sizeof(word));
+        return word;
+    }
+
+    bool operator==(const MXInstrumentKey& other) const {
+        return std::memcmp(bytes, other.bytes, SIZE) == 0;
+    }
+
+    bool operator!=(const MXInstrumentKey& other) const {
+        return !(*this == other);
+    }
+
+    //Same text GetIdentifier() returns
+    std::string ToString() const {
+        return std::string(bytes, strnlen(bytes, SIZE));
+    }
+
+private:
+    template<size_t N>
+    void _Append(size_t& len, const char (&field)[N]) {
+        static_assert(N <= SIZE, "MXInstrumentKey - field wider than the key");
+        const size_t copied = len + N <= SIZE ? N : SIZE - len;
+        std::memcpy(bytes + len, field, copied);
+        len += copied;
+    }
+
+    void _Append(size_t& len, const char field) {
+        if(len < SIZE) {
+            bytes[len++] = field;
+        }
+    }
+};
+static_assert(sizeof(MXInstrumentKey) == MXInstrumentKey::SIZE, "MXInstrumentKey must stay packed");
+
+struct MXInstrumentKeyHash {
+    size_t operator()(const MXInstrumentKey& key) const {
+        uint64_t hash = 0x9E3779B97F4A7C15ull;
+        for(size_t i = 0; i < MXInstrumentKey::WORDS; ++i) {
+            hash = (hash ^ key.GetWord(i)) * 0xFF51AFD7ED558CCDull;
+            hash ^= hash >> 32;
+        }
+        return static_cast<size_t>(hash);
+    }
+};
+
+}//end namespace
+
+#endif
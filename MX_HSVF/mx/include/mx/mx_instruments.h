@@ -0,0 +1,118 @@
+#ifndef _MX_INSTRUMENTS_H_
+#define _MX_INSTRUMENTS_H_
+
+#include <memory>
+#include <unordered_map>
+#include <vector>
+
+#include "mx_common.h"
+#include "mx_instrument_key.h"
+#include "mx_orderbook.h"
+
+namespace ns {
+
+using MXInstrumentHandle = uint32_t;
+constexpr MXInstrumentHandle MX_NO_HANDLE = UINT32_MAX;
+
+//What the instrument keys msg leaves beside the InstrumentDefinition - with it, enough to rebuild the instrument
+struct MXDefinitionSource {
+    std::string group;                  //root symbol of an outright, instrument group of a strategy
+    std::string tickTableName;          //empty if the tick size came with the msg
+    std::string currency;
+    bool isStrategy = false;
+    bool isOption = false;
+    MXDate expiration;
+    MXDate lastTradeDt;
+    MXDate expiryDate;
+};
+
+//Everything the channel keeps per instrument, reached through one handle lookup per msg
+struct MXInstrumentState {
+    static constexpr int NO_DECIMALS = -1;
+    static constexpr char NO_STATUS_MARKER = 0;
+    static constexpr Descriptor_t NO_DESCRIPTOR = 0;
+
+    MXInstrumentState(const MXInstrumentKey& key)
+        : key(key)
+        , identifier(key.ToString())
+    {
+    }
+
+    bool HasDecimals() const {
+        return decimals != NO_DECIMALS;
+    }
+
+    //Resolves the price scaling with the decimals, every price field after that is one table lookup
+    void SetDecimals(const int instrumentDecimals) {
+        decimals = instrumentDecimals;
+        priceScale = MXPriceScale(instrumentDecimals);
+    }
+
+    bool HasDescriptor() const {
+        return indesc != NO_DESCRIPTOR;
+    }
+
+    MXInstrumentKey key;
+    std::string identifier;
+    Descriptor_t indesc = NO_DESCRIPTOR;    //assigned by MXDescriptorRegistry with the definition
+    int decimals = NO_DECIMALS;
+    MXPriceScale priceScale;                //noop until the decimals are set
+    char statusMarker = NO_STATUS_MARKER;
+    std::unique_ptr<InstrumentDefinition> definition;   //set once the instrument keys msg was processed
+    MXDefinitionSource source;                          //set with definition
+    bool grouped = false;                               //listed under source.group in the channel's group map
+    bool restored = false;                              //defined from the definition cache
+};
+
+/** Interns MXInstrumentKey into dense handles, assigned in arrival order.
+    The books live apart from the states, in a store indexed by the same handle.
+    References returned by Get()/Intern() and the views returned by GetOrderbook() stay valid until the next Intern()
+    of a new key
+*/
+class MXInstruments {
+public:
+    MXInstrumentState& Intern(const MXInstrumentKey& key) {
+        auto pair = _handles.try_emplace(key, static_cast<MXInstrumentHandle>(_states.size()));
+        if(pair.second) {
+            _states.emplace_back(key);
+            _orderbooks.Add();
+        }
+        return _states[pair.first->second];
+    }
+
+    //nullptr if the key was never interned
+    MXInstrumentState* Find(const MXInstrumentKey& key) {
+        auto it = _handles.find(key);
+        return it == std::end(_handles) ? nullptr : &_states[it->second];
+    }
+
+    MXInstrumentHandle GetHandle(const MXInstrumentState& state) const {
+        return static_cast<MXInstrumentHandle>(&state - _states.data());
+    }
+
+    MXInstrumentState& Get(const MXInstrumentHandle handle) {
+        assert(handle < _states.size());
+        return _states[handle];
+    }
+
+    MXOrderbook GetOrderbook(const MXInstrumentHandle handle) {
+        return _orderbooks.Get(handle);
+    }
+
+    size_t GetSize() const {
+        return _states.size();
+    }
+
+private:
+    std::unordered_map<MXInstrumentKey, MXInstrumentHandle, MXInstrumentKeyHash> _handles;
+    std::vector<MXInstrumentState> _states;
+    MXOrderbooks _orderbooks;
+};
+
+inline void AdjustPrice(const MXInstrumentState& instrument, const char fractionIndicator, int64_t& price) {
+    instrument.priceScale.Adjust(fractionIndicator, price);
+}
+
+}//end namespace
+
+#endif
@@ -2,12 +2,23 @@
 #define _MX_LOG_H_
 
 #include "logger/logger.h"
+#include "common/async_log.h"
 
 #define MX_ID 30090
+
+//DEBUG/INFO/WARN/ERR only encode their arguments, after a level check, and are formatted on the async log thread.
+//One per thread ring keeps them in order, WARN/ERR are never dropped. Build with MX_SYNC_LOGGING to format everything inline
+#ifdef MX_SYNC_LOGGING
 #define MX_DEBUG() LOG(DEBUG, MX_ID)
 #define MX_INFO() LOG(INFO, MX_ID)
-#define MX_LOCAL() LOG_LOCAL(INFO, MX_ID)
 #define MX_WARN() LOG(WARNING, MX_ID)
 #define MX_ERR() LOG(ERROR, MX_ID)
+#else
+#define MX_DEBUG() ASYNC_LOG(ns::AsyncLogLevel::Debug, MX_ID)
+#define MX_INFO() ASYNC_LOG(ns::AsyncLogLevel::Info, MX_ID)
+#define MX_WARN() ASYNC_LOG(ns::AsyncLogLevel::Warn, MX_ID)
+#define MX_ERR() ASYNC_LOG(ns::AsyncLogLevel::Error, MX_ID)
+#endif
+#define MX_LOCAL() LOG_LOCAL(INFO, MX_ID)
 
 #endif
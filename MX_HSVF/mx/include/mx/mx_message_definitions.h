@@ -2,6 +2,8 @@
 #define _MX_MESSAGE_DEFINITIONS_H_
 
 #include "mx_common.h"
+#include "mx_instrument_key.h"
+#include "mx_numeric.h"
 
 namespace ns {
 
@@ -11,14 +13,9 @@ namespace ns {
 const std::string delimiter = ", ";
 
 
-template<typename T>
-T ConvertCharArray(const char* buf, int len) {
-    T ret = 0;
-    for(int i = len; i > 0; --i) {
-        ret = ret * 10 + *buf - '0';
-        ++buf;
-    }
-    return ret;
+template<typename T, size_t LEN>
+T ConvertCharArray(const char (&buf)[LEN]) {
+    return static_cast<T>(DecodeMXDigits<LEN>(buf));
 }
 
 /** As per doc:
@@ -33,12 +30,11 @@ T ConvertCharArray(const char* buf, int len) {
     Open Interest of 544,‘544871’		Size field will indicate ‘544871’ 				544,871
     Open Interest of 17,458,795			Size field will indicate ‘174587C’ 				17,458,700
 */
-template<typename T>
-T ConvertCharArrayWithLastByteCheck(const char* buf, int len) {
-    const bool shouldMultiply = buf[len - 1] > '9';
-    const uint32_t multiplier = shouldMultiply ? ns::GetMultiplierFromIndicatorCode(buf[len - 1]) : 1;
-    T value = ConvertCharArray<T>(buf, shouldMultiply ? len - 1: len);
-    return value * multiplier;
+template<typename T, size_t LEN>
+T ConvertCharArrayWithLastByteCheck(const char (&buf)[LEN]) {
+    char exponent;
+    const T value = static_cast<T>(DecodeMXDigitsWithExponent<LEN>(buf, exponent));
+    return exponent ? value * ns::GetMultiplierFromIndicatorCode(exponent) : value;
 }
 
 struct MsgHeader {
@@ -46,7 +42,10 @@ struct MsgHeader {
     char msgType[2];
 
     uint64_t GetSeqNum() const {
-        return ConvertCharArray<uint64_t>(seqNum, 10);
+        return ConvertCharArray<uint64_t>(seqNum);
+    }
+    uint16_t GetMsgTypeCode() const {
+        return MXMsgTypeCode(msgType[0], msgType[1]);
     }
     std::string GetMsgType() const {
         return std::string(msgType, sizeof(msgType));
@@ -67,7 +66,10 @@ struct LongMsgHeader {
     char timestamp[20];
 
     uint64_t GetSeqNum() const {
-        return ConvertCharArray<uint64_t>(seqNum, 10);
+        return ConvertCharArray<uint64_t>(seqNum);
+    }
+    uint16_t GetMsgTypeCode() const {
+        return MXMsgTypeCode(msgType[0], msgType[1]);
     }
     std::string GetMsgType() const {
         return std::string(msgType, sizeof(msgType));
@@ -165,14 +167,27 @@ struct DepthLevel {
     char askOrdersNum[2];
 
     int GetLevel() const            { return level - '1'; }
-    int64_t GetBidPrice() const     { return ConvertCharArray<int64_t>(bidPrice, 7); }
+    int64_t GetBidPrice() const     { return ConvertCharArray<int64_t>(bidPrice); }
     char GetBidPriceFI() const      { return bidPriceFractionIndicator; }
-    int32_t GetBidSize() const      { return ConvertCharArrayWithLastByteCheck<int32_t>(bidSize, 5); }
-    int32_t GetBidOrdersNum() const { return ConvertCharArrayWithLastByteCheck<int32_t>(bidOrdersNum, 2); }
-    int64_t GetAskPrice() const     { return ConvertCharArray<int64_t>(askPrice, 7); }
+    int32_t GetBidSize() const      { return ConvertCharArrayWithLastByteCheck<int32_t>(bidSize); }
+    int32_t GetBidOrdersNum() const { return ConvertCharArrayWithLastByteCheck<int32_t>(bidOrdersNum); }
+    int64_t GetAskPrice() const     { return ConvertCharArray<int64_t>(askPrice); }
     char GetAskPriceFI() const      { return askPriceFractionIndicator; }
-    int32_t GetAskSize() const      { return ConvertCharArrayWithLastByteCheck<int32_t>(askSize, 5); }
-    int32_t GetAskOrdersNum() const { return ConvertCharArrayWithLastByteCheck<int32_t>(askOrdersNum, 2); }
+    int32_t GetAskSize() const      { return ConvertCharArrayWithLastByteCheck<int32_t>(askSize); }
+    int32_t GetAskOrdersNum() const { return ConvertCharArrayWithLastByteCheck<int32_t>(askOrdersNum); }
+
+    //Both prices in one pass, the loads start at level / bidOrdersNum[1]
+    MXDecodedLevel Decode() const {
+        static_assert(offsetof(DepthLevel, askPrice) - 1 + 16 <= sizeof(DepthLevel), "Price load past the level");
+        const char* base = reinterpret_cast<const char*>(this);
+        MXDecodedLevel decoded;
+        DecodeMXPricePair(base + offsetof(DepthLevel, bidPrice) - 1, base + offsetof(DepthLevel, askPrice) - 1, decoded.bidPrice, decoded.askPrice);
+        decoded.bidSize = GetBidSize();
+        decoded.askSize = GetAskSize();
+        decoded.bidOrdersNum = GetBidOrdersNum();
+        decoded.askOrdersNum = GetAskOrdersNum();
+        return decoded;
+    }
 
     std::string ToString(const std::string& id) const {
         std::stringstream ss;
@@ -206,19 +221,34 @@ struct StrategyDepthLevel {
 
     int GetLevel() const            { return level - '1'; }
     int64_t GetBidPrice() const { 
-        const int64_t value = ConvertCharArray<int64_t>(bidPrice, 7);
+        const int64_t value = ConvertCharArray<int64_t>(bidPrice);
         return bidPriceSign == '-' ? value * -1 : value;
     }
     char GetBidPriceFI() const      { return bidPriceFractionIndicator; }
-    int32_t GetBidSize() const      { return ConvertCharArrayWithLastByteCheck<int32_t>(bidSize, 5); }
-    int32_t GetBidOrdersNum() const { return ConvertCharArrayWithLastByteCheck<int32_t>(bidOrdersNum, 2); }
+    int32_t GetBidSize() const      { return ConvertCharArrayWithLastByteCheck<int32_t>(bidSize); }
+    int32_t GetBidOrdersNum() const { return ConvertCharArrayWithLastByteCheck<int32_t>(bidOrdersNum); }
     int64_t GetAskPrice() const {
-        const int64_t value = ConvertCharArray<int64_t>(askPrice, 7);
+        const int64_t value = ConvertCharArray<int64_t>(askPrice);
         return askPriceSign == '-' ? value * -1 : value;
     }
     char GetAskPriceFI() const      { return askPriceFractionIndicator; }
-    int32_t GetAskSize() const      { return ConvertCharArrayWithLastByteCheck<int32_t>(askSize, 5); }
-    int32_t GetAskOrdersNum() const { return ConvertCharArrayWithLastByteCheck<int32_t>(askOrdersNum, 2); }
+    int32_t GetAskSize() const      { return ConvertCharArrayWithLastByteCheck<int32_t>(askSize); }
+    int32_t GetAskOrdersNum() const { return ConvertCharArrayWithLastByteCheck<int32_t>(askOrdersNum); }
+
+    //Both prices in one pass, the loads start at the sign bytes
+    MXDecodedLevel Decode() const {
+        static_assert(offsetof(StrategyDepthLevel, askPrice) - 1 + 16 <= sizeof(StrategyDepthLevel), "Price load past the level");
+        const char* base = reinterpret_cast<const char*>(this);
+        MXDecodedLevel decoded;
+        DecodeMXPricePair(base + offsetof(StrategyDepthLevel, bidPrice) - 1, base + offsetof(StrategyDepthLevel, askPrice) - 1, decoded.bidPrice, decoded.askPrice);
+        decoded.bidPrice = bidPriceSign == '-' ? decoded.bidPrice * -1 : decoded.bidPrice;
+        decoded.askPrice = askPriceSign == '-' ? decoded.askPrice * -1 : decoded.askPrice;
+        decoded.bidSize = GetBidSize();
+        decoded.askSize = GetAskSize();
+        decoded.bidOrdersNum = GetBidOrdersNum();
+        decoded.askOrdersNum = GetAskOrdersNum();
+        return decoded;
+    }
 
     std::string ToString(const std::string& id) const {
         std::stringstream ss;
@@ -259,6 +289,9 @@ struct FutureMarketDepth {
                 + GetExpiryDay()
                 ;
     }
+    MXInstrumentKey GetInstrumentKey() const {
+        return MXInstrumentKey(rootSymbol, symbolMonth, symbolYear, expiryDay);
+    }
     std::string GetRootSymbol() const {
         return std::string(rootSymbol, sizeof(rootSymbol));
     }
@@ -324,6 +357,9 @@ struct OptionMarketDepth {
                 + GetExpiryDay()
                 ;
     }
+    MXInstrumentKey GetInstrumentKey() const {
+        return MXInstrumentKey(rootSymbol, expiryMonth, strikePrice, strikePriceFractionIndicator, expiryYear, expiryDay);
+    }
     std::string GetRootSymbol() const {
         return std::string(rootSymbol, sizeof(rootSymbol));
     }
@@ -399,6 +435,9 @@ struct FutureOptionsMarketDepth {
                 + GetStrikePriceFI()
                 ;
     }
+    MXInstrumentKey GetInstrumentKey() const {
+        return MXInstrumentKey(rootSymbol, symbolMonth, symbolYear, expiryDay, callPut, strikePrice, strikePriceFractionIndicator);
+    }
     std::string GetRootSymbol() const {
         return std::string(rootSymbol, sizeof(rootSymbol));
     }
@@ -465,6 +504,9 @@ struct StrategyMarketDepth {
     std::string GetIdentifier() const {
         return GetSymbol();
     }
+    MXInstrumentKey GetInstrumentKey() const {
+        return MXInstrumentKey(symbol);
+    }
     std::string GetSymbol() const {
         return std::string(symbol, sizeof(symbol));
     }
@@ -539,6 +581,9 @@ struct FuturesSummary {
                 + GetExpiryDay()
                 ;
     }
+    MXInstrumentKey GetInstrumentKey() const {
+        return MXInstrumentKey(rootSymbol, symbolMonth, symbolYear, expiryDay);
+    }
     std::string GetRootSymbol() const {
         return std::string(rootSymbol, sizeof(rootSymbol));
     }
@@ -552,40 +597,40 @@ struct FuturesSummary {
         return std::string(expiryDay, sizeof(expiryDay));
     }
     int64_t GetLastPrice() const {
-        return ConvertCharArray<int64_t>(lastPrice, 7);
+        return ConvertCharArray<int64_t>(lastPrice);
     }
     char GetLastPriceFractionIndicator() const {
         return lastPriceFractionIndicator;
     }
     int64_t GetOpenPrice() const {
-        return ConvertCharArray<int64_t>(openPrice, 7);
+        return ConvertCharArray<int64_t>(openPrice);
     }
     char GetOpenPriceFractionIndicator() const {
         return openPriceFractionIndicator;
     }
     int64_t GetHighPrice() const {
-        return ConvertCharArray<int64_t>(highPrice, 7);
+        return ConvertCharArray<int64_t>(highPrice);
     }
     char GetHighPriceFractionIndicator() const {
         return highPriceFractionIndicator;
     }
     int64_t GetLowPrice() const {
-        return ConvertCharArray<int64_t>(lowPrice, 7);
+        return ConvertCharArray<int64_t>(lowPrice);
     }
     char GetLowPriceFractionIndicator() const {
         return lowPriceFractionIndicator;
     }
     int64_t GetSettlementPrice() const {
-        return ConvertCharArray<int64_t>(settlementPrice, 7);
+        return ConvertCharArray<int64_t>(settlementPrice);
     }
     char GetSettlemenetPriceFractionIndicator() const {
         return settlementPriceFractionIndicator;
     }
     int64_t GetVolume() const {
-        return ConvertCharArray<int64_t>(lastPrice, 8);
+        return ConvertCharArray<int64_t>(volume);
     }
     int64_t GetPreviousSettlementPrice() const {
-        return ConvertCharArray<int64_t>(previousSettlementPrice, 7);
+        return ConvertCharArray<int64_t>(previousSettlementPrice);
     }
     char GetPreviousSettlementPriceFI() const {
         return previousSettlementPriceFractionIndicator;
@@ -668,6 +713,9 @@ struct OptionSummary {
                 + GetExpiryDay()
                 ;
     }
+    MXInstrumentKey GetInstrumentKey() const {
+        return MXInstrumentKey(rootSymbol, expiryMonth, strikePrice, strikePriceFractionIndicator, expiryYear, expiryDay);
+    }
     std::string GetRootSymbol() const {
         return std::string(rootSymbol, sizeof(rootSymbol));
     }
@@ -687,43 +735,43 @@ struct OptionSummary {
         return std::string(expiryDay, sizeof(expiryDay));
     }
     int64_t GetLastPrice() const {
-        return ConvertCharArray<int64_t>(lastPrice, 7);
+        return ConvertCharArray<int64_t>(lastPrice);
     }
     char GetLastPriceFractionIndicator() const {
         return lastPriceFractionIndicator;
     }
     int64_t GetOpenPrice() const {
-        return ConvertCharArray<int64_t>(openPrice, 7);
+        return ConvertCharArray<int64_t>(openPrice);
     }
     char GetOpenPriceFractionIndicator() const {
         return openPriceFractionIndicator;
     }
     int64_t GetHighPrice() const {
-        return ConvertCharArray<int64_t>(highPrice, 7);
+        return ConvertCharArray<int64_t>(highPrice);
     }
     char GetHighPriceFractionIndicator() const {
         return highPriceFractionIndicator;
     }
     int64_t GetLowPrice() const {
-        return ConvertCharArray<int64_t>(lowPrice, 7);
+        return ConvertCharArray<int64_t>(lowPrice);
     }
     char GetLowPriceFractionIndicator() const {
         return lowPriceFractionIndicator;
     }
     int64_t GetVolume() const {
-        return ConvertCharArray<int64_t>(volume, 8);
+        return ConvertCharArray<int64_t>(volume);
     }
     char GetReason() const {
         return reason;
     }
     int64_t GetSettlementPrice() const {
-        return ConvertCharArray<int64_t>(settlementPrice, 7);
+        return ConvertCharArray<int64_t>(settlementPrice);
     }
     char GetSettlemenetPriceFractionIndicator() const {
         return settlementPriceFractionIndicator;
     }
     int64_t GetPreviousSettlementPrice() const {
-        return ConvertCharArray<int64_t>(previousSettlementPrice, 7);
+        return ConvertCharArray<int64_t>(previousSettlementPrice);
     }
     char GetPreviousSettlementPriceFI() const {
         return previousSettlementPriceFractionIndicator;
@@ -804,6 +852,9 @@ struct FutureOptionsSummary {
                 + GetStrikePriceFractionIndicator()
                 ;
     }
+    MXInstrumentKey GetInstrumentKey() const {
+        return MXInstrumentKey(rootSymbol, symbolMonth, symbolYear, expiryDay, callPut, strikePrice, strikePriceFractionIndicator);
+    }
     std::string GetRootSymbol() const {
         return std::string(rootSymbol, sizeof(rootSymbol));
     }
@@ -826,40 +877,40 @@ struct FutureOptionsSummary {
         return strikePriceFractionIndicator;
     } 
     int64_t GetLastPrice() const {
-        return ConvertCharArray<int64_t>(lastPrice, 7);
+        return ConvertCharArray<int64_t>(lastPrice);
     }
     char GetLastPriceFractionIndicator() const {
         return lastPriceFractionIndicator;
     }
     int64_t GetOpenPrice() const {
-        return ConvertCharArray<int64_t>(openPrice, 7);
+        return ConvertCharArray<int64_t>(openPrice);
     }
     char GetOpenPriceFractionIndicator() const {
         return openPriceFractionIndicator;
     }
     int64_t GetHighPrice() const {
-        return ConvertCharArray<int64_t>(highPrice, 7);
+        return ConvertCharArray<int64_t>(highPrice);
     }
     char GetHighPriceFractionIndicator() const {
         return highPriceFractionIndicator;
     }
     int64_t GetLowPrice() const {
-        return ConvertCharArray<int64_t>(lowPrice, 7);
+        return ConvertCharArray<int64_t>(lowPrice);
     }
     char GetLowPriceFractionIndicator() const {
         return lowPriceFractionIndicator;
     }
     int64_t GetVolume() const {
-        return ConvertCharArray<int64_t>(volume, 8);
+        return ConvertCharArray<int64_t>(volume);
     }
     int64_t GetSettlementPrice() const {
-        return ConvertCharArray<int64_t>(settlementPrice, 7);
+        return ConvertCharArray<int64_t>(settlementPrice);
     }
     char GetSettlemenetPriceFractionIndicator() const {
         return settlementPriceFractionIndicator;
     }
     int64_t GetPreviousSettlementPrice() const {
-        return ConvertCharArray<int64_t>(previousSettlementPrice, 7);
+        return ConvertCharArray<int64_t>(previousSettlementPrice);
     }
     char GetPreviousSettlementPriceFI() const {
         return previousSettlementPriceFractionIndicator;
@@ -928,38 +979,41 @@ struct StrategySummary {
     std::string GetIdentifier() const {
         return GetStrategySymbol();
     }
+    MXInstrumentKey GetInstrumentKey() const {
+        return MXInstrumentKey(strategySymbol);
+    }
     std::string GetStrategySymbol() const {
         return std::string(strategySymbol, sizeof(strategySymbol));
     }
     int64_t GetLastPrice() const {
-        return ConvertCharArray<int64_t>(lastPrice, 7);
+        return ConvertCharArray<int64_t>(lastPrice);
     }
     char GetLastPriceFractionIndicator() const {
         return lastPriceFractionIndicator;
     }
     int64_t GetOpenPrice() const {
-        const int64_t value = ConvertCharArray<int64_t>(openPrice, 7);
+        const int64_t value = ConvertCharArray<int64_t>(openPrice);
         return openPriceSign == '-' ? value * -1 : value;
     }
     char GetOpenPriceFractionIndicator() const {
         return openPriceFractionIndicator;
     }
     int64_t GetHighPrice() const {
-        const int64_t value = ConvertCharArray<int64_t>(highPrice, 7);
+        const int64_t value = ConvertCharArray<int64_t>(highPrice);
         return highPriceSign == '-' ? value * -1 : value;
     }
     char GetHighPriceFractionIndicator() const {
         return highPriceFractionIndicator;
     }
     int64_t GetLowPrice() const {
-        const int64_t value = ConvertCharArray<int64_t>(lowPrice, 7);
+        const int64_t value = ConvertCharArray<int64_t>(lowPrice);
         return lowPriceSign == '-' ? value * -1 : value;
     }
     char GetLowPriceFractionIndicator() const {
         return lowPriceFractionIndicator;
     }
     int64_t GetVolume() const {
-        return ConvertCharArray<int64_t>(lastPrice, 8);
+        return ConvertCharArray<int64_t>(volume);
     }
     char GetReason() const {
         return reason;
@@ -1032,6 +1086,9 @@ struct FuturesInstrumentKeys {
                 + GetExpiryDay()
                 ;
     }
+    MXInstrumentKey GetInstrumentKey() const {
+        return MXInstrumentKey(rootSymbol, symbolMonth, symbolYear, expiryDay);
+    }
     std::string GetInstrumentName() const {
         return GetString(GetRootSymbol())
                 + GetSymbolMonth()
@@ -1069,7 +1126,7 @@ struct FuturesInstrumentKeys {
         return std::string(lastTradingDate, sizeof(lastTradingDate));
     }  
     int64_t GetContractSize() const {
-        return ConvertCharArray<int64_t>(contractSize, 8);
+        return ConvertCharArray<int64_t>(contractSize);
     }
     std::string GetTickIncrement() const {
         return std::string(tickIncrement, sizeof(tickIncrement));
@@ -1078,7 +1135,7 @@ struct FuturesInstrumentKeys {
         return tickIncrementFractionIndicator;
     }
     int64_t GetTickValue() const {
-        return ConvertCharArray<int64_t>(tickValue, 7);
+        return ConvertCharArray<int64_t>(tickValue);
     }
     char GetTickValueFI() const {
         return tickValueFractionIndicator;
@@ -1165,6 +1222,9 @@ struct OptionInstrumentKeys {
                 + GetExpiryDay()
                 ;
     }
+    MXInstrumentKey GetInstrumentKey() const {
+        return MXInstrumentKey(rootSymbol, expiryMonth, strikePrice, strikePriceFractionIndicator, expiryYear, expiryDay);
+    }
     std::string GetInstrumentName() const {
         return GetIdentifier();
     }
@@ -1202,7 +1262,7 @@ struct OptionInstrumentKeys {
         return std::string(lastTradingDate, sizeof(lastTradingDate));
     }
     int64_t GetContractSize() const {
-        return ConvertCharArray<int64_t>(contractSize, 8);
+        return ConvertCharArray<int64_t>(contractSize);
     }
     std::string GetTickIncrement() const {
         return std::string(tickIncrement, sizeof(tickIncrement));
@@ -1211,7 +1271,7 @@ struct OptionInstrumentKeys {
         return tickIncrementFractionIndicator;
     }
     int64_t GetTickValue() const {
-        return ConvertCharArray<int64_t>(tickValue, 7);
+        return ConvertCharArray<int64_t>(tickValue);
     }
     char GetTickValueFI() const {
         return tickValueFractionIndicator;
@@ -1301,6 +1361,9 @@ struct FutureOptionsInstrumentKeys {
                 + GetStrikePriceFI()
                 ;
     }
+    MXInstrumentKey GetInstrumentKey() const {
+        return MXInstrumentKey(rootSymbol, symbolMonth, symbolYear, expiryDay, callPut, strikePrice, strikePriceFractionIndicator);
+    }
     std::string GetInstrumentName() const {
         return GetIdentifier();
     }
@@ -1347,7 +1410,7 @@ struct FutureOptionsInstrumentKeys {
         return std::string(lastTradingDate, sizeof(lastTradingDate));
     }
     int64_t GetContractSize() const {
-        return ConvertCharArray<int64_t>(contractSize, 8);
+        return ConvertCharArray<int64_t>(contractSize);
     }
     std::string GetTickIncrement() const {
         return std::string(tickIncrement, sizeof(tickIncrement));
@@ -1356,7 +1419,7 @@ struct FutureOptionsInstrumentKeys {
         return tickIncrementFractionIndicator;
     }
     int64_t GetTickValue() const {
-        return ConvertCharArray<int64_t>(tickValue, 7);
+        return ConvertCharArray<int64_t>(tickValue);
     }
     char GetTickValueFI() const {
         return tickValueFractionIndicator;
@@ -1421,13 +1484,13 @@ struct Legs {
         return std::string(legInstrument, sizeof(legInstrument));
     }
     int32_t GetLegRatio() const {
-        return ConvertCharArray<int32_t>(legRatio, 4);
+        return ConvertCharArray<int32_t>(legRatio);
     }
     char GetLegRatioFI() const {
         return legRatioFractionIndicator;
     }
     int64_t GetLegPrice() const {
-        return ConvertCharArray<int64_t>(legPrice, 7);
+        return ConvertCharArray<int64_t>(legPrice);
     }
     char GetLegPriceFI() const {
         return legPriceFractionIndicator;
@@ -1479,6 +1542,9 @@ struct StrategyInstrumentKeys {
     std::string GetIdentifier() const {
         return GetStrategySymbol();
     }
+    MXInstrumentKey GetInstrumentKey() const {
+        return MXInstrumentKey(strategySymbol);
+    }
     std::string GetInstrumentName() const {
         return GetString(GetStrategySymbol());
     }
@@ -1516,7 +1582,7 @@ struct StrategyInstrumentKeys {
         return std::string(lastTradingDate, sizeof(lastTradingDate));
     }
     int GetLegsNum() const {
-        return ConvertCharArray<int>(legsNum, 2);
+        return ConvertCharArray<int>(legsNum);
     }
     std::vector<std::string> GetLegIdentifiers() const {
         std::vector<std::string> ret;
@@ -1591,6 +1657,9 @@ struct FuturesTrade {
                 + GetExpiryDay()
                 ;
     }
+    MXInstrumentKey GetInstrumentKey() const {
+        return MXInstrumentKey(rootSymbol, symbolMonth, symbolYear, expiryDay);
+    }
     std::string GetRootSymbol() const {
         return std::string(rootSymbol, sizeof(rootSymbol));
     }
@@ -1604,10 +1673,10 @@ struct FuturesTrade {
         return std::string(expiryDay, sizeof(expiryDay));
     }
     int64_t GetVolume() const {
-        return ConvertCharArrayWithLastByteCheck<int64_t>(volume, 8);
+        return ConvertCharArrayWithLastByteCheck<int64_t>(volume);
     }
     int64_t GetTradePrice() const {
-        return ConvertCharArray<int64_t>(tradePrice, 7);
+        return ConvertCharArray<int64_t>(tradePrice);
     }
     char GetTradePriceFractionIndicator() const {
         return tradePriceFractionIndicator;
@@ -1665,6 +1734,9 @@ struct OptionTrade {
                 + GetExpiryDay()
                 ;
     }
+    MXInstrumentKey GetInstrumentKey() const {
+        return MXInstrumentKey(rootSymbol, expiryMonth, strikePrice, strikePriceFractionIndicator, expiryYear, expiryDay);
+    }
     std::string GetRootSymbol() const {
         return std::string(rootSymbol, sizeof(rootSymbol));
     }
@@ -1684,10 +1756,10 @@ struct OptionTrade {
         return std::string(expiryDay, sizeof(expiryDay));
     }
     int64_t GetVolume() const {
-        return ConvertCharArrayWithLastByteCheck<int64_t>(volume, 8);
+        return ConvertCharArrayWithLastByteCheck<int64_t>(volume);
     }
     int64_t GetTradePrice() const {
-        return ConvertCharArray<int64_t>(tradePrice, 7);
+        return ConvertCharArray<int64_t>(tradePrice);
     }
     char GetTradePriceFractionIndicator() const {
         return tradePriceFractionIndicator;
@@ -1747,6 +1819,9 @@ struct FutureOptionsTrade {
                 + GetStrikePriceFractionIndicator()
                 ;
     }
+    MXInstrumentKey GetInstrumentKey() const {
+        return MXInstrumentKey(rootSymbol, symbolMonth, symbolYear, expiryDay, callPut, strikePrice, strikePriceFractionIndicator);
+    }
     std::string GetRootSymbol() const {
         return std::string(rootSymbol, sizeof(rootSymbol));
     }
@@ -1769,10 +1844,10 @@ struct FutureOptionsTrade {
         return strikePriceFractionIndicator;
     }
     int64_t GetVolume() const {
-        return ConvertCharArrayWithLastByteCheck<int64_t>(volume, 8);
+        return ConvertCharArrayWithLastByteCheck<int64_t>(volume);
     }
     int64_t GetTradePrice() const {
-        return ConvertCharArray<int64_t>(tradePrice, 7);
+        return ConvertCharArray<int64_t>(tradePrice);
     }
     char GetTradePriceFractionIndicator() const {
         return tradePriceFractionIndicator;
@@ -1820,17 +1895,20 @@ struct StrategyTrade {
     std::string GetIdentifier() const {
         return GetSymbol();
     }
+    MXInstrumentKey GetInstrumentKey() const {
+        return MXInstrumentKey(symbol);
+    }
     std::string GetSymbol() const {
         return std::string(symbol, sizeof(symbol));
     }
     int64_t GetVolume() const {
-        return ConvertCharArrayWithLastByteCheck<int64_t>(volume, 8);
+        return ConvertCharArrayWithLastByteCheck<int64_t>(volume);
     }
     char GetTradePriceSign() const {
         return tradePriceSign;
     }
     int64_t GetTradePrice() const {
-        const int64_t value = ConvertCharArray<int64_t>(tradePrice, 7);
+        const int64_t value = ConvertCharArray<int64_t>(tradePrice);
         return tradePriceSign == '-' ? value * -1 : value;
     }
     char GetTradePriceFractionIndicator() const {
@@ -1879,6 +1957,9 @@ struct FuturesRequestForQuote {
                 + GetExpiryDay()
                 ;
     }
+    MXInstrumentKey GetInstrumentKey() const {
+        return MXInstrumentKey(rootSymbol, symbolMonth, symbolYear, expiryDay);
+    }
     std::string GetRootSymbol() const {
         return std::string(rootSymbol, sizeof(rootSymbol));
     }
@@ -1892,7 +1973,7 @@ struct FuturesRequestForQuote {
         return std::string(expiryDay, sizeof(expiryDay));
     }
     int64_t GetRequestedSize() const {
-        return ConvertCharArrayWithLastByteCheck<int64_t>(requestedSize, 8);
+        return ConvertCharArrayWithLastByteCheck<int64_t>(requestedSize);
     }
     char GetRequestedMarketSide() const {
         return requestedMarketSide;
@@ -1933,6 +2014,9 @@ struct OptionRequestForQuote {
                 + GetExpiryDay()
                 ;
     }
+    MXInstrumentKey GetInstrumentKey() const {
+        return MXInstrumentKey(rootSymbol, expiryMonth, strikePrice, strikePriceFractionIndicator, expiryYear, expiryDay);
+    }
     std::string GetRootSymbol() const {
         return std::string(rootSymbol, sizeof(rootSymbol));
     }
@@ -1952,7 +2036,7 @@ struct OptionRequestForQuote {
         return std::string(expiryDay, sizeof(expiryDay));
     }
     int64_t GetRequestedSize() const {
-        return ConvertCharArrayWithLastByteCheck<int64_t>(requestedSize, 8);
+        return ConvertCharArrayWithLastByteCheck<int64_t>(requestedSize);
     }
     char GetRequestedMarketSide() const {
         return requestedMarketSide;
@@ -1995,6 +2079,9 @@ struct FutureOptionsRequestForQuote {
                 + GetStrikePriceFractionIndicator()
                 ;
     }
+    MXInstrumentKey GetInstrumentKey() const {
+        return MXInstrumentKey(rootSymbol, symbolMonth, symbolYear, expiryDay, callPut, strikePrice, strikePriceFractionIndicator);
+    }
     std::string GetRootSymbol() const {
         return std::string(rootSymbol, sizeof(rootSymbol));
     }
@@ -2017,7 +2104,7 @@ struct FutureOptionsRequestForQuote {
         return strikePriceFractionIndicator;
     }
     int64_t GetRequestedSize() const {
-        return ConvertCharArrayWithLastByteCheck<int64_t>(requestedSize, 8);
+        return ConvertCharArrayWithLastByteCheck<int64_t>(requestedSize);
     }
     char GetRequestedMarketSide() const {
         return requestedMarketSide;
@@ -2048,11 +2135,14 @@ struct StrategyRequestForQuote {
     std::string GetIdentifier() const {
         return GetSymbol();
     }
+    MXInstrumentKey GetInstrumentKey() const {
+        return MXInstrumentKey(symbol);
+    }
     std::string GetSymbol() const {
         return std::string(symbol, sizeof(symbol));
     }
     int64_t GetRequestedSize() const {
-        return ConvertCharArrayWithLastByteCheck<int64_t>(requestedSize, 8);
+        return ConvertCharArrayWithLastByteCheck<int64_t>(requestedSize);
     }
     char GetRequestedMarketSide() const {
         return requestedMarketSide;
@@ -2133,16 +2223,16 @@ struct Bond {
         return std::string(maturityDate, sizeof(maturityDate));
     }
     int64_t GetCoupon() const {
-        return ConvertCharArray<int64_t>(coupon, 7);
+        return ConvertCharArray<int64_t>(coupon);
     }
     char GetCouponFI() const {
         return couponFI;
     }
     int64_t GetOutstandingBondValue() const {
-        return ConvertCharArray<int64_t>(outstandingBondValue, 8);
+        return ConvertCharArray<int64_t>(outstandingBondValue);
     }
     int64_t GetConversionFactor() const {
-        return ConvertCharArray<int64_t>(conversionFactor, 7);
+        return ConvertCharArray<int64_t>(conversionFactor);
     }
     char GetConversionFactorFI() const {
         return conversionFactorFI;
@@ -2180,6 +2270,9 @@ struct FutureDeliverables {
                 + GetExpiryDay()
                 ;
     }
+    MXInstrumentKey GetInstrumentKey() const {
+        return MXInstrumentKey(rootSymbol, symbolMonth, symbolYear, expiryDay);
+    }
     std::string GetRootSymbol() const {
         return std::string(rootSymbol, sizeof(rootSymbol));
     }
@@ -2193,7 +2286,7 @@ struct FutureDeliverables {
         return std::string(expiryDay, sizeof(expiryDay));
     }
     int GetBondsNum() const {
-        return ConvertCharArray<int>(numOfBonds, 2);
+        return ConvertCharArray<int>(numOfBonds);
     }
     std::vector<Bond> GetBonds() const {
         std::vector<Bond> ret;
@@ -2230,13 +2323,13 @@ struct TTEntry {
     char tickPriceFractionIndicator;
 
     int64_t GetMinPrice() const {
-        return ConvertCharArray<int64_t>(minPrice, 7);
+        return ConvertCharArray<int64_t>(minPrice);
     }
     char GetMinPriceFractionIndicator() const {
         return minPriceFractionIndicator;
     }
     int64_t GetTickPrice() const {
-        return ConvertCharArray<int64_t>(tickPrice, 7);
+        return ConvertCharArray<int64_t>(tickPrice);
     }
     char GetTickPriceFractionIndicator() const {
         return tickPriceFractionIndicator;
@@ -2270,7 +2363,7 @@ struct TickTable {
         return std::string(tickTableShortName, sizeof(tickTableShortName));
     }
     int GetEntriesNum() const {
-        return ConvertCharArray<int>(entriesNum, 2);
+        return ConvertCharArray<int>(entriesNum);
     }
     std::vector<TTEntry> GetTTEntries() const {
         std::vector<TTEntry> ret;
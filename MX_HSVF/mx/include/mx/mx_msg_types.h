@@ -0,0 +1,142 @@
+#ifndef _MX_MSG_TYPES_H_
+#define _MX_MSG_TYPES_H_
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+
+#include "mx_common.h"
+#include "mx_message_definitions.h"
+
+namespace ns {
+
+template<typename MsgT>
+struct MXMsgType;
+
+#define MX_MSG_TYPE(MsgT, msgType) \
+    template<> struct MXMsgType<MsgT> { static constexpr uint16_t CODE = MXMsgTypeCode(msgType); }
+
+//Market depth
+MX_MSG_TYPE(OptionMarketDepth, "H");
+MX_MSG_TYPE(FutureMarketDepth, "HF");
+MX_MSG_TYPE(FutureOptionsMarketDepth, "HB");
+MX_MSG_TYPE(StrategyMarketDepth, "HS");
+//Summary
+MX_MSG_TYPE(OptionSummary, "N");
+MX_MSG_TYPE(FutureOptionsSummary, "NB");
+MX_MSG_TYPE(FuturesSummary, "NF");
+MX_MSG_TYPE(StrategySummary, "NS");
+//Trade
+MX_MSG_TYPE(OptionTrade, "C");
+MX_MSG_TYPE(FutureOptionsTrade, "CB");
+MX_MSG_TYPE(FuturesTrade, "CF");
+MX_MSG_TYPE(StrategyTrade, "CS");
+//Status
+MX_MSG_TYPE(GroupStatusStrategies, "GS");
+MX_MSG_TYPE(GroupStatus, "GR");
+//Instrument keys
+MX_MSG_TYPE(OptionInstrumentKeys, "J");
+MX_MSG_TYPE(FutureOptionsInstrumentKeys, "JB");
+MX_MSG_TYPE(FuturesInstrumentKeys, "JF");
+MX_MSG_TYPE(StrategyInstrumentKeys, "JS");
+//Beginning of summary
+MX_MSG_TYPE(BeginningOfOptionsSummary, "Q");
+MX_MSG_TYPE(BeginningOfFutureOptionsSummary, "QB");
+MX_MSG_TYPE(BeginningOfFuturesSummary, "QF");
+MX_MSG_TYPE(BeginningOfStrategySummary, "QS");
+//RFQ
+MX_MSG_TYPE(OptionRequestForQuote, "D");
+MX_MSG_TYPE(FutureOptionsRequestForQuote, "DB");
+MX_MSG_TYPE(FuturesRequestForQuote, "DF");
+MX_MSG_TYPE(StrategyRequestForQuote, "DS");
+//Misc
+MX_MSG_TYPE(TickTable, "TT");
+MX_MSG_TYPE(FutureDeliverables, "KF");
+MX_MSG_TYPE(StartOfDay, "SD");
+MX_MSG_TYPE(EndOfTransmission, "U");
+MX_MSG_TYPE(EndOfSales, "S");
+MX_MSG_TYPE(Heartbeat, "V");
+//Retransmission session
+MX_MSG_TYPE(LoginAcknowledgement, "KI");
+MX_MSG_TYPE(LogoutAcknowledgement, "KO");
+MX_MSG_TYPE(RetransmissionBegin, "RB");
+MX_MSG_TYPE(RestransmissionEnd, "RE");
+MX_MSG_TYPE(ErrorMessage, "ER");
+
+#undef MX_MSG_TYPE
+
+template<typename... MsgTs>
+struct MXMsgList {};
+
+using MXRealtimeMsgs = MXMsgList<OptionMarketDepth, FutureMarketDepth, FutureOptionsMarketDepth, StrategyMarketDepth,
+                                 OptionSummary, FutureOptionsSummary, FuturesSummary, StrategySummary,
+                                 OptionTrade, FutureOptionsTrade, FuturesTrade, StrategyTrade,
+                                 GroupStatusStrategies, GroupStatus,
+                                 OptionInstrumentKeys, FutureOptionsInstrumentKeys, FuturesInstrumentKeys, StrategyInstrumentKeys,
+                                 BeginningOfOptionsSummary, BeginningOfFutureOptionsSummary, BeginningOfFuturesSummary, BeginningOfStrategySummary,
+                                 OptionRequestForQuote, FutureOptionsRequestForQuote, FuturesRequestForQuote, StrategyRequestForQuote,
+                                 TickTable, FutureDeliverables, StartOfDay, EndOfTransmission, EndOfSales, Heartbeat>;
+
+//Last value msgs - the startup replay only needs the latest of each per instrument
+using MXCompactedMsgs = MXMsgList<OptionMarketDepth, FutureMarketDepth, FutureOptionsMarketDepth, StrategyMarketDepth,
+                                  OptionSummary, FutureOptionsSummary, FuturesSummary, StrategySummary>;
+
+//Msgs the definition cache stands in for
+using MXDefinitionMsgs = MXMsgList<TickTable, OptionInstrumentKeys, FutureOptionsInstrumentKeys, FuturesInstrumentKeys, StrategyInstrumentKeys>;
+
+template<typename... MsgTs>
+constexpr bool IsMXMsgIn(MXMsgList<MsgTs...>, const uint16_t code) {
+    return ((code == MXMsgType<MsgTs>::CODE) || ...);
+}
+
+/** msgType chars are upper case letters or a padding space. The low 5 bits of each char tell them apart,
+    so the table has 32 x 32 slots. Each slot keeps its full code - anything else landing there is unknown
+*/
+constexpr size_t MX_MSG_TYPE_TABLE_SIZE = 32 * 32;
+
+inline constexpr size_t GetMXMsgTypeIndex(const uint16_t code) {
+    return (static_cast<size_t>(code & 0x1F) << 5) | ((code >> 8) & 0x1F);
+}
+
+template<typename HandlerT>
+struct MXDispatchEntry {
+    uint16_t code = 0;
+    HandlerT handler = nullptr;
+};
+
+template<typename HandlerT>
+using MXDispatchTable = std::array<MXDispatchEntry<HandlerT>, MX_MSG_TYPE_TABLE_SIZE>;
+
+template<typename... MsgTs>
+constexpr bool HasMXMsgTypeCollision(MXMsgList<MsgTs...>) {
+    constexpr uint16_t codes[] = {MXMsgType<MsgTs>::CODE...};
+    for(size_t i = 0; i < sizeof...(MsgTs); ++i) {
+        for(size_t j = i + 1; j < sizeof...(MsgTs); ++j) {
+            if(GetMXMsgTypeIndex(codes[i]) == GetMXMsgTypeIndex(codes[j])) {
+                return true;
+            }
+        }
+    }
+    return false;
+}
+static_assert(!HasMXMsgTypeCollision(MXRealtimeMsgs{}), "Two realtime msg types share a dispatch slot");
+
+//msgType indexed table of handlers, filled at compile time. makeHandler(const MsgT*) supplies the entry of every msg in the list
+template<typename HandlerT, typename... MsgTs, typename MakeHandlerT>
+constexpr MXDispatchTable<HandlerT> MakeMXDispatchTable(MXMsgList<MsgTs...>, MakeHandlerT makeHandler) {
+    MXDispatchTable<HandlerT> table{};
+    ((table[GetMXMsgTypeIndex(MXMsgType<MsgTs>::CODE)] = MXDispatchEntry<HandlerT>{MXMsgType<MsgTs>::CODE,
+                                                                                   makeHandler(static_cast<const MsgTs*>(nullptr))}), ...);
+    return table;
+}
+
+//Returns nullptr for msg types not in the table
+template<typename HandlerT>
+inline HandlerT FindMXHandler(const MXDispatchTable<HandlerT>& table, const uint16_t code) {
+    const MXDispatchEntry<HandlerT>& entry = table[GetMXMsgTypeIndex(code)];
+    return entry.code == code ? entry.handler : nullptr;
+}
+
+}//end namespace
+
+#endif
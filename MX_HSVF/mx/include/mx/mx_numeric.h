@@ -0,0 +1,111 @@
+#ifndef _MX_NUMERIC_H_
+#define _MX_NUMERIC_H_
+
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+
+#if defined(__SSE4_1__)
+#include <immintrin.h>
+#endif
+
+namespace ns {
+
+/** HSVF numeric fields are fixed width, zero padded ASCII digits. Up to 8 of them are decoded at once inside a u64 (SWAR):
+    the field is loaded right aligned so the missing leading digits read as 0, then adjacent digits are combined
+    pairwise - 1 -> 2 -> 4 -> 8 digits - with three multiplies instead of one per char
+*/
+inline uint64_t DecodeMXDigits8(uint64_t chunk) {
+    chunk &= 0x0F0F0F0F0F0F0F0Full;
+    chunk = (chunk * 10 + (chunk >> 8)) & 0x00FF00FF00FF00FFull;
+    chunk = (chunk * 100 + (chunk >> 16)) & 0x0000FFFF0000FFFFull;
+    chunk = (chunk * 10000 + (chunk >> 32)) & 0x00000000FFFFFFFFull;
+    return chunk;
+}
+
+template<typename WordT>
+inline WordT LoadMXWord(const char* buf) {
+    WordT word;
+    std::memcpy(&word, buf, sizeof(word));
+    return word;
+}
+
+/** LEN <= 8 chars, first char is the most significant digit. Odd widths are built from two overlapping loads of the
+    next smaller word - a partial copy into a zeroed u64 goes through the stack and stalls the reload
+*/
+template<size_t LEN>
+inline uint64_t LoadMXDigits(const char* buf) {
+    static_assert(LEN > 0 && LEN <= sizeof(uint64_t), "LoadMXDigits - at most 8 chars per chunk");
+    uint64_t chunk;
+    if constexpr(LEN == 8) {
+        chunk = LoadMXWord<uint64_t>(buf);
+    } else if constexpr(LEN >= 4) {
+        chunk = LoadMXWord<uint32_t>(buf) | (static_cast<uint64_t>(LoadMXWord<uint32_t>(buf + LEN - 4)) << ((LEN - 4) * 8));
+    } else if constexpr(LEN >= 2) {
+        chunk = LoadMXWord<uint16_t>(buf) | (static_cast<uint64_t>(LoadMXWord<uint16_t>(buf + LEN - 2)) << ((LEN - 2) * 8));
+    } else {
+        chunk = static_cast<unsigned char>(buf[0]);
+    }
+    //Right align, the missing leading digits read as 0
+    return chunk << ((sizeof(chunk) - LEN) * 8);
+}
+
+template<size_t LEN>
+inline uint64_t DecodeMXDigits(const char* buf) {
+    static_assert(LEN <= 16, "DecodeMXDigits - at most 16 digits");
+    if constexpr(LEN <= 8) {
+        return DecodeMXDigits8(LoadMXDigits<LEN>(buf));
+    } else {
+        //The seqNum is 10
+        return DecodeMXDigits8(LoadMXDigits<LEN - 8>(buf)) * 100000000ull + DecodeMXDigits8(LoadMXDigits<8>(buf + LEN - 8));
+    }
+}
+
+//Last char may be an exponent letter instead of a digit - decodes the digits before it and reports the letter
+template<size_t LEN>
+inline uint64_t DecodeMXDigitsWithExponent(const char* buf, char& exponent) {
+    exponent = buf[LEN - 1] > '9' ? buf[LEN - 1] : 0;
+    uint64_t chunk = LoadMXDigits<LEN>(buf);
+    if(exponent) {
+        //Shift the letter out, the digits before it stay right aligned
+        chunk <<= 8;
+    }
+    return DecodeMXDigits8(chunk);
+}
+
+/** Decodes two 7 digit prices sitting one byte after bidAt/askAt, in one go.
+    Each 16 byte load must stay inside the level - the byte before each price (level id or sign) is masked out
+*/
+inline void DecodeMXPricePair(const char* bidAt, const char* askAt, int64_t& bidPrice, int64_t& askPrice) {
+#if defined(__SSE4_1__)
+    const __m128i bid = _mm_loadu_si128(reinterpret_cast<const __m128i*>(bidAt));
+    const __m128i ask = _mm_loadu_si128(reinterpret_cast<const __m128i*>(askAt));
+    //[junk, 7 bid digits, junk, 7 ask digits]
+    __m128i digits = _mm_unpacklo_epi64(bid, ask);
+    digits = _mm_and_si128(_mm_sub_epi8(digits, _mm_set1_epi8('0')),
+                           _mm_setr_epi8(0, -1, -1, -1, -1, -1, -1, -1, 0, -1, -1, -1, -1, -1, -1, -1));
+    const __m128i pairs = _mm_maddubs_epi16(digits, _mm_setr_epi8(10, 1, 10, 1, 10, 1, 10, 1, 10, 1, 10, 1, 10, 1, 10, 1));
+    const __m128i quads = _mm_madd_epi16(pairs, _mm_setr_epi16(100, 1, 100, 1, 100, 1, 100, 1));
+    const __m128i packed = _mm_packus_epi32(quads, quads);
+    const __m128i values = _mm_madd_epi16(packed, _mm_setr_epi16(10000, 1, 10000, 1, 10000, 1, 10000, 1));
+    bidPrice = _mm_cvtsi128_si32(values);
+    askPrice = _mm_extract_epi32(values, 1);
+#else
+    bidPrice = static_cast<int64_t>(DecodeMXDigits<7>(bidAt + 1));
+    askPrice = static_cast<int64_t>(DecodeMXDigits<7>(askAt + 1));
+#endif
+}
+
+//One book level, decoded
+struct MXDecodedLevel {
+    int64_t bidPrice;
+    int64_t askPrice;
+    int32_t bidSize;
+    int32_t askSize;
+    int32_t bidOrdersNum;
+    int32_t askOrdersNum;
+};
+
+}//end namespace
+
+#endif
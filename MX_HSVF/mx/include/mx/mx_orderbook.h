@@ -1,101 +1,161 @@
 #ifndef _MX_ORDERBOOK_H_
 #define _MX_ORDERBOOK_H_
 
+#include <cstddef>
+#include <cstdint>
+#include <new>
+#include <tuple>
+#include <vector>
+
 #include "mx_log.h"
 
 namespace ns {
 
-struct Level {
-    Level(const int64_t price, const int32_t qty) : price(price), qty(qty) 
+constexpr size_t MX_DEPTH_LEVELS = 5;                   //HSVF depth levels 1 to 5
+constexpr size_t MX_IMPLIED_SLOT = MX_DEPTH_LEVELS;     //level A
+constexpr size_t MX_BOOK_SLOTS = MX_DEPTH_LEVELS + 1;
+constexpr size_t MX_CACHE_LINE = 64;
+
+/** std::allocator on cache line boundaries - the store arrays start on a line of their own */
+template<typename T>
+struct MXCacheLineAllocator {
+    using value_type = T;
+
+    MXCacheLineAllocator() = default;
+
+    template<typename U>
+    MXCacheLineAllocator(const MXCacheLineAllocator<U>&)
     {
     }
-    int64_t price;
-    int32_t qty;
+
+    T* allocate(const size_t n) {
+        return static_cast<T*>(::operator new(n * sizeof(T), std::align_val_t(MX_CACHE_LINE)));
+    }
+
+    void deallocate(T* ptr, const size_t) {
+        ::operator delete(ptr, std::align_val_t(MX_CACHE_LINE));
+    }
+
+    template<typename U>
+    bool operator==(const MXCacheLineAllocator<U>&) const { return true; }
+    template<typename U>
+    bool operator!=(const MXCacheLineAllocator<U>&) const { return false; }
 };
 
+template<typename T>
+using MXCacheLineVector = std::vector<T, MXCacheLineAllocator<T>>;
+
+/** One book of MXOrderbooks - 5 levels plus the implied one per side. A view over the store's arrays, valid until
+    the next MXOrderbooks::Add()
+*/
 class MXOrderbook {
 public:
-    MXOrderbook()
+    enum : size_t { BID = 0, ASK = 1, SIDES = 2 };
+
+    //levels - [side], prices and qtys - [side][slot]
+    MXOrderbook(uint8_t* levels, int64_t* prices, int32_t* qtys)
+        : _levels(levels)
+        , _prices(prices)
+        , _qtys(qtys)
     {
     }
 
-    void OnNewOrChange(const MarketBookSide side, const size_t level, int64_t price, int32_t qty) {
-        if(side == MarketBookSide::Bid) {       _OnNewOrChange(_bids, level, price, qty); }
-        else if(side == MarketBookSide::Ask) {  _OnNewOrChange(_asks, level, price, qty); }
-        else {
+    void OnNewOrChange(const MarketBookSide side, const size_t level, const int64_t price, const int32_t qty) {
+        switch(side) {
+        case MarketBookSide::Bid:        _OnNewOrChange(BID, level, price, qty); break;
+        case MarketBookSide::Ask:        _OnNewOrChange(ASK, level, price, qty); break;
+        case MarketBookSide::ImpliedBid: _SetImplied(BID, price, qty); break;
+        case MarketBookSide::ImpliedAsk: _SetImplied(ASK, price, qty); break;
+        default:
             assert(!"OnNewOrChange - unhandled side");
         }
     }
 
     void OnDeleteFrom(const MarketBookSide side, const size_t level) {
-        if(side == MarketBookSide::Bid) {       _DeleteFrom(_bids, level); }
-        else if (side == MarketBookSide::Ask) { _DeleteFrom(_asks, level); }
-        else {
+        switch(side) {
+        case MarketBookSide::Bid:        _DeleteFrom(BID, level); break;
+        case MarketBookSide::Ask:        _DeleteFrom(ASK, level); break;
+        case MarketBookSide::ImpliedBid: _SetImplied(BID, 0, 0); break;
+        case MarketBookSide::ImpliedAsk: _SetImplied(ASK, 0, 0); break;
+        default:
             assert(!"OnDeleteFrom - unhandled side");
         }
     }
 
     std::tuple<bool, int64_t, int32_t> TopBidEqualsTopAsk() const {
-        const bool isEqual = _bids.size() > 0 && _asks.size() > 0 && _bids[0].price == _asks[0].price;
+        const bool isEqual = _levels[BID] > 0 && _levels[ASK] > 0 && *_Price(BID, 0) == *_Price(ASK, 0);
         if(isEqual) {
-            const int32_t minQty = std::min(_bids[0].qty, _asks[0].qty);
-            return std::make_tuple(isEqual, _bids[0].price, minQty);
+            const int32_t minQty = std::min(*_Qty(BID, 0), *_Qty(ASK, 0));
+            return std::make_tuple(isEqual, *_Price(BID, 0), minQty);
         }
         return std::make_tuple(isEqual, 0, 0);
-    }  
+    }
 
 private:
-    void _OnNewOrChange(std::vector<Level>& orders, const size_t level, int64_t price, int32_t qty) {
-        if(level == orders.size()) {
-            orders.push_back({price, qty});
-        } else if(level < orders.size()) {
-            orders[level].price = price;
-            orders[level].qty = qty;
-        } else {
+    int64_t* _Price(const size_t side, const size_t slot) const {
+        return _prices + side * MX_BOOK_SLOTS + slot;
+    }
+
+    int32_t* _Qty(const size_t side, const size_t slot) const {
+        return _qtys + side * MX_BOOK_SLOTS + slot;
+    }
+
+    void _OnNewOrChange(const size_t side, const size_t level, const int64_t price, const int32_t qty) {
+        if(level > _levels[side] || level >= MX_DEPTH_LEVELS) {
             assert(!"_OnNewOrChange - unhandled clause");
+            return;
+        }
+        *_Price(side, level) = price;
+        *_Qty(side, level) = qty;
+        if(level == _levels[side]) {
+            ++_levels[side];
         }
     }
 
-    void _DeleteFrom(std::vector<Level>& orders, const size_t level) {
-        if(level + 1 > orders.size()) 
-            return;
+    void _DeleteFrom(const size_t side, const size_t level) {
+        if(level < _levels[side]) {
+            _levels[side] = static_cast<uint8_t>(level);
+        }
+    }
 
-        orders.erase(std::begin(orders) + level, std::end(orders));
+    void _SetImplied(const size_t side, const int64_t price, const int32_t qty) {
+        *_Price(side, MX_IMPLIED_SLOT) = price;
+        *_Qty(side, MX_IMPLIED_SLOT) = qty;     //0 - no implied level
     }
 
-    std::vector<Level> _bids, _asks;
+    uint8_t* _levels;                           //depth levels in use, the implied slot is not counted
+    int64_t* _prices;
+    int32_t* _qtys;
 };
 
-
-
+/** Structure of arrays book store indexed by MXInstrumentHandle - level counts, prices and qtys each in one cache line
+    aligned array. The level counts of 32 books share a line, so top of book checks over an option chain stay dense.
+    Books are added in handle order, one option chain is one run of adjacent entries in every array
+*/
 class MXOrderbooks {
 public:
-    void NewOrChange(const std::string& identifier, const MarketBookSide side, const size_t level, int64_t price, int32_t qty) {
-        MXOrderbook& orderbook = CreateOrGetOrderbook(identifier);
-        orderbook.OnNewOrChange(side, level, price, qty);
-    }
-    void DeleteFrom(const std::string& identifier, const MarketBookSide side, const size_t level) {
-        MXOrderbook& orderbook = CreateOrGetOrderbook(identifier);
-        orderbook.OnDeleteFrom(side, level);
+    void Add() {
+        _levels.resize(_levels.size() + MXOrderbook::SIDES, 0);
+        _prices.resize(_prices.size() + BOOK_SLOTS, 0);
+        _qtys.resize(_qtys.size() + BOOK_SLOTS, 0);
     }
 
-    std::tuple<bool, int64_t, int32_t> TopBidEqualsTopAsk(const std::string& identifier) {
-        auto it = _orderbooks.find(identifier);
-        if(it != std::end(_orderbooks)) {
-            return it->second.TopBidEqualsTopAsk();
-        }
-        return std::make_tuple(false, 0, 0);
+    MXOrderbook Get(const uint32_t handle) {
+        assert(handle < GetSize());
+        return MXOrderbook(_levels.data() + handle * MXOrderbook::SIDES, _prices.data() + handle * BOOK_SLOTS, _qtys.data() + handle * BOOK_SLOTS);
     }
 
-    MXOrderbook& CreateOrGetOrderbook(const std::string& identifier) {
-        auto pair = _orderbooks.try_emplace(identifier, MXOrderbook());
-        return pair.first->second;
+    size_t GetSize() const {
+        return _levels.size() / MXOrderbook::SIDES;
     }
 
 private:
-    std::unordered_map<std::string, MXOrderbook> _orderbooks;
-};
+    static constexpr size_t BOOK_SLOTS = MXOrderbook::SIDES * MX_BOOK_SLOTS;
 
+    MXCacheLineVector<uint8_t> _levels;     //[handle][side]
+    MXCacheLineVector<int64_t> _prices;     //[handle][side][slot]
+    MXCacheLineVector<int32_t> _qtys;       //[handle][side][slot]
+};
 
 }//end namespace
 
@@ -6,6 +6,9 @@
 #include <string>
 #include <unordered_set>
 #include "mx_common.h"
+#include "mx_msg_types.h"
+#include "mx_retransmission_pipeline.h"
+#include "mx_stream_framer.h"
 
 
 #define REC_ID() "MXRecovery(" << _tags.channelName << "): "
@@ -32,6 +35,7 @@ public:
                     const std::string& line,
                     const int recoveryTimeout,
                     const int recoveryPageSize,
+                    const int recoveryPagesInFlight,
                     ProcessorT* processor);
     bool RequestGap(const uint64_t fromSequence, const uint64_t toSequence);
 
@@ -40,16 +44,14 @@ private:
     void _Disconnect();
     void _OnTCPStatus(TCPClient::TCPStatus status, const std::string& connectionId);
     void _OnTCPData(PacketBufferPtr ptr);
-    void _ProcessData();
     void _ProcessMessage(char* data);
     void _SendLogin();
     void _SendLogout();
-    void _SendRetransmissionRequest();
+    void _SendRetransmissionRequest(const uint64_t fromSequence, const uint64_t toSequence);
     void _HandleTCPError(char* msg);
     void _KickOffAbandonRecoveryTimer();
     void _OnAbandonRecoveryTimer(const boost::system::error_code & error);
     void _CancelAbandonRecoveryTimer();
-    bool _IsRetransmissionComplete();
 
 
     template<typename MessageT>
@@ -65,13 +67,14 @@ private:
     typedef std::shared_ptr<ns::TCPConnectionMgr> TCPConnectionMgrPtr;
     TCPConnectionMgrPtr _tcpConnectionMgr;
     PacketBufferPoolPtr_t _bufferPool;
-    std::vector<char> _buffer;
+    MXStreamFramer _framer;
     ChannelTags _tags;
     ProcessorT* _processor;
-    uint64_t _fromSequence;
-    uint64_t _toSequence;
     int _recoveryTimeout;
     int _recoveryPageSize;
+    int _recoveryPagesInFlight;     //1 - one page at a time, the next one requested on RE
+    MXRetransmissionPipeline _pipeline;
+    uint64_t _requestId = 0;        //bumped by every RequestGap()
     std::unique_ptr<boost::asio::deadline_timer> _abandonRecoveryTimer;
 };
 
@@ -94,6 +97,7 @@ bool MXRecoveryHandler<ProcessorT>::Initialize(std::shared_ptr<Config> configIns
                                                 const std::string& line,
                                                 const int recoveryTimeout,
                                                 const int recoveryPageSize,
+                                                const int recoveryPagesInFlight,
                                                 ProcessorT* processor) {
     _tags = tags;
     _processor = processor;
@@ -106,6 +110,8 @@ bool MXRecoveryHandler<ProcessorT>::Initialize(std::shared_ptr<Config> configIns
     _line = line;
     _recoveryTimeout = recoveryTimeout;
     _recoveryPageSize = recoveryPageSize;
+    _recoveryPagesInFlight = std::max(1, recoveryPagesInFlight);
+    assert(_recoveryPageSize > 0);
 
     TCPClient::processMessageFunc_t receiveCallback = std::bind(&MXRecoveryHandler::_OnTCPData, this, std::placeholders::_1);
     TCPClient::responseFunc_t statusCallback = std::bind(&MXRecoveryHandler::_OnTCPStatus, this, std::placeholders::_1, std::placeholders::_2);
@@ -150,8 +156,8 @@ bool MXRecoveryHandler<ProcessorT>::RequestGap(const uint64_t fromSequence, cons
         return false;
     }
 
-    _fromSequence = fromSequence - 1;
-    _toSequence = toSequence;
+    ++_requestId;
+    _pipeline.Reset(fromSequence, toSequence, _recoveryPageSize, _recoveryPagesInFlight);
 
     _KickOffAbandonRecoveryTimer();
     _Connect();
@@ -174,7 +180,7 @@ template <typename ProcessorT>
 void MXRecoveryHandler<ProcessorT>::_OnTCPStatus(TCPClient::TCPStatus status, const std::string& connectionId) {
     switch (status) {
         case TCPClient::TCPStatus::CONNECTED: {
-            _buffer.clear();
+            _framer.Reset();
             REC_INFO() << "MX TCP Connected";
             _SendLogin();
         } 
@@ -210,81 +216,63 @@ void MXRecoveryHandler<ProcessorT>::_OnTCPData(PacketBufferPtr packetBuffer) {
     char* readPtr = packetBuffer->m_buffer;
     const uint32_t bytesReceived = packetBuffer->m_bytesReceived;
     if(bytesReceived > 0) {
-        _buffer.insert(std::end(_buffer), readPtr, readPtr + bytesReceived);
-        _ProcessData();
-    }
-}
-
-template <typename ProcessorT>
-void MXRecoveryHandler<ProcessorT>::_ProcessData() {
-    if(_buffer.size() < sizeof(MsgHeader)) {
-        return;
-    }
-
-    char* readPtr = _buffer.data();
-    assert(*readPtr == STX);
-
-    auto it = std::find(std::begin(_buffer), std::end(_buffer), ETX);
-    //Make sure we have a complete msg
-    const bool isCompleteMsg = it != std::end(_buffer);
-
-    if(!isCompleteMsg) {
-        REC_DEBUG() << "Not enough data for a complete msg. Got=" << _buffer.size();
-        return;
-    }
-
-    _ProcessMessage(readPtr + sizeof(STX));
-
-    const size_t bytesUsed = std::distance(std::begin(_buffer), ++it);
-    const size_t bytesLeft = _buffer.size() - bytesUsed;
-    std::memmove(std::data(_buffer), std::data(_buffer) + bytesUsed, bytesLeft);
-    _buffer.resize(bytesLeft);
-
-    if (!_buffer.empty()) {
-        char* ptr = _buffer.data();
-        assert(*ptr == STX);
-
-        //Can we process yet another msg?
-        _ProcessData();
+        //Msgs are processed in place from the read buffer, a partial one at the end is kept for the next read
+        //A gap requested from a msg callback ends the session - the rest of the read belongs to the old one
+        const uint64_t requestId = _requestId;
+        const bool framed = _framer.OnData(readPtr, bytesReceived, [&](char* msg) {
+            if(requestId == _requestId) {
+                _ProcessMessage(msg);
+            }
+        });
+        if(!framed) {
+            assert(!"_OnTCPData - data out of sync with STX/ETX framing");
+            REC_WARN() << "Dropped bytes out of sync with STX/ETX framing. Got=" << bytesReceived << ", pending=" << _framer.GetPendingBytes();
+        }
     }
 }
 
 template <typename ProcessorT>
 void MXRecoveryHandler<ProcessorT>::_ProcessMessage(char* msg) {
     const MsgHeader* msgHeader = reinterpret_cast<const MsgHeader*>(msg);
-    const std::string msgType = msgHeader->GetMsgType();
     const uint64_t seqNum = msgHeader->GetSeqNum();
 
-    switch(consthash(msgType.c_str())) {
-    case consthash("KI"): {
+    switch(msgHeader->GetMsgTypeCode()) {
+    case MXMsgType<LoginAcknowledgement>::CODE: {
         REC_INFO() << "Successfully logged in";
-        _SendRetransmissionRequest(); 
+        //Anything requested on a previous session is asked for again
+        _pipeline.Restart();
+        _pipeline.FillWindow([this](const uint64_t from, const uint64_t to) { _SendRetransmissionRequest(from, to); });
     }
     break;
-    case consthash("RB"):
+    case MXMsgType<RetransmissionBegin>::CODE:
         REC_INFO() << "Retransmission of msgs starting";
         _CancelAbandonRecoveryTimer();
     break;
-    case consthash("RE"): {
-        if(_IsRetransmissionComplete()) {
+    case MXMsgType<RestransmissionEnd>::CODE: {
+        const uint64_t requestId = _requestId;
+        const bool current = _pipeline.OnPageEnd([this](const uint64_t, char* data) { _processor->OnRetransmissionMsg(data); },
+                                                 [this](const uint64_t from, const uint64_t to) { _SendRetransmissionRequest(from, to); });
+        if(current && _pipeline.IsComplete()) {
             _processor->OnRetransmissionComplete();
-            _SendLogout();
-        } else {
-            _SendRetransmissionRequest();
+            //Not if the processor asked for another gap - the logout would go out on the new session
+            if(requestId == _requestId) {
+                _SendLogout();
+            }
         }
     }
     break;
-    case consthash("KO"): {
+    case MXMsgType<LogoutAcknowledgement>::CODE: {
         REC_INFO() << "Logout acknowledged";
         _Disconnect();
     }
     break;
-    case consthash("ER"):
+    case MXMsgType<ErrorMessage>::CODE:
         _HandleTCPError(msg);
     break;
     default: {
-        _fromSequence = seqNum;
-        _processor->OnRetransmissionMsg(msg);
+        _pipeline.OnMsg(seqNum, msg,
+                        [this](const uint64_t, char* data) { _processor->OnRetransmissionMsg(data); },
+                        [this](const uint64_t from, const uint64_t to) { _SendRetransmissionRequest(from, to); });
     }
     }
 }
@@ -323,17 +311,14 @@ void MXRecoveryHandler<ProcessorT>::_SendLogout() {
 }
 
 template<typename ProcessorT>
-void MXRecoveryHandler<ProcessorT>::_SendRetransmissionRequest() {
-    //We need to take into account page size when making requests
-    const uint64_t validFromSequence = _fromSequence + 1;
-    const uint64_t validToSequence = std::min((_fromSequence + _recoveryPageSize) / _recoveryPageSize * _recoveryPageSize, _toSequence);
-
+void MXRecoveryHandler<ProcessorT>::_SendRetransmissionRequest(const uint64_t validFromSequence, const uint64_t validToSequence) {
+    //Pages are cut by the pipeline, taking page size into account
     assert(validFromSequence <= validToSequence);
 
     const std::string fromSeqPadded = std::string(10 - std::min(10, static_cast<int>(std::to_string(validFromSequence).size())), '0') + std::to_string(validFromSequence);
     const std::string toSeqPadded = std::string(10 - std::min(10, static_cast<int>(std::to_string(validToSequence).size())), '0') + std::to_string(validToSequence);
 
-    REC_INFO() << "Sending retransmission request - From: " << fromSeqPadded << ", To: " << toSeqPadded;
+    REC_INFO() << "Sending retransmission request - From: " << fromSeqPadded << ", To: " << toSeqPadded << ", inFlight=" << _pipeline.GetRequestsInFlight();
 
     RetransmissionRequest request;
     memcpy(request.header.seqNum, "0000000001", sizeof(request.header.seqNum));
@@ -395,11 +380,6 @@ void MXRecoveryHandler<ProcessorT>::_CancelAbandonRecoveryTimer() {
         REC_INFO() << "An error occured while stopping the Abandon Recovery timer"; 
 }
 
-template <typename ProcessorT>
-bool MXRecoveryHandler<ProcessorT>::_IsRetransmissionComplete() {
-    return _fromSequence == _toSequence;
-}
-
 }//end namespace
 
 #endif
@@ -0,0 +1,265 @@
+#ifndef _MX_REPLAY_COMPACTOR_H_
+#define _MX_REPLAY_COMPACTOR_H_
+
+#include <algorithm>
+#include <cstddef>
+#include <cstring>
+#include <type_traits>
+#include <vector>
+
+#include "mx_common.h"
+#include "mx_instruments.h"
+#include "mx_message_definitions.h"
+#include "mx_orderbook.h"
+
+namespace ns {
+
+//Where the ask half of a depth level starts - the bid half runs from after the level id up to it
+template<typename LevelT>
+struct MXDepthLevelLayout;
+
+template<>
+struct MXDepthLevelLayout<DepthLevel> {
+    static constexpr size_t ASK_BEGIN = offsetof(DepthLevel, askPrice);
+};
+
+template<>
+struct MXDepthLevelLayout<StrategyDepthLevel> {
+    static constexpr size_t ASK_BEGIN = offsetof(StrategyDepthLevel, askPriceSign);
+};
+
+template<typename MsgT, typename = void>
+struct MXIsDepthMsg : std::false_type {};
+
+template<typename MsgT>
+struct MXIsDepthMsg<MsgT, std::void_t<decltype(&MsgT::depthLevels)>> : std::true_type {};
+
+/** Last value compaction of the startup replay. Depth and summary msgs are not applied as they are replayed, only
+    the latest state per instrument is kept:
+    - depth levels are merged on the wire bytes, per side, with the same append/change/delete from rules as the
+      book - the latest msg only carries the levels that changed
+    - summary msgs carry cumulative values, the latest one is kept whole
+    Drain() then hands out one synthetic msg per instrument and kind updated since the last drain (two if 5 levels
+    and an implied one are set), ordered by the seqNum of the msg each was last updated by. Nothing is decoded before
+    that. The levels are kept across drains - later msgs still only carry what changed, so every depth msg of the
+    instruments has to go through Add() until Clear()
+*/
+class MXReplayCompactor {
+public:
+    //A depth or summary msg, in place of applying it
+    template<typename MsgT>
+    void Add(const MXInstrumentHandle handle, const MsgT* msg) {
+        if constexpr(MXIsDepthMsg<MsgT>::value) {
+            _AddDepth(handle, msg, msg->msgHeader.GetSeqNum());
+        } else {
+            _AddSummary(handle, msg, msg->msgHeader.GetSeqNum());
+        }
+    }
+
+    //onMsg(char* msg) with every synthetic msg, by seqNum
+    template<typename OnMsgT>
+    void Drain(OnMsgT onMsg) {
+        struct Pending {
+            uint64_t seqNum;
+            MXInstrumentHandle handle;
+            bool depth;
+        };
+        std::vector<Pending> pending;
+        for(MXInstrumentHandle handle = 0; handle < _entries.size(); ++handle) {
+            const Entry& entry = _entries[handle];
+            if(entry.depthPending) {
+                pending.push_back({entry.depthSeq, handle, true});
+            }
+            if(entry.summaryPending) {
+                pending.push_back({entry.summarySeq, handle, false});
+            }
+        }
+        std::sort(std::begin(pending), std::end(pending), [](const Pending& a, const Pending& b) { return a.seqNum < b.seqNum; });
+
+        std::vector<char> buffer;
+        for(const Pending& item : pending) {
+            Entry& entry = _entries[item.handle];
+            if(!item.depth) {
+                entry.summaryPending = false;
+                onMsg(entry.summary.data());
+                continue;
+            }
+            entry.depthPending = false;
+            for(int part = 0; entry.buildDepth(entry, part, buffer); ++part) {
+                onMsg(buffer.data());
+            }
+            entry.appliedBidLevels = entry.bidLevels;
+            entry.appliedAskLevels = entry.askLevels;
+            entry.appliedImplied = entry.impliedBid || entry.impliedAsk;
+        }
+        _compacted = 0;
+    }
+
+    //Once the replay is over
+    void Clear() {
+        _entries = std::vector<Entry>();
+        _compacted = 0;
+    }
+
+    //Nothing to drain
+    bool IsEmpty() const {
+        return _compacted == 0;
+    }
+
+    //msgs folded in since the last drain
+    uint64_t GetCompacted() const {
+        return _compacted;
+    }
+
+private:
+    struct Entry {
+        uint64_t depthSeq = 0;
+        uint64_t summarySeq = 0;
+        std::vector<char> depthHeader;      //latest depth msg up to its levels
+        std::vector<char> depthLevels;      //MX_BOOK_SLOTS level images
+        uint8_t bidLevels = 0;
+        uint8_t askLevels = 0;
+        bool impliedBid = false;
+        bool impliedAsk = false;
+        uint8_t appliedBidLevels = 0;       //as of the last drain - what a shorter book has to delete
+        uint8_t appliedAskLevels = 0;
+        bool appliedImplied = false;
+        bool depthPending = false;
+        bool summaryPending = false;
+        bool (*buildDepth)(const Entry&, int, std::vector<char>&) = nullptr;
+        std::vector<char> summary;          //latest summary msg
+    };
+
+    Entry& _GetEntry(const MXInstrumentHandle handle) {
+        if(handle >= _entries.size()) {
+            _entries.resize(handle + 1);
+        }
+        return _entries[handle];
+    }
+
+    //The level images and counts follow the book the msgs build, the rest of the msg is the latest one
+    template<typename DepthMsgT>
+    void _AddDepth(const MXInstrumentHandle handle, const DepthMsgT* msg, const uint64_t seqNum) {
+        using LevelT = typename std::remove_cv<typename std::remove_reference<decltype(msg->depthLevels[0])>::type>::type;
+        constexpr size_t HEADER_SIZE = offsetof(DepthMsgT, depthLevels);
+        constexpr size_t LEVEL_SIZE = sizeof(LevelT);
+        constexpr size_t ASK_BEGIN = MXDepthLevelLayout<LevelT>::ASK_BEGIN;
+
+        Entry& entry = _GetEntry(handle);
+        if(entry.depthLevels.empty()) {
+            entry.depthLevels.assign(MX_BOOK_SLOTS * LEVEL_SIZE, '0');
+        }
+        entry.depthHeader.assign(reinterpret_cast<const char*>(msg), reinterpret_cast<const char*>(msg) + HEADER_SIZE);
+        entry.depthSeq = seqNum;
+        entry.depthPending = true;
+        entry.buildDepth = &MXReplayCompactor::_BuildDepth<DepthMsgT>;
+        ++_compacted;
+
+        const int levels = std::min(msg->GetLevelsNum(), static_cast<int>(MX_DEPTH_LEVELS));
+        for(int i = 0; i < levels; ++i) {
+            const LevelT& level = msg->depthLevels[i];
+            const char* bytes = reinterpret_cast<const char*>(&level);
+            const bool implied = level.level == 'A';
+            const size_t slot = implied ? MX_IMPLIED_SLOT : static_cast<size_t>(level.GetLevel());
+            if(!implied && slot >= MX_DEPTH_LEVELS) {
+                assert(!"MXReplayCompactor::OnDepth - unhandled level");
+                continue;
+            }
+            char* image = entry.depthLevels.data() + slot * LEVEL_SIZE;
+
+            const bool hasBid = ConvertCharArrayWithLastByteCheck<int32_t>(level.bidSize) != 0;
+            const bool hasAsk = ConvertCharArrayWithLastByteCheck<int32_t>(level.askSize) != 0;
+            if(hasBid) {
+                std::memcpy(image + 1, bytes + 1, ASK_BEGIN - 1);
+            }
+            if(hasAsk) {
+                std::memcpy(image + ASK_BEGIN, bytes + ASK_BEGIN, LEVEL_SIZE - ASK_BEGIN);
+            }
+
+            if(implied) {
+                entry.impliedBid = hasBid;
+                entry.impliedAsk = hasAsk;
+            } else {
+                entry.bidLevels = hasBid ? std::max<uint8_t>(entry.bidLevels, slot + 1) : std::min<uint8_t>(entry.bidLevels, slot);
+                entry.askLevels = hasAsk ? std::max<uint8_t>(entry.askLevels, slot + 1) : std::min<uint8_t>(entry.askLevels, slot);
+            }
+        }
+    }
+
+    //Kept whole - up to its ETX, space padded to the full struct in case the msg came short
+    template<typename SummaryMsgT>
+    void _AddSummary(const MXInstrumentHandle handle, const SummaryMsgT* msg, const uint64_t seqNum) {
+        const char* bytes = reinterpret_cast<const char*>(msg);
+        const char* etx = static_cast<const char*>(std::memchr(bytes, ETX, sizeof(SummaryMsgT)));
+        const size_t len = etx ? etx - bytes : sizeof(SummaryMsgT);
+
+        Entry& entry = _GetEntry(handle);
+        entry.summary.assign(sizeof(SummaryMsgT) + sizeof(ETX), ' ');
+        std::memcpy(entry.summary.data(), bytes, len);
+        entry.summary.back() = ETX;
+        entry.summarySeq = seqNum;
+        entry.summaryPending = true;
+        ++_compacted;
+    }
+
+    /** Part 0 - the depth levels, with the implied one if it fits. Part 1 - the implied level alone, when 5 depth
+        levels are set. Returns false when there is no such part
+    */
+    template<typename DepthMsgT>
+    static bool _BuildDepth(const Entry& entry, const int part, std::vector<char>& buffer) {
+        using LevelT = typename std::remove_cv<typename std::remove_reference<decltype(std::declval<DepthMsgT>().depthLevels[0])>::type>::type;
+        constexpr size_t HEADER_SIZE = offsetof(DepthMsgT, depthLevels);
+        constexpr size_t LEVEL_SIZE = sizeof(LevelT);
+        constexpr size_t ASK_BEGIN = MXDepthLevelLayout<LevelT>::ASK_BEGIN;
+
+        const bool hasImplied = entry.impliedBid || entry.impliedAsk || entry.appliedImplied;
+        //A side shorter than at the last drain carries its first empty level - the delete from.
+        //At least one level, so the status still goes through
+        const size_t bidLevels = entry.bidLevels + (entry.bidLevels < entry.appliedBidLevels);
+        const size_t askLevels = entry.askLevels + (entry.askLevels < entry.appliedAskLevels);
+        const size_t depthLevels = std::max<size_t>(1, std::max(bidLevels, askLevels));
+        const bool impliedFits = depthLevels < MX_DEPTH_LEVELS;
+        if(part > 1 || (part == 1 && (!hasImplied || impliedFits))) {
+            return false;
+        }
+
+        buffer.assign(sizeof(DepthMsgT) + sizeof(ETX), '0');
+        buffer.back() = ETX;
+        std::memcpy(buffer.data(), entry.depthHeader.data(), HEADER_SIZE);
+        char* levels = buffer.data() + HEADER_SIZE;
+        size_t count = 0;
+
+        const auto addLevel = [&](const size_t slot, const char id, const bool bid, const bool ask) {
+            char* level = levels + count * LEVEL_SIZE;
+            const char* image = entry.depthLevels.data() + slot * LEVEL_SIZE;
+            level[0] = id;
+            //A side not set stays all '0' - a zero size, deleted from that level on
+            if(bid) {
+                std::memcpy(level + 1, image + 1, ASK_BEGIN - 1);
+            }
+            if(ask) {
+                std::memcpy(level + ASK_BEGIN, image + ASK_BEGIN, LEVEL_SIZE - ASK_BEGIN);
+            }
+            ++count;
+        };
+
+        if(part == 0) {
+            for(size_t slot = 0; slot < depthLevels; ++slot) {
+                addLevel(slot, static_cast<char>('1' + slot), slot < entry.bidLevels, slot < entry.askLevels);
+            }
+        }
+        if(hasImplied && (part == 1 || impliedFits)) {
+            addLevel(MX_IMPLIED_SLOT, 'A', entry.impliedBid, entry.impliedAsk);
+        }
+
+        reinterpret_cast<DepthMsgT*>(buffer.data())->numOfLevel = static_cast<char>('0' + count);
+        return true;
+    }
+
+    std::vector<Entry> _entries;            //by MXInstrumentHandle
+    uint64_t _compacted = 0;
+};
+
+}//end namespace
+
+#endif
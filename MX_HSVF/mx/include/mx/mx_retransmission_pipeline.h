@@ -0,0 +1,244 @@
+#ifndef _MX_RETRANSMISSION_PIPELINE_H_
+#define _MX_RETRANSMISSION_PIPELINE_H_
+
+#include <algorithm>
+#include <cstring>
+#include <deque>
+#include <vector>
+
+#include "mx_common.h"
+
+namespace ns {
+
+/** Retransmission msgs copied aside, in arrival order, until their turn */
+class MXMsgStash {
+public:
+    void Push(const uint64_t seqNum, const char* msg) {
+        //The msg runs up to and including its ETX
+        const char* etx = static_cast<const char*>(std::memchr(msg, ETX, MAX_MSG_SIZE));
+        const size_t len = etx ? etx - msg + sizeof(ETX) : 0;
+        assert(len > 0);
+        _seqNums.push_back(seqNum);
+        _offsets.push_back(_msgs.size());
+        _msgs.insert(std::end(_msgs), msg, msg + len);
+    }
+
+    bool Empty() const {
+        return _next == _seqNums.size();
+    }
+
+    //Of the first msg not popped yet
+    uint64_t GetSeqNum() const {
+        return _seqNums[_next];
+    }
+
+    char* GetMsg() {
+        return _msgs.data() + _offsets[_next];
+    }
+
+    //Once done with GetMsg() - the storage is reused when the last one goes
+    void Pop() {
+        if(++_next == _seqNums.size()) {
+            Clear();
+        }
+    }
+
+    void Clear() {
+        _msgs.clear();
+        _offsets.clear();
+        _seqNums.clear();
+        _next = 0;
+    }
+
+    size_t GetSize() const {
+        return _seqNums.size() - _next;
+    }
+
+private:
+    static constexpr size_t MAX_MSG_SIZE = 64 * 1024;
+
+    std::vector<char> _msgs;
+    std::vector<size_t> _offsets;
+    std::vector<uint64_t> _seqNums;
+    size_t _next = 0;
+};
+
+/** Keeps up to `window` page requests in flight on the retransmission session and hands msgs out in sequence order.
+    The server answers requests one after the other, so every RE closes the oldest request still open.
+    Msgs of the page being delivered go straight through, msgs of the pages after it are copied aside until their
+    turn. A page the server ended short is delivered as far as it got and its remainder requested again.
+    deliver may Reset() the pipeline - a new gap requested from the msg callback. Nothing of the old range is touched
+    after that, OnMsg() and OnPageEnd() return false
+*/
+class MXRetransmissionPipeline {
+public:
+    void Reset(const uint64_t fromSequence, const uint64_t toSequence, const uint64_t pageSize, const size_t window) {
+        assert(fromSequence > 0 && pageSize > 0 && window > 0);
+        _lastDelivered = fromSequence - 1;
+        _toSequence = toSequence;
+        _pageSize = pageSize;
+        _window = window;
+        Restart();
+    }
+
+    //New session - whatever was in flight is gone, resume after the last delivered msg
+    void Restart() {
+        ++_generation;
+        _pages.clear();
+        _requests.clear();
+        _nextRequest = _lastDelivered + 1;
+    }
+
+    //sendRequest(from, to) for every page the window has room for
+    template<typename SendRequestT>
+    void FillWindow(SendRequestT sendRequest) {
+        while(_requests.size() < _window && _nextRequest <= _toSequence) {
+            //Pages stay aligned on pageSize multiples
+            const uint64_t to = std::min((_nextRequest - 1 + _pageSize) / _pageSize * _pageSize, _toSequence);
+            _pages.emplace_back(_nextRequest, to);
+            _requests.push_back(to);
+            sendRequest(_nextRequest, to);
+            _nextRequest = to + 1;
+        }
+    }
+
+    //deliver(seqNum, msg) - in sequence order, possibly later and from a copy. False if deliver reset the pipeline
+    template<typename DeliverT, typename SendRequestT>
+    bool OnMsg(const uint64_t seqNum, char* msg, DeliverT deliver, SendRequestT sendRequest) {
+        if(seqNum == _lastDelivered + 1) {
+            return _Deliver(seqNum, msg, deliver) && _DrainPages(deliver, sendRequest);
+        }
+
+        Page* page = _FindPage(seqNum);
+        if(!page || seqNum <= _lastDelivered) {
+            //Already delivered, or never asked for
+            return true;
+        }
+        page->stash.Push(seqNum, msg);
+        return true;
+    }
+
+    //RE - closes the oldest open request. False if deliver reset the pipeline
+    template<typename DeliverT, typename SendRequestT>
+    bool OnPageEnd(DeliverT deliver, SendRequestT sendRequest) {
+        if(_requests.empty()) {
+            assert(!"OnPageEnd - no request in flight");
+            return true;
+        }
+        Page* page = _FindPageByEnd(_requests.front());
+        _requests.pop_front();
+        if(page) {
+            page->ended = true;
+        }
+
+        if(!_DrainPages(deliver, sendRequest)) {
+            return false;
+        }
+        FillWindow(sendRequest);
+        return true;
+    }
+
+    //Every request answered and every msg up to toSequence delivered
+    bool IsComplete() const {
+        return _requests.empty() && _lastDelivered >= _toSequence;
+    }
+
+    uint64_t GetLastDelivered() const {
+        return _lastDelivered;
+    }
+
+    size_t GetRequestsInFlight() const {
+        return _requests.size();
+    }
+
+private:
+    struct Page {
+        Page(const uint64_t from, const uint64_t to) : from(from), to(to)
+        {
+        }
+
+        uint64_t from;
+        uint64_t to;
+        bool ended = false;
+        MXMsgStash stash;                   //msgs not delivered yet
+    };
+
+    //False if deliver reset the pipeline - the pages, the one being drained too, are gone
+    template<typename DeliverT>
+    bool _Deliver(const uint64_t seqNum, char* msg, DeliverT& deliver) {
+        const uint64_t generation = _generation;
+        _lastDelivered = seqNum;
+        deliver(seqNum, msg);
+        return generation == _generation;
+    }
+
+    template<typename DeliverT, typename SendRequestT>
+    bool _DrainPages(DeliverT& deliver, SendRequestT& sendRequest) {
+        while(!_pages.empty()) {
+            Page& head = _pages.front();
+            while(!head.stash.Empty() && head.stash.GetSeqNum() <= _lastDelivered + 1) {
+                if(head.stash.GetSeqNum() == _lastDelivered + 1 && !_Deliver(head.stash.GetSeqNum(), head.stash.GetMsg(), deliver)) {
+                    return false;
+                }
+                head.stash.Pop();
+            }
+            if(_lastDelivered >= head.to) {
+                _pages.pop_front();
+                continue;
+            }
+            if(!head.ended) {
+                break;
+            }
+
+            //Ended short - what came is final, in order
+            for(; !head.stash.Empty(); head.stash.Pop()) {
+                if(head.stash.GetSeqNum() > _lastDelivered && !_Deliver(head.stash.GetSeqNum(), head.stash.GetMsg(), deliver)) {
+                    return false;
+                }
+            }
+            if(_lastDelivered >= head.to) {
+                _pages.pop_front();
+                continue;
+            }
+
+            //Ask again for the rest of the page, it stays at the head
+            const uint64_t to = head.to;
+            head = Page(_lastDelivered + 1, to);
+            _requests.push_back(to);
+            sendRequest(head.from, to);
+            break;
+        }
+        return true;
+    }
+
+    Page* _FindPage(const uint64_t seqNum) {
+        for(Page& page : _pages) {
+            if(seqNum >= page.from && seqNum <= page.to) {
+                return &page;
+            }
+        }
+        return nullptr;
+    }
+
+    Page* _FindPageByEnd(const uint64_t to) {
+        for(Page& page : _pages) {
+            if(page.to == to) {
+                return &page;
+            }
+        }
+        return nullptr;
+    }
+
+    uint64_t _generation = 0;               //bumped by every Restart()
+    uint64_t _lastDelivered = 0;
+    uint64_t _toSequence = 0;
+    uint64_t _nextRequest = 1;
+    uint64_t _pageSize = 1;
+    size_t _window = 1;
+    std::deque<Page> _pages;                //by sequence range
+    std::deque<uint64_t> _requests;         //last seqNum of every open request, in send order
+};
+
+}//end namespace
+
+#endif
@@ -0,0 +1,97 @@
+#ifndef _MX_SEQUENCE_BITMAP_H_
+#define _MX_SEQUENCE_BITMAP_H_
+
+#include <cstdint>
+#include <vector>
+
+namespace ns {
+
+/** One bit per sequence number of a recovery range [from, to] - duplicate detection, coverage and the holes still
+    missing. A full day startup replay of a few million msgs is a few hundred KB, allocated once per recovery
+*/
+class MXSequenceBitmap {
+public:
+    void Reset(const uint64_t from, const uint64_t to) {
+        _from = from;
+        _size = to >= from ? to - from + 1 : 0;
+        _count = 0;
+        _words.assign((_size + WORD_BITS - 1) / WORD_BITS, 0);
+    }
+
+    //False for a duplicate or a seqNum outside of the range
+    bool Mark(const uint64_t seqNum) {
+        const uint64_t bit = seqNum - _from;
+        if(seqNum < _from || bit >= _size) {
+            return false;
+        }
+        uint64_t& word = _words[bit / WORD_BITS];
+        const uint64_t mask = uint64_t(1) << (bit % WORD_BITS);
+        if(word & mask) {
+            return false;
+        }
+        word |= mask;
+        ++_count;
+        return true;
+    }
+
+    bool Contains(const uint64_t seqNum) const {
+        const uint64_t bit = seqNum - _from;
+        return seqNum >= _from && bit < _size && (_words[bit / WORD_BITS] >> (bit % WORD_BITS)) & 1;
+    }
+
+    bool IsComplete() const {
+        return _count == _size;
+    }
+
+    //onMissing(from, to) for every run of sequence numbers not marked yet, in order
+    template<typename OnMissingT>
+    void ForEachMissing(OnMissingT onMissing) const {
+        uint64_t bit = 0;
+        while(bit < _size) {
+            const uint64_t start = _FindNext(bit, false);
+            if(start >= _size) {
+                return;
+            }
+            const uint64_t end = _FindNext(start, true);
+            onMissing(_from + start, _from + end - 1);
+            bit = end;
+        }
+    }
+
+    uint64_t GetCount() const {
+        return _count;
+    }
+
+    uint64_t GetSize() const {
+        return _size;
+    }
+
+private:
+    static constexpr uint64_t WORD_BITS = 64;
+
+    //First bit at or after `bit` equal to `value`, _size if none - a whole word at a time
+    uint64_t _FindNext(uint64_t bit, const bool value) const {
+        while(bit < _size) {
+            uint64_t word = _words[bit / WORD_BITS];
+            if(!value) {
+                word = ~word;
+            }
+            word &= ~uint64_t(0) << (bit % WORD_BITS);
+            if(word) {
+                const uint64_t found = bit / WORD_BITS * WORD_BITS + __builtin_ctzll(word);
+                return found < _size ? found : _size;
+            }
+            bit = (bit / WORD_BITS + 1) * WORD_BITS;
+        }
+        return _size;
+    }
+
+    uint64_t _from = 0;
+    uint64_t _size = 0;
+    uint64_t _count = 0;
+    std::vector<uint64_t> _words;
+};
+
+}//end namespace
+
+#endif
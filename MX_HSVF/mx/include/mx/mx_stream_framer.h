@@ -0,0 +1,78 @@
+#ifndef _MX_STREAM_FRAMER_H_
+#define _MX_STREAM_FRAMER_H_
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+#include "mx_common.h"
+#include "mx_framing.h"
+#include "mx_message_definitions.h"
+
+namespace ns {
+
+/** Frames the HSVF retransmission TCP stream. Complete messages are handed out in place, straight from the read
+    buffer - only the partial message at the end of a read is copied, and completed by the next one.
+    One pass per read, so the cost stays linear in the bytes received however large the retransmission is
+*/
+class MXStreamFramer {
+public:
+    //A tail longer than this never gets its ETX - the stream is out of sync
+    static constexpr size_t MAX_MSG_SIZE = 64 * 1024;
+
+    /** Calls onMsg(char* msg) with the body of every complete message, past its STX - what the MsgHeader casts expect.
+        Returns false if bytes had to be dropped to get back in sync with the STX...ETX framing
+    */
+    template<typename OnMsgT>
+    bool OnData(char* data, const size_t len, OnMsgT onMsg) {
+        bool framed = true;
+        size_t start = 0;
+
+        ForEachMXEtx(data, len, [&](const size_t etxOffset) {
+            const size_t end = etxOffset + sizeof(ETX);
+            if(!_tail.empty()) {
+                //Completes the msg carried over from the previous read
+                _tail.insert(std::end(_tail), data, data + end);
+                framed &= _Emit(_tail.data(), _tail.size(), onMsg);
+                _tail.clear();
+            } else {
+                framed &= _Emit(data + start, end - start, onMsg);
+            }
+            start = end;
+        });
+
+        if(start < len) {
+            if(_tail.size() + len - start > MAX_MSG_SIZE) {
+                _tail.clear();
+                return false;
+            }
+            _tail.insert(std::end(_tail), data + start, data + len);
+        }
+        return framed;
+    }
+
+    //Drops any partial msg, e.g. on a new connection
+    void Reset() {
+        _tail.clear();
+    }
+
+    size_t GetPendingBytes() const {
+        return _tail.size();
+    }
+
+private:
+    template<typename OnMsgT>
+    static bool _Emit(char* frame, const size_t len, OnMsgT& onMsg) {
+        if(len < sizeof(STX) + sizeof(MsgHeader) + sizeof(ETX) || frame[0] != STX) {
+            return false;
+        }
+        onMsg(frame + sizeof(STX));
+        return true;
+    }
+
+    std::vector<char> _tail;
+};
+
+}//end namespace
+
+#endif
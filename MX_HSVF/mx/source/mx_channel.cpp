@@ -33,8 +33,17 @@ bool MX_Channel::Init(IAdapterSend* sendApi,
                       const std::string& recoveryPassword,
                       const std::string& recoveryLine,
                       const int recoveryTimeout,
-                      const int recoveryPageSize) {
+                      const int recoveryPageSize,
+                      const PacketRingConfig& bufferConfig,
+                      const int recoveryPagesInFlight,
+                      const bool compactStartupReplay,
+                      const std::string& definitionCacheDir,
+                      const bool dropUndefinedInstrumentEvents,
+                      const AsyncLogLevel logLevel) {
+    //The configured logger level - lines below it are not even encoded
+    AsyncLogger::SetLevel(logLevel);
     _sendApi = sendApi;
+    _eventBatch.SetSendApi(sendApi);
     _workerThread = workerThread;
     _networkThread = networkThread;
     _recoveryUsername = recoveryUsername;
@@ -42,6 +51,11 @@ bool MX_Channel::Init(IAdapterSend* sendApi,
     _recoveryLine = recoveryLine;
     _recoveryTimeout = recoveryTimeout;
     _recoveryPageSize = recoveryPageSize;
+    _recoveryPagesInFlight = recoveryPagesInFlight;
+    _compactStartupReplay = compactStartupReplay;
+    _definitionCacheDir = definitionCacheDir;
+    _dropUndefinedInstrumentEvents = dropUndefinedInstrumentEvents;
+    _bufferedRealtimeMsgs = PacketRing(bufferConfig);
     assert(_sendApi && _workerThread && _networkThread && _recoveryLine.size() == 2);
 
 
@@ -78,6 +92,7 @@ bool MX_Channel::Init(IAdapterSend* sendApi,
                                                     _recoveryLine,
                                                     _recoveryTimeout,
                                                     _recoveryPageSize,
+                                                    _recoveryPagesInFlight,
                                                     this);
 
     if(!ret) {
@@ -137,7 +152,15 @@ void MX_Channel::Stop() {
 void MX_Channel::OnRealtimeFeedData(const MessageMeta& mm) {
     const auto& packetBuffer = mm.pb;
     char* readPtr = packetBuffer->m_buffer;
-    _SanityCheck(packetBuffer);
+
+    //The only scan of the packet, the sanity check and the dispatch walk the index
+    if(!BuildMXFrameIndex(readPtr, packetBuffer->m_bytesReceived, _frameIndex)) {
+        assert(!"OnRealtimeFeedData() - malformed packet");
+        MX_WARN() << "channelId=" << _channelId << ", Dropping malformed packet - bytes=" << packetBuffer->m_bytesReceived
+        << ", msgs=" << _frameIndex.count;
+        return;
+    }
+    _SanityCheck(readPtr, _frameIndex);
 
     const MsgHeader* header = reinterpret_cast<const MsgHeader*>(readPtr + sizeof(STX));
     const uint64_t seqNum = header->GetSeqNum();
@@ -155,319 +178,496 @@ void MX_Channel::OnRealtimeFeedData(const MessageMeta& mm) {
         }
         ++_bufferingSkipLogCounter;
 
-        _bufferedRealtimeMsgs.push_back(mm);
-        
-        if(!_inRecovery) {
-            _inRecovery = true;
-            _recoverySequenceNumbers.clear();
-            _bufferingSkipLogCounter = 0;
-            _fromSeq = _lastRealtimeSequence + 1;
-            _toSeq = seqNum - 1;
-
-            MX_INFO() << "channelId=" << _channelId
-            << ", Requesting gap replay from=" << _fromSeq
-            << ", to=" << _toSeq
-            << ", lastSeqNo=" << _lastRealtimeSequence
-            << ", currentSeqNo=" << seqNum
-            ;
-
-            _mxRecoveryHandler.RequestGap(_fromSeq, _toSeq);
+        const MsgHeader* lastHeader = reinterpret_cast<const MsgHeader*>(_frameIndex.GetMsg(readPtr, _frameIndex.count - 1));
+        if(_inRecovery) {
+            _BufferRealtimePacket(mm, seqNum, lastHeader->GetSeqNum());
+            return;
         }
 
+        //First packet of a recovery - the buffer is empty so it is always accepted
+        _bufferedRealtimeMsgs.Push(mm);
+        _lastBufferedSequence = lastHeader->GetSeqNum();
+
+        _inRecovery = true;
+        _bufferingSkipLogCounter = 0;
+        _recoveryLostMsgs = false;
+        _isStartupRetransmission = _lastRealtimeSequence == 0;
+        _compactingReplay = _compactStartupReplay && _isStartupRetransmission;
+        _missingSequences.Clear();
+        _missingSequences.Add(_lastRealtimeSequence + 1, seqNum - 1);
+
+        MX_INFO() << "channelId=" << _channelId
+        << ", Gap detected - lastSeqNo=" << _lastRealtimeSequence
+        << ", currentSeqNo=" << seqNum
+        ;
+
+        _RequestNextGap();
         return;
     }
 
     _OnRealtimePacket(packetBuffer);
 }
 
+//_frameIndex has to describe packetBuffer
 void MX_Channel::_OnRealtimePacket(const PacketBufferPtr packetBuffer) {
-    char* readPtr = packetBuffer->m_buffer;
-    const uint32_t bytesReceived = packetBuffer->m_bytesReceived;
-
-    while(readPtr - packetBuffer->m_buffer < bytesReceived) {
-        assert(*readPtr == STX);
+    char* readPtr = _OnRealtimeMsgs(packetBuffer->m_buffer, _frameIndex);
+    MX_VALIDATE_PACKET_READ(readPtr, packetBuffer);
+}
 
-        _OnRealTimeMsg(readPtr + sizeof(STX));
+//Returns the read position after the last msg
+char* MX_Channel::_OnRealtimeMsgs(char* buffer, const MXFrameIndex& frameIndex) {
+    for(uint32_t i = 0; i < frameIndex.count; ++i) {
+        _OnRealTimeMsg(frameIndex.GetMsg(buffer, i));
+    }
+    _eventBatch.Flush();
+    return buffer + frameIndex.GetEnd();
+}
 
-        auto it = std::find(readPtr, packetBuffer->m_buffer + bytesReceived, ETX);
-        assert(*it == ETX && (it != packetBuffer->m_buffer + bytesReceived));
+void MX_Channel::_SanityCheck(char* buffer, const MXFrameIndex& frameIndex) {
+    //Note: Remove before merging - just for testing
+    if(frameIndex.count < 2) {
+        return;
+    }
 
-        readPtr = ++it;
+    for(uint32_t i = 0; i < frameIndex.count; ++i) {
+        const MsgHeader* header = reinterpret_cast<const MsgHeader*>(frameIndex.GetMsg(buffer, i));
+        if(header->msgType[0] == 'V' || header->msgType[1] == 'V') {
+            assert(!"SanityCheck() - heartbeat in a packet with other msgs");
+            MX_WARN() << "channelId=" << _channelId
+                << ", Warning - msgs=" << _GetMessageTypes(buffer, frameIndex)
+                << ", count=" << frameIndex.count;
+            return;
+        }
     }
+}
 
-    MX_VALIDATE_PACKET_READ(readPtr, packetBuffer);
+template<typename MsgT>
+void MX_Channel::_DispatchMsg(MX_Channel& self, char* msgPtr) {
+    self._Process(reinterpret_cast<const MsgT*>(msgPtr));
 }
 
-void MX_Channel::_SanityCheck(const PacketBufferPtr packetBuffer) {
-    //Note: Remove before merging - just for testing
-    std::string msgTypes;
-    int count = _GetMessageCount(packetBuffer, msgTypes);
+const MXDispatchTable<MX_Channel::MsgHandlerFn> MX_Channel::_realtimeHandlers =
+    MakeMXDispatchTable<MX_Channel::MsgHandlerFn>(MXRealtimeMsgs{},
+                                                  [](auto tag) -> MsgHandlerFn {
+                                                      using MsgT = typename std::remove_cv<typename std::remove_pointer<decltype(tag)>::type>::type;
+                                                      return &MX_Channel::_DispatchMsg<MsgT>;
+                                                  });
 
-    if(count > 1 && msgTypes.find("V") != std::string::npos) {
-        assert(!"SanityCheck() - heartbeat in a packet with other msgs");
-        MX_WARN() << "channelId=" << _channelId
-            << ", Warning - msgs=" << msgTypes 
-            << ", count=" << count;
-    }
+template<typename MsgT>
+void MX_Channel::_CompactMsg(MX_Channel& self, char* msgPtr) {
+    const MsgT* msg = reinterpret_cast<const MsgT*>(msgPtr);
+    self._replayCompactor.Add(self._instruments.GetHandle(self._GetInstrument(msg)), msg);
 }
 
+const MXDispatchTable<MX_Channel::MsgHandlerFn> MX_Channel::_compactionHandlers =
+    MakeMXDispatchTable<MX_Channel::MsgHandlerFn>(MXCompactedMsgs{},
+                                                  [](auto tag) -> MsgHandlerFn {
+                                                      using MsgT = typename std::remove_cv<typename std::remove_pointer<decltype(tag)>::type>::type;
+                                                      return &MX_Channel::_CompactMsg<MsgT>;
+                                                  });
+
 void MX_Channel::_OnRealTimeMsg(char* msgPtr, bool inRecovery) {
     const MsgHeader* header = reinterpret_cast<const MsgHeader*>(msgPtr);
-    std::string msgType = header->GetMsgType();
-    if(!msgType.empty() && msgType.back() == ' ') {
-        msgType.pop_back();
-    }
 
     _lastRealtimeSequence = header->GetSeqNum();
 
-    switch(consthash(msgType.c_str())) {
-    case consthash("H"): {
-        const OptionMarketDepth* msg = reinterpret_cast<const OptionMarketDepth*>(msgPtr);
-        _Process(msg);
-    } 
-    break;
-    case consthash("HF"): {
-        const FutureMarketDepth* msg = reinterpret_cast<const FutureMarketDepth*>(msgPtr);
-        _Process(msg);
-    } 
-    break;
-    case consthash("HB"): {
-        const FutureOptionsMarketDepth* msg = reinterpret_cast<const FutureOptionsMarketDepth*>(msgPtr);
-        _Process(msg);
+    const MsgHandlerFn handler = FindMXHandler(_realtimeHandlers, header->GetMsgTypeCode());
+    if(!handler) {
+        MX_WARN() << "channelId=" << _channelId << ", Unhandled msg=" << TrimRight(header->GetMsgType());
+        return;
     }
-    break;
-    case consthash("HS"): {
-        const StrategyMarketDepth* msg = reinterpret_cast<const StrategyMarketDepth*>(msgPtr);
-        _Process(msg);
+    handler(*this, msgPtr);
+} //end _OnRealTimeMsg
+
+void MX_Channel::OnRetransmissionMsg(char* data) {
+    const MsgHeader* header = reinterpret_cast<const MsgHeader*>(data);
+    const uint64_t seqNum = header->GetSeqNum();
+    MX_DEBUG() << "channelId=" << _channelId << ", Retransmission msg - seq=" << seqNum
+    << ", msg=" << header->msgType[0] << header->msgType[1];
+
+    //Duplicates and msgs outside of the gap are dropped
+    if(!_recoveredSequences.Mark(seqNum)) {
+        MX_WARN() << "channelId=" << _channelId << ", Dropping retransmission msg - seq=" << seqNum
+        << ", from=" << _fromSeq << ", to=" << _toSeq << ", duplicate=" << _recoveredSequences.Contains(seqNum);
+        return;
     }
-    break;
 
-    case consthash("N"): {
-        const OptionSummary* msg = reinterpret_cast<const OptionSummary*>(msgPtr);
-        _Process(msg);
-    } 
-    break;
-    case consthash("NB"): {
-        const FutureOptionsSummary* msg = reinterpret_cast<const FutureOptionsSummary*>(msgPtr);
-        _Process(msg);
-    } 
-    break;
-    case consthash("NF"): {
-        const FuturesSummary* msg = reinterpret_cast<const FuturesSummary*>(msgPtr);
-        _Process(msg);
-    } 
-    break;
-    case consthash("NS"): {
-        const StrategySummary* msg = reinterpret_cast<const StrategySummary*>(msgPtr);
-        _Process(msg);
-    } 
-    break;
-    case consthash("C"): {
-        const OptionTrade* msg = reinterpret_cast<const OptionTrade*>(msgPtr);
-        _Process(msg);
-    } 
-    break;
-    case consthash("CB"): {
-        const FutureOptionsTrade* msg = reinterpret_cast<const FutureOptionsTrade*>(msgPtr);
-        _Process(msg);
-    } 
-    break;
-    case consthash("CF"): {
-        const FuturesTrade* msg = reinterpret_cast<const FuturesTrade*>(msgPtr);
-        _Process(msg);
-    } 
-    break;
-    case consthash("CS"): {
-        const StrategyTrade* msg = reinterpret_cast<const StrategyTrade*>(msgPtr);
-        _Process(msg);
-    } 
-    break;
-    case consthash("GS"): {
-        const GroupStatusStrategies* msg = reinterpret_cast<const GroupStatusStrategies*>(msgPtr);
-        _Process(msg);
-    } 
-    break;
-    case consthash("GR"): {
-        const GroupStatus* msg = reinterpret_cast<const GroupStatus*>(msgPtr);
-        _Process(msg);
-    } 
-    break;
-    case consthash("V"): {
-        const Heartbeat* msg = reinterpret_cast<const Heartbeat*>(msgPtr);
-        _Process(msg);
-    } 
-    break;
-    case consthash("J"): {
-        const OptionInstrumentKeys* msg = reinterpret_cast<const OptionInstrumentKeys*>(msgPtr);
-        _Process(msg);
-    } 
-    break;
-    case consthash("JB"): {
-        const FutureOptionsInstrumentKeys* msg = reinterpret_cast<const FutureOptionsInstrumentKeys*>(msgPtr);
-        _Process(msg);
-    } 
-    break;
-    case consthash("JF"): {
-        const FuturesInstrumentKeys* msg = reinterpret_cast<const FuturesInstrumentKeys*>(msgPtr);
-        _Process(msg);
-    } 
-    break;
-    case consthash("JS"): {
-        const StrategyInstrumentKeys* msg = reinterpret_cast<const StrategyInstrumentKeys*>(msgPtr);
-        _Process(msg);
-    } 
-    break;
-    case consthash("Q"): {
-        const BeginningOfOptionsSummary* msg = reinterpret_cast<const BeginningOfOptionsSummary*>(msgPtr);
-        _Process(msg);
-    } 
-    break;
-    case consthash("QB"): {
-        const BeginningOfFutureOptionsSummary* msg = reinterpret_cast<const BeginningOfFutureOptionsSummary*>(msgPtr);
-        _Process(msg);
-    } 
-    break;
-    case consthash("QF"): {
-        const BeginningOfFuturesSummary* msg = reinterpret_cast<const BeginningOfFuturesSummary*>(msgPtr);
-        _Process(msg);
-    } 
-    break;
-    case consthash("QS"): {
-        const BeginningOfStrategySummary* msg = reinterpret_cast<const BeginningOfStrategySummary*>(msgPtr);
-        _Process(msg);
-    } 
-    break;
-    case consthash("D"): {
-        const OptionRequestForQuote* msg = reinterpret_cast<const OptionRequestForQuote*>(msgPtr);
-        _Process(msg);
-    } 
-    break;
-    case consthash("DF"): {
-        const FuturesRequestForQuote* msg = reinterpret_cast<const FuturesRequestForQuote*>(msgPtr);
-        _Process(msg);
-    } 
-    break;
-    case consthash("DB"): {
-        const FutureOptionsRequestForQuote* msg = reinterpret_cast<const FutureOptionsRequestForQuote*>(msgPtr);
-        _Process(msg);
+    //Already applied from a buffered packet
+    if(!_inRecovery || seqNum <= _lastRealtimeSequence) {
+        return;
     }
-    break;
-    case consthash("DS"): {
-        const StrategyRequestForQuote* msg = reinterpret_cast<const StrategyRequestForQuote*>(msgPtr);
-        _Process(msg);
-    } 
-    break;
-    case consthash("TT"): {
-        const TickTable* msg = reinterpret_cast<const TickTable*>(msgPtr);
-        _Process(msg);
-    } 
-    break;
-    case consthash("KF"): {
-        const FutureDeliverables* msg = reinterpret_cast<const FutureDeliverables*>(msgPtr);
-        _Process(msg);
-    } 
-    break;
-    case consthash("SD"): {
-        const StartOfDay* msg = reinterpret_cast<const StartOfDay*>(msgPtr);
-        _Process(msg);
-    } 
-    break;
-    case consthash("U"): {
-        const EndOfTransmission* msg = reinterpret_cast<const EndOfTransmission*>(msgPtr);
-        _Process(msg);
-    } 
-    break;
-    case consthash("S"): {
-        const EndOfSales* msg = reinterpret_cast<const EndOfSales*>(msgPtr);
-        _Process(msg);
-    } 
-    break;
-   
-    default: {
-        MX_WARN() << "channelId=" << _channelId << ", Unhandled msg=" << msgType;
-    } 
-    break;
 
-    }//end switch
+    //Past a hole the server skipped - held until the hole is asked for again and filled
+    if(seqNum > _lastRealtimeSequence + 1) {
+        _heldRetransmissionMsgs.Push(seqNum, data);
+        return;
+    }
+    _ApplyRetransmissionMsg(data);
+    _ApplyHeldMsgs(false);
 
-} //end _OnRealTimeMsg
+    //The recovered prefix reached the buffered packets - they go out now, not once the retransmission ends
+    if(!_missingSequences.Contains(_lastRealtimeSequence + 1)) {
+        _CatchUp();
+    }
+}
 
-void MX_Channel::OnRetransmissionMsg(char* data) {
+void MX_Channel::_ApplyRetransmissionMsg(char* data) {
     const MsgHeader* header = reinterpret_cast<const MsgHeader*>(data);
-    const uint64_t seqNum = header->GetSeqNum();
-    const std::string msgType = header->GetMsgType();
-    MX_DEBUG() << "channelId=" << _channelId << ", Retransmission msg - seq=" << seqNum << ", msg=" << msgType;
 
-    assert(_fromSeq <= seqNum && seqNum <= _toSeq);
+    //Already restored from the definition cache
+    if(_IsCachedDefinition(header)) {
+        _lastRealtimeSequence = header->GetSeqNum();
+    } else if(!_CompactReplayMsg(data)) {
+        _OnRealTimeMsg(data, true);
+        _eventBatch.Flush();
+    }
+}
+
+//The msgs held past a hole, as far as they follow on. overHoles - the holes were given up, all of them
+void MX_Channel::_ApplyHeldMsgs(const bool overHoles) {
+    for(; !_heldRetransmissionMsgs.Empty(); _heldRetransmissionMsgs.Pop()) {
+        const uint64_t seqNum = _heldRetransmissionMsgs.GetSeqNum();
+        if(seqNum <= _lastRealtimeSequence) {
+            continue;
+        }
+        if(seqNum > _lastRealtimeSequence + 1) {
+            if(!overHoles) {
+                return;
+            }
+            MX_WARN() << "channelId=" << _channelId << ", Applying retransmission msgs past a lost hole - from=" << _lastRealtimeSequence + 1
+            << ", to=" << seqNum - 1;
+        }
+        _ApplyRetransmissionMsg(_heldRetransmissionMsgs.GetMsg());
+    }
+}
+
+//Startup replay - depth and summary msgs only update the compacted state, applied once the replay reaches the buffered
+//packets. Keys, tick tables and trades still go through in order. Returns false if the msg is to be processed as usual
+bool MX_Channel::_CompactReplayMsg(char* msg) {
+    if(!_compactingReplay) {
+        return false;
+    }
+
+    const MsgHeader* header = reinterpret_cast<const MsgHeader*>(msg);
+    const uint16_t code = header->GetMsgTypeCode();
+    const MsgHandlerFn handler = FindMXHandler(_compactionHandlers, code);
+    if(handler) {
+        _lastRealtimeSequence = header->GetSeqNum();
+        handler(*this, msg);
+        return true;
+    }
+
+    //A group status overrides the status markers of the depth msgs before it - those must not be applied after it
+    if(code == MXMsgType<GroupStatus>::CODE || code == MXMsgType<GroupStatusStrategies>::CODE) {
+        _ApplyCompactedMsgs();
+    }
+    return false;
+}
 
-    //Sanity check - making sure no duplicates. Delete before going to prod
-    const bool newSeqNum = _recoverySequenceNumbers.count(seqNum) == 0;
-    assert(newSeqNum);
-    _recoverySequenceNumbers.insert(seqNum);
+//Processes the compacted state as synthetic msgs, in the order of the msgs it was last updated by
+void MX_Channel::_ApplyCompactedMsgs() {
+    if(_replayCompactor.IsEmpty()) {
+        return;
+    }
+    MX_INFO() << "channelId=" << _channelId << ", applying compacted replay msgs - compacted=" << _replayCompactor.GetCompacted()
+    << ", lastSeqNo=" << _lastRealtimeSequence;
 
-    _OnRealTimeMsg(data, true);
+    _replayCompactor.Drain([this](char* msg) {
+        const MsgHeader* header = reinterpret_cast<const MsgHeader*>(msg);
+        const MsgHandlerFn handler = FindMXHandler(_realtimeHandlers, header->GetMsgTypeCode());
+        assert(handler);
+        handler(*this, msg);
+        _eventBatch.Flush();
+    });
 }
 
 void MX_Channel::OnRetransmissionComplete() {
     MX_INFO() << "channelId=" << _channelId << ", Retransmission complete"
     << " - from=" << _fromSeq 
     << ", to=" << _toSeq 
-    << ", isStartupRetransmission=" << _IsStartupRetransmission();
-    _CompleteRecovery();
+    << ", isStartupRetransmission=" << _IsStartupRetransmission()
+    << ", inRecovery=" << _inRecovery
+    << ", gapRequestPending=" << _gapRequestPending;
+    //Caught up before the end of the retransmission, or the session is about to be replaced
+    if(!_inRecovery || _gapRequestPending) {
+        return;
+    }
+    if(_RequestMissing()) {
+        return;
+    }
+    _OnGapRecovered();
 }
 
 void MX_Channel::OnRetransmissionFailed() {
-    MX_WARN() << "channelId=" << _channelId << ", Retransmission failed!";
-    _CompleteRecovery();
+    MX_WARN() << "channelId=" << _channelId << ", Retransmission failed! inRecovery=" << _inRecovery
+    << ", gapRequestPending=" << _gapRequestPending;
+    if(!_inRecovery || _gapRequestPending) {
+        return;
+    }
+    if(_RequestMissing()) {
+        return;
+    }
+    _OnGapRecovered();
+}
+
+//Asks again for the first sub range of the gap still missing. Returns false once the gap is covered or the retries
+//are used up - the gap is done with whatever arrived
+bool MX_Channel::_RequestMissing() {
+    if(_recoveredSequences.IsComplete()) {
+        return false;
+    }
+
+    uint64_t holes = 0;
+    uint64_t holeFrom = 0;
+    uint64_t holeTo = 0;
+    _recoveredSequences.ForEachMissing([&](const uint64_t from, const uint64_t to) {
+        if(holes++ == 0) {
+            holeFrom = from;
+            holeTo = to;
+        }
+    });
+
+    MX_WARN() << "channelId=" << _channelId << ", Retransmission incomplete"
+    << " - recovered=" << _recoveredSequences.GetCount() << "/" << _recoveredSequences.GetSize()
+    << ", holes=" << holes
+    << ", firstHoleFrom=" << holeFrom
+    << ", firstHoleTo=" << holeTo
+    << ", holeRequests=" << _holeRequests;
+
+    if(_holeRequests >= MAX_HOLE_REQUESTS) {
+        return false;
+    }
+    ++_holeRequests;
+    _PostGapRequest(holeFrom, holeTo);
+    return true;
+}
+
+//Requests the first missing range, merged with the ones after it that are less than a page apart
+void MX_Channel::_RequestNextGap() {
+    const MXGapSet::Range range = _missingSequences.GetNextRequest(_recoveryPageSize);
+    _fromSeq = range.first;
+    _toSeq = range.second;
+    _recoveredSequences.Reset(_fromSeq, _toSeq);
+    _holeRequests = 0;
+    _gapInFlight = true;
+
+    MX_INFO() << "channelId=" << _channelId
+    << ", Requesting gap replay from=" << _fromSeq
+    << ", to=" << _toSeq
+    << ", missingRanges=" << _missingSequences.GetRanges()
+    << ", missing=" << _missingSequences.GetMissing()
+    << ", lastSeqNo=" << _lastRealtimeSequence
+    << ", lastBufferedSeqNo=" << _lastBufferedSequence
+    ;
+
+    _PostGapRequest(_fromSeq, _toSeq);
+}
+
+//Issued off the worker thread queue, never from inside a recovery handler callback - the handler would still be
+//working on the session the request replaces. Only the latest request goes out
+void MX_Channel::_PostGapRequest(const uint64_t from, const uint64_t to) {
+    const uint64_t gapRequest = ++_gapRequests;
+    _gapRequestPending = true;
+    Post([this, gapRequest, from, to]() {
+        if(gapRequest != _gapRequests) {
+            return;
+        }
+        _gapRequestPending = false;
+        if(_inRecovery) {
+            _mxRecoveryHandler.RequestGap(from, to);
+        }
+    });
+}
+
+//The requested range is done, recovered or given up
+void MX_Channel::_OnGapRecovered() {
+    _recoveryLostMsgs |= !_recoveredSequences.IsComplete();
+    _ApplyHeldMsgs(true);
+    _missingSequences.Remove(_fromSeq, _toSeq);
+    _gapInFlight = false;
+    _CatchUp();
+}
+
+//Applies what the recovered prefix unblocked - the compacted replay state, then the buffered packets up to the next
+//missing range, a batch per worker turn. Requests that range as soon as the one in flight is covered, leaves recovery
+//once none is left
+void MX_Channel::_CatchUp() {
+    _ApplyCompactedMsgs();
+    //Buffered live packets are applied from here on and bypass the compactor - its level images would go stale,
+    //the rest of the replay is applied as it comes
+    if(_compactingReplay) {
+        _compactingReplay = false;
+        _replayCompactor.Clear();
+    }
+    if(!_ProcessBufferedMsgs()) {
+        _PostCatchUp();
+        return;
+    }
+
+    _missingSequences.Remove(0, _lastRealtimeSequence);
+    if(_missingSequences.Empty()) {
+        _CompleteRecovery();
+        return;
+    }
+    if(!_gapInFlight || _lastRealtimeSequence >= _toSeq) {
+        _RequestNextGap();
+    }
+}
+
+//The rest of the buffered packets after whatever else is queued on the worker thread
+void MX_Channel::_PostCatchUp() {
+    if(_catchUpPosted) {
+        return;
+    }
+    _catchUpPosted = true;
+    Post([this]() {
+        _catchUpPosted = false;
+        if(_inRecovery) {
+            _CatchUp();
+        }
+    });
 }
 
 void MX_Channel::_CompleteRecovery() {
+    _replayCompactor.Clear();
+    _SaveDefinitions();
     _GoStable();
-    _ProcessBufferedMsgs();
     _SendEndForChannel();
     _inRecovery = false;
 }
 
 void MX_Channel::_SendEndForChannel() {
-    MX_INFO() << "channelId=" << _channelId << ", Sending snapshot end for " << _securityIds.size() << " instruments, inRecovery=" << _inRecovery;
+    MX_INFO() << "channelId=" << _channelId << ", Sending snapshot end for " << _descriptors.GetSize() << " instruments, inRecovery=" << _inRecovery;
 
     MarketEvent event;
     event.channelId = _channelId;
     event.type = MarketEventType::EventEnd;
 
-    for(const auto& entry: _securityIds) {
-        event.indesc = entry;
+    _eventBatch.Flush();
+    _descriptors.ForEach([&](const Descriptor_t indesc, const MXInstrumentHandle) {
+        event.indesc = indesc;
         if(_IsStartupRetransmission())
             _sendApi->OnSnapshot(&event);
         else
-            _sendApi->OnIncremental(&event);
-    }
+            _SendMarketEvent(event);
+    });
+    _eventBatch.Flush();
+}
+
+//Releases the buffered packets the recovered prefix reaches, up to the next range still missing and at most
+//CATCH_UP_PACKETS of them. Returns false if it stopped at that limit
+bool MX_Channel::_ProcessBufferedMsgs() {
+    MX_INFO() << "channelId=" << _channelId << ", processing buffered msgs - size=" << _bufferedRealtimeMsgs.GetSize() 
+    << ", bytes=" << _bufferedRealtimeMsgs.GetBytes()
+    << ", arenaBytes=" << _bufferedRealtimeMsgs.GetArenaBytes()
+    << ", highWaterPackets=" << _bufferedRealtimeMsgs.GetHighWaterPackets()
+    << ", highWaterBytes=" << _bufferedRealtimeMsgs.GetHighWaterBytes()
+    << ", inRecovery=" << _inRecovery;
+    
+    uint32_t packets = 0;
+    bool limited = false;
+    _bufferedRealtimeMsgs.DrainWhile([&](char* buffer, const size_t len) {
+        if(packets == CATCH_UP_PACKETS) {
+            limited = true;
+            return false;
+        }
+        if(!BuildMXFrameIndex(buffer, len, _frameIndex)) {
+            assert(!"_ProcessBufferedMsgs() - malformed packet");
+            MX_WARN() << "channelId=" << _channelId << ", Skipping malformed buffered packet - bytes=" << len;
+            ++packets;
+            return true;
+        }
+
+        const MsgHeader* header = reinterpret_cast<const MsgHeader*>(buffer + sizeof(STX));
+        const uint64_t seqNum = header->GetSeqNum();
+        if(seqNum > _lastRealtimeSequence + 1) {
+            //Still to be recovered
+            if(_missingSequences.Contains(_lastRealtimeSequence + 1)) {
+                return false;
+            }
+            MX_WARN() << "channelId=" << _channelId << ", Skipping unrecovered msgs - from=" << _lastRealtimeSequence + 1
+            << ", to=" << seqNum - 1;
+        }
+
+        //Msgs the retransmission already delivered are skipped
+        for(uint32_t i = 0; i < _frameIndex.count; ++i) {
+            char* msg = _frameIndex.GetMsg(buffer, i);
+            if(reinterpret_cast<const MsgHeader*>(msg)->GetSeqNum() > _lastRealtimeSequence) {
+                _OnRealTimeMsg(msg);
+            }
+        }
+        _eventBatch.Flush();
+        ++packets;
+        return true;
+    });
+
+    MX_INFO() << "channelId=" << _channelId << ", finished processing buffered msgs - processed=" << packets << ", size=" << _bufferedRealtimeMsgs.GetSize() << ", inRecovery=" << _inRecovery;
+    return !limited;
 }
 
-void MX_Channel::_ProcessBufferedMsgs() {
-    MX_INFO() << "channelId=" << _channelId << ", processing buffered msgs - size=" << _bufferedRealtimeMsgs.size() << ", inRecovery=" << _inRecovery;
-    
-    while(!_bufferedRealtimeMsgs.empty()) {
-        const auto& currentPacket = _bufferedRealtimeMsgs.front();
-        const auto& packetBuffer = currentPacket.pb;
+//Live packet while recovering. A jump past the last buffered seqNum is one more missing range, requested once the
+//ranges before it are recovered. Packets the buffer already covers are dropped
+void MX_Channel::_BufferRealtimePacket(const MessageMeta& mm, const uint64_t seqNum, const uint64_t lastSeqNum) {
+    if(lastSeqNum <= _lastBufferedSequence) {
+        MX_DEBUG() << "channelId=" << _channelId << ", Dropping stale packet while recovering - seq=" << seqNum
+        << ", lastBufferedSeqNo=" << _lastBufferedSequence;
+        return;
+    }
 
-        _OnRealtimePacket(packetBuffer);
-        _bufferedRealtimeMsgs.pop_front();
+    if(!_bufferedRealtimeMsgs.Push(mm)) {
+        _RestartRecovery(mm, seqNum, lastSeqNum);
+        return;
     }
 
-    MX_INFO() << "channelId=" << _channelId << ", finished processing buffered msgs - size=" << _bufferedRealtimeMsgs.size() << ", inRecovery=" << _inRecovery;
+    if(seqNum > _lastBufferedSequence + 1) {
+        _missingSequences.Add(_lastBufferedSequence + 1, seqNum - 1);
+        MX_WARN() << "channelId=" << _channelId << ", Gap while recovering - from=" << _lastBufferedSequence + 1
+        << ", to=" << seqNum - 1
+        << ", missingRanges=" << _missingSequences.GetRanges()
+        << ", missing=" << _missingSequences.GetMissing();
+    }
+    _lastBufferedSequence = lastSeqNum;
+}
+
+//Buffer limit hit - drop the buffered tail and widen the gap request up to this packet.
+//Whatever the retransmission already delivered is kept, the new request starts after it
+void MX_Channel::_RestartRecovery(const MessageMeta& mm, const uint64_t seqNum, const uint64_t lastSeqNum) {
+    MX_WARN() << "channelId=" << _channelId << ", recovery buffer full, restarting recovery"
+    << " - buffered=" << _bufferedRealtimeMsgs.GetSize()
+    << ", bytes=" << _bufferedRealtimeMsgs.GetBytes()
+    << ", from=" << _fromSeq
+    << ", to=" << _toSeq
+    << ", missingRanges=" << _missingSequences.GetRanges()
+    << ", lastSeqNo=" << _lastRealtimeSequence
+    << ", currentSeqNo=" << seqNum
+    << ", overflows=" << _bufferedRealtimeMsgs.GetOverflows();
+
+    _bufferedRealtimeMsgs.Clear();
+    _heldRetransmissionMsgs.Clear();    //asked for again
+    if(!_bufferedRealtimeMsgs.Push(mm)) {
+        assert(!"_RestartRecovery - empty buffer rejected a packet");
+    }
+    _lastBufferedSequence = lastSeqNum;
+    _missingSequences.Clear();
+    _missingSequences.Add(_lastRealtimeSequence + 1, seqNum - 1);
+    //Empty if the retransmission in flight already caught up with this packet
+    if(_missingSequences.Empty()) {
+        _CatchUp();
+        return;
+    }
+    _RequestNextGap();
 }
 
 
 
 template<typename MsgT>
-Descriptor_t MX_Channel::_GetIndesc(const MsgT* msg) {
-    return consthash(msg->GetIdentifier().c_str());
+MXInstrumentState& MX_Channel::_GetInstrument(const MsgT* msg) {
+    return _instruments.Intern(msg->GetInstrumentKey());
 }
 
 template<typename MsgT>
-void MX_Channel::_InitMarketEvent(const MsgT* msg, MarketEvent& event) {
-    event.indesc = _GetIndesc(msg);
+void MX_Channel::_InitMarketEvent(const MsgT* msg, MXInstrumentState& instrument, MarketEvent& event) {
+    event.indesc = _GetDescriptor(instrument);
     event.channelId = _channelId;
     const uint64_t seqNum = msg->msgHeader.GetSeqNum();
     event.messageSequence = event.packetSequence = seqNum;
@@ -475,13 +675,30 @@ void MX_Channel::_InitMarketEvent(const MsgT* msg, MarketEvent& event) {
 }
 
 template<typename InstrumentKeysMsgT>
-void MX_Channel::_CacheGroupInfo(const InstrumentKeysMsgT* msg) {
-    _outrightGroupToDescs[msg->GetRootSymbol()].push_back(msg->GetIdentifier());
+void MX_Channel::_CacheGroupInfo(const InstrumentKeysMsgT* msg, const MXInstrumentHandle handle) {
+    _AddToGroup(handle, msg->GetRootSymbol(), false);
 }
 
 template<>
-void MX_Channel::_CacheGroupInfo(const StrategyInstrumentKeys* msg) {
-   _strategyGroupToDescs[msg->GetGroup()].push_back(msg->GetIdentifier());
+void MX_Channel::_CacheGroupInfo(const StrategyInstrumentKeys* msg, const MXInstrumentHandle handle) {
+    _AddToGroup(handle, msg->GetGroup(), true);
+}
+
+//Once per instrument - a definition processed again keeps the instrument listed once, moved if its group changed
+void MX_Channel::_AddToGroup(const MXInstrumentHandle handle, const std::string& group, const bool isStrategy) {
+    MXInstrumentState& instrument = _instruments.Get(handle);
+    MXDefinitionSource& source = instrument.source;
+    if(instrument.grouped) {
+        if(source.group == group && source.isStrategy == isStrategy) {
+            return;
+        }
+        std::vector<MXInstrumentHandle>& handles = (source.isStrategy ? _strategyGroupToDescs : _outrightGroupToDescs)[source.group];
+        handles.erase(std::remove(std::begin(handles), std::end(handles), handle), std::end(handles));
+    }
+    source.group = group;
+    source.isStrategy = isStrategy;
+    instrument.grouped = true;
+    (isStrategy ? _strategyGroupToDescs : _outrightGroupToDescs)[group].push_back(handle);
 }
 
 
@@ -490,45 +707,57 @@ void MX_Channel::_ProcessMarketDepthMsg(const MarketDepthMsgT* msg) {
     MX_DEBUG() << "channelId=" << _channelId << ", MarketDepthMsg - " << msg->ToString();
     static const int IMPLIED_LEVEL = 0;
 
-    const int levels = msg->GetLevelsNum();
-    assert(levels > 0);
+    //From the wire - never past decodedLevels below, whatever a malformed msg says
+    assert(msg->GetLevelsNum() > 0 && msg->GetLevelsNum() <= static_cast<int>(MX_DEPTH_LEVELS));
+    const int levels = std::min(msg->GetLevelsNum(), static_cast<int>(MX_DEPTH_LEVELS));
 
+    MXInstrumentState& instrument = _GetInstrument(msg);
+    MXOrderbook orderbook = _instruments.GetOrderbook(_instruments.GetHandle(instrument));
     MarketEvent event;
-    _InitMarketEvent(msg, event);
+    _InitMarketEvent(msg, instrument, event);
     event.type = ns::MarketEventType::LevelBook;
 
+    //Each level is decoded once, bids and asks below read from here
+    MXDecodedLevel decodedLevels[MX_DEPTH_LEVELS];
+    for(int i = 0; i < levels; ++i) {
+        decodedLevels[i] = msg->depthLevels[i].Decode();
+    }
+
     //Bids
     for(int i = 0; i < levels; ++i) {
         auto& currentLevel = msg->depthLevels[i];
+        const MXDecodedLevel& decoded = decodedLevels[i];
         const int currentDepthLevel = currentLevel.GetLevel();
         /** As per doc:
             "Level of market depth 1 to 5 and A (Implied)"
         */
         if(currentLevel.level == 'A') {
-            const int32_t bidSize = currentLevel.GetBidSize();
+            const int32_t bidSize = decoded.bidSize;
             if(bidSize != 0) {
-                const int32_t bidOrdersNum = currentLevel.GetBidOrdersNum();
-                int64_t bidPrice = currentLevel.GetBidPrice();
-                AdjustPrice(msg->GetIdentifier(), currentLevel.GetBidPriceFI(), bidPrice, _decimals);
+                const int32_t bidOrdersNum = decoded.bidOrdersNum;
+                int64_t bidPrice = decoded.bidPrice;
+                AdjustPrice(instrument, currentLevel.GetBidPriceFI(), bidPrice);
                 _PopulateMarketEventOnMarketDepth(event, MarketBookSide::ImpliedBid, MarketUpdateAction::NewOrChange, bidSize, bidPrice, bidOrdersNum, IMPLIED_LEVEL);
                 _SendMarketEvent(event);
+                orderbook.OnNewOrChange(MarketBookSide::ImpliedBid, MX_IMPLIED_SLOT, bidPrice, bidSize);
             } else {
                 _PopulateMarketEventOnMarketDepth(event, MarketBookSide::ImpliedBid, MarketUpdateAction::Delete, IMPLIED_LEVEL);
                 _SendMarketEvent(event);
+                orderbook.OnDeleteFrom(MarketBookSide::ImpliedBid, MX_IMPLIED_SLOT);
             }
         } else {
-            const int32_t bidSize = currentLevel.GetBidSize();
+            const int32_t bidSize = decoded.bidSize;
             if(bidSize != 0) {    
-                const int32_t bidOrdersNum = currentLevel.GetBidOrdersNum();
-                int64_t bidPrice = currentLevel.GetBidPrice();
-                AdjustPrice(msg->GetIdentifier(), currentLevel.GetBidPriceFI(), bidPrice, _decimals); 
+                const int32_t bidOrdersNum = decoded.bidOrdersNum;
+                int64_t bidPrice = decoded.bidPrice;
+                AdjustPrice(instrument, currentLevel.GetBidPriceFI(), bidPrice); 
                 _PopulateMarketEventOnMarketDepth(event, MarketBookSide::Bid, MarketUpdateAction::NewOrChange, bidSize, bidPrice, bidOrdersNum, currentDepthLevel);
                 _SendMarketEvent(event);
-                _orderbooks.NewOrChange(msg->GetIdentifier(), MarketBookSide::Bid, currentDepthLevel, bidPrice, bidSize);
+                orderbook.OnNewOrChange(MarketBookSide::Bid, currentDepthLevel, bidPrice, bidSize);
             } else if(bidSize == 0) {
                 _PopulateMarketEventOnMarketDepth(event, MarketBookSide::Bid, MarketUpdateAction::DeleteFrom, currentDepthLevel);
                 _SendMarketEvent(event);
-                _orderbooks.DeleteFrom(msg->GetIdentifier(), MarketBookSide::Bid, currentDepthLevel);
+                orderbook.OnDeleteFrom(MarketBookSide::Bid, currentDepthLevel);
             }
         }
     } //end bids
@@ -536,43 +765,46 @@ void MX_Channel::_ProcessMarketDepthMsg(const MarketDepthMsgT* msg) {
     //Asks
     for(int i = 0; i < levels; ++i) {
         auto& currentLevel = msg->depthLevels[i];
+        const MXDecodedLevel& decoded = decodedLevels[i];
         const int currentDepthLevel = currentLevel.GetLevel();
         if(currentLevel.level == 'A') {
-            const int32_t askSize = currentLevel.GetAskSize();
+            const int32_t askSize = decoded.askSize;
             if(askSize != 0) {
-                const int32_t askOrdersNum = currentLevel.GetBidOrdersNum();
-                int64_t askPrice = currentLevel.GetAskPrice();
-                AdjustPrice(msg->GetIdentifier(), currentLevel.GetAskPriceFI(), askPrice, _decimals);
+                const int32_t askOrdersNum = decoded.bidOrdersNum;
+                int64_t askPrice = decoded.askPrice;
+                AdjustPrice(instrument, currentLevel.GetAskPriceFI(), askPrice);
                 _PopulateMarketEventOnMarketDepth(event, MarketBookSide::ImpliedAsk, MarketUpdateAction::NewOrChange, askSize, askPrice, askOrdersNum, IMPLIED_LEVEL);
                 _SendMarketEvent(event);
+                orderbook.OnNewOrChange(MarketBookSide::ImpliedAsk, MX_IMPLIED_SLOT, askPrice, askSize);
             } else {
                 _PopulateMarketEventOnMarketDepth(event, MarketBookSide::ImpliedAsk, MarketUpdateAction::Delete, IMPLIED_LEVEL);
                 _SendMarketEvent(event);
+                orderbook.OnDeleteFrom(MarketBookSide::ImpliedAsk, MX_IMPLIED_SLOT);
             }
         } else {
-            const int32_t askSize = currentLevel.GetAskSize();
+            const int32_t askSize = decoded.askSize;
             if(askSize != 0) {
-                const int32_t askOrdersNum = currentLevel.GetAskOrdersNum();
-                int64_t askPrice = currentLevel.GetAskPrice();
-                AdjustPrice(msg->GetIdentifier(), currentLevel.GetAskPriceFI(), askPrice, _decimals);
+                const int32_t askOrdersNum = decoded.askOrdersNum;
+                int64_t askPrice = decoded.askPrice;
+                AdjustPrice(instrument, currentLevel.GetAskPriceFI(), askPrice);
                 _PopulateMarketEventOnMarketDepth(event, MarketBookSide::Ask, MarketUpdateAction::NewOrChange, askSize, askPrice, askOrdersNum, currentDepthLevel);
                 _SendMarketEvent(event);
-                _orderbooks.NewOrChange(msg->GetIdentifier(), MarketBookSide::Ask, currentDepthLevel, askPrice, askSize);
+                orderbook.OnNewOrChange(MarketBookSide::Ask, currentDepthLevel, askPrice, askSize);
             } else if(askSize == 0) {
                 _PopulateMarketEventOnMarketDepth(event, MarketBookSide::Ask, MarketUpdateAction::DeleteFrom, currentDepthLevel);
                 _SendMarketEvent(event);
-                _orderbooks.DeleteFrom(msg->GetIdentifier(), MarketBookSide::Ask, currentDepthLevel);
+                orderbook.OnDeleteFrom(MarketBookSide::Ask, currentDepthLevel);
             }
         }
     } //end asks
 
 
-    _HandleStatusUpdate(msg);
+    _HandleStatusUpdate(msg, instrument);
 
     const char status = msg->GetStatusMarker();
     if(status != StatusMarker::ContinuousTrading) {
         //Why are we doing this?? Talk to team
-        _HandleTheoreticalOpeningUpdate(msg);
+        _HandleTheoreticalOpeningUpdate(msg, instrument);
     }
 
     _SendMarketEventEnd(event);
@@ -603,40 +835,38 @@ void MX_Channel::_PopulateMarketEventOnMarketDepth(MarketEvent& event,
 }
 
 template<typename MarketDepthMsgT>
-void MX_Channel::_HandleStatusUpdate(const MarketDepthMsgT* msg) {
+void MX_Channel::_HandleStatusUpdate(const MarketDepthMsgT* msg, MXInstrumentState& instrument) {
     const char statusMarker = msg->GetStatusMarker();
-    const std::string identifier = msg->GetIdentifier();
 
-    auto it = _cachedStatusMarkerPerInstrument.find(identifier);
-    if(std::end(_cachedStatusMarkerPerInstrument) == it || statusMarker != it->second) {
-        _CacheInstrumentStatus(identifier, statusMarker);
+    if(statusMarker != instrument.statusMarker) {
+        _CacheInstrumentStatus(instrument, statusMarker);
 
         MarketEvent event;
-        _InitMarketEvent(msg, event);
+        _InitMarketEvent(msg, instrument, event);
         const auto ttStatus = _GetStatus(statusMarker);
         event.type = MarketEventType::Status;
         event.entry.status.val = ttStatus;
         _SendMarketEvent(event);
 
-        MX_INFO() << "channelId=" << _channelId << ", Status update for identifier=" << identifier << ", mxStatus=" << +statusMarker << ", ttStatus=" << ttStatus;
+        MX_INFO() << "channelId=" << _channelId << ", Status update for identifier=" << instrument.identifier << ", mxStatus=" << +statusMarker << ", ttStatus=" << ttStatus;
     }
 }
 
 template<typename MarketDepthMsgT>
-void MX_Channel::_HandleTheoreticalOpeningUpdate(const MarketDepthMsgT* msg) {
-    auto info = _orderbooks.TopBidEqualsTopAsk(msg->GetIdentifier());
+void MX_Channel::_HandleTheoreticalOpeningUpdate(const MarketDepthMsgT* msg, MXInstrumentState& instrument) {
+    auto info = _instruments.GetOrderbook(_instruments.GetHandle(instrument)).TopBidEqualsTopAsk();
     const bool isNewUpdate = std::get<0>(info); 
     const int64_t price = std::get<1>(info);
     const int32_t qty = std::get<2>(info);  
 
-    MX_DEBUG() << "channelId=" << _channelId << ", TheoreticalOpening - securityId=" << msg->GetIdentifier() 
+    MX_DEBUG() << "channelId=" << _channelId << ", TheoreticalOpening - securityId=" << instrument.identifier 
     << ", newUpdate=" << isNewUpdate
     << ", price=" << price
     << ", qty=" << qty
     ;
 
     MarketEvent event;
-    _InitMarketEvent(msg, event);
+    _InitMarketEvent(msg, instrument, event);
     event.type = MarketEventType::StatPrice;
     event.entry.stat_price.action = MarketUpdateAction::New;
     event.entry.stat_price.id = StatPriceID::IndOpenPrc;
@@ -675,14 +905,15 @@ template<typename SummaryMsgT>
 void MX_Channel::_ProcessSummaryMsg(const SummaryMsgT* msg) {
     MX_DEBUG() << "channelId=" << _channelId << ", SummaryMsg - " << msg->ToString();
 
-    const std::string identifier = msg->GetIdentifier();
+    MXInstrumentState& instrument = _GetInstrument(msg);
+    const std::string& identifier = instrument.identifier;
     int64_t highPrice = msg->GetHighPrice();
     int64_t lowPrice = msg->GetLowPrice();
     int64_t openPrice = msg->GetOpenPrice();
 
-    AdjustPrice(identifier, msg->GetHighPriceFractionIndicator(), highPrice, _decimals);
-    AdjustPrice(identifier, msg->GetLowPriceFractionIndicator(), lowPrice, _decimals);
-    AdjustPrice(identifier, msg->GetOpenPriceFractionIndicator(), openPrice, _decimals);
+    AdjustPrice(instrument, msg->GetHighPriceFractionIndicator(), highPrice);
+    AdjustPrice(instrument, msg->GetLowPriceFractionIndicator(), lowPrice);
+    AdjustPrice(instrument, msg->GetOpenPriceFractionIndicator(), openPrice);
 
     const int64_t volume = msg->GetVolume();
     const char reason = msg->GetReason();
@@ -698,7 +929,7 @@ void MX_Channel::_ProcessSummaryMsg(const SummaryMsgT* msg) {
  
 
     MarketEvent event;
-    _InitMarketEvent(msg, event);
+    _InitMarketEvent(msg, instrument, event);
     event.type = MarketEventType::StatPrice;
     event.entry.stat_price.action = MarketUpdateAction::New;
 
@@ -729,18 +960,18 @@ void MX_Channel::_ProcessSummaryMsg(const SummaryMsgT* msg) {
         _SendMarketEvent(event);
     }
 
-    _HandleSettlementUpdate(msg, event);
+    _HandleSettlementUpdate(msg, instrument, event);
     _SendMarketEventEnd(event);
 }
 
 template<typename SummaryMsgT>
-void MX_Channel::_HandleSettlementUpdate(const SummaryMsgT* msg, MarketEvent& event) {
-    const std::string identifier = msg->GetIdentifier();
+void MX_Channel::_HandleSettlementUpdate(const SummaryMsgT* msg, const MXInstrumentState& instrument, MarketEvent& event) {
+    const std::string& identifier = instrument.identifier;
     int64_t settlementPrice = msg->GetSettlementPrice();
     int64_t previousSettlementPrice = msg->GetPreviousSettlementPrice();
 
-    AdjustPrice(identifier, msg->GetSettlemenetPriceFractionIndicator(), settlementPrice, _decimals);
-    AdjustPrice(identifier, msg->GetPreviousSettlementPriceFI(), previousSettlementPrice, _decimals);
+    AdjustPrice(instrument, msg->GetSettlemenetPriceFractionIndicator(), settlementPrice);
+    AdjustPrice(instrument, msg->GetPreviousSettlementPriceFI(), previousSettlementPrice);
 
     const char reason = msg->GetReason();
 
@@ -787,7 +1018,7 @@ void MX_Channel::_HandleSettlementUpdate(const SummaryMsgT* msg, MarketEvent& ev
 }
 
 template<>
-void MX_Channel::_HandleSettlementUpdate(const StrategySummary* msg, MarketEvent& event) {
+void MX_Channel::_HandleSettlementUpdate(const StrategySummary* msg, const MXInstrumentState& instrument, MarketEvent& event) {
     //noop
 }
 
@@ -808,9 +1039,10 @@ template<typename TradeMsgT>
 void MX_Channel::_ProcessTradeMsg(const TradeMsgT* msg, const bool handleIndicativeSettle) {
     MX_DEBUG() << "channelId=" << _channelId << ", TradeMsg - " << msg->ToString();
 
-    const std::string identifier = msg->GetIdentifier();
+    MXInstrumentState& instrument = _GetInstrument(msg);
+    const std::string& identifier = instrument.identifier;
     int64_t tradePrice = msg->GetTradePrice();
-    AdjustPrice(identifier, msg->GetTradePriceFractionIndicator(), tradePrice, _decimals);
+    AdjustPrice(instrument, msg->GetTradePriceFractionIndicator(), tradePrice);
     
     const int64_t tradeQty = msg->GetVolume();
     const char priceIndicatorMarker = msg->GetPriceIndicatorMarker();
@@ -829,7 +1061,7 @@ void MX_Channel::_ProcessTradeMsg(const TradeMsgT* msg, const bool handleIndicat
         } else {
             if(handleIndicativeSettle) {
                 MarketEvent event;
-                _InitMarketEvent(msg, event);
+                _InitMarketEvent(msg, instrument, event);
                 event.type = MarketEventType::StatPrice;
                 event.entry.stat_price.id = StatPriceID::IndSettle;
                 event.entry.stat_price.action = MarketUpdateAction::New;
@@ -850,7 +1082,7 @@ void MX_Channel::_ProcessTradeMsg(const TradeMsgT* msg, const bool handleIndicat
     }
 
     MarketEvent event;
-    _InitMarketEvent(msg, event);
+    _InitMarketEvent(msg, instrument, event);
     event.type = MarketEventType::Trade;
     event.entry.trade.orderId = 0;
     event.entry.trade.status = TradeStatus::Regular;
@@ -904,7 +1136,7 @@ void MX_Channel::_Process(const StrategyTrade* msg) {
 }
 
 template<typename InstrumentKeysMsgT>
-bool MX_Channel::_OnInstrumentKeysMsg(const InstrumentKeysMsgT* msg, InstrumentDefinition& defn, bool& usesTickTable, std::string& tickTableName, const bool isOption) {
+bool MX_Channel::_OnInstrumentKeysMsg(const InstrumentKeysMsgT* msg, MXInstrumentState& instrument, InstrumentDefinition& defn, bool& usesTickTable, std::string& tickTableName, const bool isOption) {
     defn.seriesKey = defn.instrumentName = msg->GetInstrumentName();
     defn.productSymbol = GetString(msg->GetRootSymbol());
     defn.exchangeTicker = TrimRight(msg->GetInstrumentExternalCode());
@@ -942,7 +1174,9 @@ bool MX_Channel::_OnInstrumentKeysMsg(const InstrumentKeysMsgT* msg, InstrumentD
     defn.tickSizeNumerator = tickIncrement;
     const int decimals = ns::GetDecimals(tickSize / defn.tickSizeNumerator, 14, std::numeric_limits<double>::epsilon());
     defn.wireFormat.priceFactor = decimals;
-    _decimals.insert({msg->GetIdentifier(), decimals});
+    if(!instrument.HasDecimals()) {
+        instrument.SetDecimals(decimals);
+    }
 
     const double tickValue = GetPrice(msg->GetTickValue(), msg->GetTickValueFI());
     if(tickValue > 1.0) {
@@ -965,9 +1199,10 @@ bool MX_Channel::_OnInstrumentKeysMsg(const InstrumentKeysMsgT* msg, InstrumentD
 
     OutrightInfo outrightInfo(defn.productSymbol, defn.tickValueNumerator, defn.wireFormat.priceFactor, currency, defn.securityId, isOption);
     _outrights.insert({defn.securityId, outrightInfo});
-    _CacheGroupInfo(msg);
-
-    _orderbooks.CreateOrGetOrderbook(msg->GetIdentifier());
+    _CacheGroupInfo(msg, _instruments.GetHandle(instrument));
+    instrument.source.tickTableName = usesTickTable ? tickTableName : "";
+    instrument.source.currency = currency;
+    instrument.source.isOption = isOption;
 
     defn.syntheticFlags = ((SyntheticFlags_t)SyntheticFlag::GenerateHigh |
                            (SyntheticFlags_t)SyntheticFlag::GenerateLow |
@@ -984,11 +1219,15 @@ bool MX_Channel::_OnInstrumentKeysMsg(const InstrumentKeysMsgT* msg, InstrumentD
     return true;
 }
 
-template<typename InstrumentKeysMsgT>
-void MX_Channel::_CompleteInstrumentSetup(const InstrumentKeysMsgT* msg, const InstrumentDefinition& defn) {
-    Descriptor_t indesc = _GetIndesc(msg);
-    const bool newInstrument = _securityIds.count(indesc) == 0;
-    _securityIds.insert(indesc);
+void MX_Channel::_CompleteInstrumentSetup(MXInstrumentState& instrument, const InstrumentDefinition& defn) {
+    const bool newInstrument = _descriptors.Define(instrument, _instruments.GetHandle(instrument));
+    const Descriptor_t indesc = instrument.indesc;
+
+    //Restored from the cache and replayed again as the restore was incomplete - already posted with its descriptor
+    if(!newInstrument && instrument.restored && _lastRealtimeSequence <= _restoredDefinitionsTo) {
+        MX_DEBUG() << "channelId=" << _channelId << ", Restored instrument - name=" << defn.instrumentName;
+        return;
+    }
    
     _PostInstrumentDefinition(indesc, MarketBookType::Level, MarketBookType::Level, MarketUpdateAction::New, defn);
     
@@ -1002,7 +1241,7 @@ void MX_Channel::_CompleteInstrumentSetup(const InstrumentKeysMsgT* msg, const I
         event.type = MarketEventType::EventEnd;
         event.indesc = indesc;
         event.channelId = _channelId;
-        _sendApi->OnSnapshot(&event);
+        _eventBatch.SendSnapshot(event);
     } else {
         MX_INFO() << "channelId=" << _channelId << ", Existing instrument - name=" << defn.instrumentName;
     }
@@ -1016,7 +1255,8 @@ void MX_Channel::_Process(const FuturesInstrumentKeys* msg) {
 
     bool usesTickTable = false;
     std::string tickTableName = "";
-    const bool ret = _OnInstrumentKeysMsg(msg, defn, usesTickTable, tickTableName);
+    MXInstrumentState& instrument = _GetInstrument(msg);
+    const bool ret = _OnInstrumentKeysMsg(msg, instrument, defn, usesTickTable, tickTableName);
     if(!ret) {
         assert(!"FuturesInstrumentKeys - failed to process defn");
         MX_WARN() << "Failed to process instrument defn - securityId=" << defn.securityId << ", instrName=" << defn.instrumentName;
@@ -1026,13 +1266,15 @@ void MX_Channel::_Process(const FuturesInstrumentKeys* msg) {
     
     const std::string maturityDateAsString = msg->GetExpiryDate();
     const std::string ltd = msg->GetLastTradingDate();
-    DateTime maturityDate = GetExpiryDate(maturityDateAsString);
-    defn.expiration = maturityDate;
-    DateTime ltdDate = GetLTD(ltd);
-    defn.lastTradeDt = defn.expiryDate = ltdDate;
-
-    _CacheInstrumentDefn(msg->GetIdentifier(), defn);
-    _CompleteInstrumentSetup(msg, defn);
+    const MXDate maturityDate = DecodeExpiryDate(maturityDateAsString);
+    defn.expiration = ToDateTime(maturityDate);
+    const MXDate ltdDate = DecodeLTD(ltd);
+    defn.lastTradeDt = defn.expiryDate = ToDateTime(ltdDate);
+    instrument.source.expiration = maturityDate;
+    instrument.source.lastTradeDt = instrument.source.expiryDate = ltdDate;
+
+    _CacheInstrumentDefn(instrument, defn);
+    _CompleteInstrumentSetup(instrument, defn);
     _LogInstDefn(msg, defn, "FuturesInstrumentKeys", usesTickTable, tickTableName);
 }
 
@@ -1044,7 +1286,8 @@ void MX_Channel::_Process(const OptionInstrumentKeys* msg) {
 
     bool usesTickTable = false;
     std::string tickTableName = "";
-    const bool ret = _OnInstrumentKeysMsg(msg, defn, usesTickTable, tickTableName, true);
+    MXInstrumentState& instrument = _GetInstrument(msg);
+    const bool ret = _OnInstrumentKeysMsg(msg, instrument, defn, usesTickTable, tickTableName, true);
     if(!ret) {
         assert(!"OptionInstrumentKeys - failed to process defn");
         MX_WARN() << "Failed to process instrument defn - securityId=" << defn.securityId << ", instrName=" << defn.instrumentName;
@@ -1053,11 +1296,12 @@ void MX_Channel::_Process(const OptionInstrumentKeys* msg) {
     _HandleCDDField(msg, defn);
 
     const std::string lastTradingDate = msg->GetLastTradingDate();
-    DateTime ltd = GetLTD(lastTradingDate);
-    defn.expiration = defn.lastTradeDt = defn.expiryDate = ltd;
+    const MXDate ltd = DecodeLTD(lastTradingDate);
+    defn.expiration = defn.lastTradeDt = defn.expiryDate = ToDateTime(ltd);
+    instrument.source.expiration = instrument.source.lastTradeDt = instrument.source.expiryDate = ltd;
 
-    _CacheInstrumentDefn(msg->GetIdentifier(), defn);
-    _CompleteInstrumentSetup(msg, defn);
+    _CacheInstrumentDefn(instrument, defn);
+    _CompleteInstrumentSetup(instrument, defn);
     _LogInstDefn(msg, defn, "OptionInstrumentKeys", usesTickTable, tickTableName);
 }
 
@@ -1069,7 +1313,8 @@ void MX_Channel::_Process(const FutureOptionsInstrumentKeys* msg) {
 
     bool usesTickTable = false;
     std::string tickTableName = "";
-    const bool ret = _OnInstrumentKeysMsg(msg, defn, usesTickTable, tickTableName, true);
+    MXInstrumentState& instrument = _GetInstrument(msg);
+    const bool ret = _OnInstrumentKeysMsg(msg, instrument, defn, usesTickTable, tickTableName, true);
     if(!ret) {
         assert(!"FutureOptionsInstrumentKeys - failed to process defn");
         MX_WARN() << "Failed to process instrument defn - securityId=" << defn.securityId << ", instrName=" << defn.instrumentName;
@@ -1079,13 +1324,15 @@ void MX_Channel::_Process(const FutureOptionsInstrumentKeys* msg) {
   
     const std::string expiryDate = msg->GetExpiryDate();
     const std::string maturityDateStr = msg->GetSymbolYear() + GetMonthNumber(msg->GetSymbolMonth()) + msg->GetExpiryDay();
-    DateTime ltdDate = GetExpiryDate(expiryDate);
-    defn.lastTradeDt = defn.expiryDate = ltdDate;
-    DateTime maturityDate = GetExpiryDate(maturityDateStr);
-    defn.expiration = maturityDate;
-
-    _CacheInstrumentDefn(msg->GetIdentifier(), defn);
-    _CompleteInstrumentSetup(msg, defn);
+    const MXDate ltdDate = DecodeExpiryDate(expiryDate);
+    defn.lastTradeDt = defn.expiryDate = ToDateTime(ltdDate);
+    const MXDate maturityDate = DecodeExpiryDate(maturityDateStr);
+    defn.expiration = ToDateTime(maturityDate);
+    instrument.source.lastTradeDt = instrument.source.expiryDate = ltdDate;
+    instrument.source.expiration = maturityDate;
+
+    _CacheInstrumentDefn(instrument, defn);
+    _CompleteInstrumentSetup(instrument, defn);
     _LogInstDefn(msg, defn, "FutureOptionsInstrumentKeys", usesTickTable, tickTableName);
 }
 
@@ -1136,7 +1383,11 @@ void MX_Channel::_Process(const StrategyInstrumentKeys* msg) {
     defn.tickSizeNumerator = tickIncrement;
     const int decimals = ns::GetDecimals(tickSize / defn.tickSizeNumerator, 14, std::numeric_limits<double>::epsilon());
     defn.wireFormat.priceFactor = decimals;
-    _decimals.insert({msg->GetIdentifier(), decimals});
+    MXInstrumentState& instrument = _GetInstrument(msg);
+    if(!instrument.HasDecimals()) {
+        instrument.SetDecimals(decimals);
+    }
+    instrument.source.tickTableName = usesTickTable ? tickTableName : "";
 
 
     //Handle Legs
@@ -1189,13 +1440,14 @@ void MX_Channel::_Process(const StrategyInstrumentKeys* msg) {
     defn.isImplieds = true;
 
     const std::string lastTradingDate = msg->GetLastTradingDate();
-    DateTime ltd = GetLTD(lastTradingDate);
-    defn.expiration = defn.lastTradeDt = defn.expiryDate = ltd;
+    const MXDate ltd = DecodeLTD(lastTradingDate);
+    defn.expiration = defn.lastTradeDt = defn.expiryDate = ToDateTime(ltd);
+    instrument.source.expiration = instrument.source.lastTradeDt = instrument.source.expiryDate = ltd;
 
-    _CacheGroupInfo(msg);
+    _CacheGroupInfo(msg, _instruments.GetHandle(instrument));
 
-    _CacheInstrumentDefn(msg->GetIdentifier(), defn);
-    _CompleteInstrumentSetup(msg, defn);
+    _CacheInstrumentDefn(instrument, defn);
+    _CompleteInstrumentSetup(instrument, defn);
     _LogInstDefn(msg, defn, "StrategyInstrumentKeys", usesTickTable, tickTableName);
 }
 
@@ -1206,6 +1458,7 @@ void MX_Channel::_PostInstrumentDefinition(Descriptor_t indesc,
                                             const InstrumentDefinition& defn) {
        
     InstrumentDefinition instrDefn(defn);
+    _eventBatch.Flush();
     _sendApi->OnInstrumentDefinition(indesc, 
                                     _channelId, 
                                     bookType,
@@ -1260,8 +1513,7 @@ void MX_Channel::_ProcessRFQMsg(const RFQMsgT* msg) {
     }
 
     MarketEvent event;
-    _InitMarketEvent(msg, event);
-    event.indesc = _GetIndesc(msg);
+    _InitMarketEvent(msg, _GetInstrument(msg), event);
     event.type = MarketEventType::QuoteRequest;
     event.entry.quote_request.type = RFQ_QuoteType::Tradable;
     event.entry.quote_request.side = side;
@@ -1303,7 +1555,7 @@ void MX_Channel::_Process(const GroupStatusStrategies* msg) {
     _UpdateGroupStatus(_strategyGroupToDescs, strategyGroup, status, "strategy group");
 }
 
-void MX_Channel::_UpdateGroupStatus(const std::unordered_map<std::string, std::vector<std::string>>& map, 
+void MX_Channel::_UpdateGroupStatus(const std::unordered_map<std::string, std::vector<MXInstrumentHandle>>& map, 
                             const std::string& group, 
                             const char status, 
                             const std::string& log) {
@@ -1320,26 +1572,236 @@ void MX_Channel::_UpdateGroupStatus(const std::unordered_map<std::string, std::v
     const auto ttStatus = _GetStatus(status);
     event.entry.status.val = ttStatus;
 
-    const std::vector<std::string>& identifiers = it->second;
-    for(const std::string& identifier: identifiers) {
+    const std::vector<MXInstrumentHandle>& handles = it->second;
+    for(const MXInstrumentHandle handle: handles) {
+        MXInstrumentState& instrument = _instruments.Get(handle);
         MX_DEBUG() << log << "=" << group 
-        << ", identifier=" << identifier 
+        << ", identifier=" << instrument.identifier 
         << ", status=" << status 
         << ", ttstatus=" << ttStatus;
 
-        _CacheInstrumentStatus(identifier, status);
-        event.indesc = consthash(identifier.c_str());
+        _CacheInstrumentStatus(instrument, status);
+        event.indesc = _GetDescriptor(instrument);
         _SendMarketEvent(event);
         _SendMarketEventEnd(event);
     }    
 }
 
-void MX_Channel::_CacheInstrumentStatus(const std::string& identifier, const char status) {
-    _cachedStatusMarkerPerInstrument[identifier] = status;
+void MX_Channel::_CacheInstrumentStatus(MXInstrumentState& instrument, const char status) {
+    instrument.statusMarker = status;
+}
+
+void MX_Channel::_CacheInstrumentDefn(MXInstrumentState& instrument, const InstrumentDefinition& defn) {
+    if(instrument.definition) {
+        *instrument.definition = defn;
+    } else {
+        instrument.definition = std::make_unique<InstrumentDefinition>(defn);
+    }
+    _definitionsChanged = true;
 }
 
-void MX_Channel::_CacheInstrumentDefn(const std::string& identifier, const InstrumentDefinition& defn) {
-    _instruments[identifier] = defn;
+std::string MX_Channel::_GetDefinitionCachePath() const {
+    return _definitionCacheDir + "/mx_definitions_" + std::to_string(_channelId) + ".bin";
+}
+
+bool MX_Channel::_IsCachedDefinition(const MsgHeader* header) const {
+    return header->GetSeqNum() <= _cachedDefinitionsTo && IsMXMsgIn(MXDefinitionMsgs{}, header->GetMsgTypeCode());
+}
+
+/** Warm restart - tick tables and instruments of this business date as they were when the cache was written, in
+    definition order so every instrument gets back its descriptor. The definition msgs up to the seqNum the cache
+    was written at are skipped by the replay after that
+*/
+void MX_Channel::_RestoreDefinitions() {
+    if(_definitionCacheDir.empty()) {
+        return;
+    }
+
+    const std::string path = _GetDefinitionCachePath();
+    MXDefinitionCache cache;
+    if(!cache.Open(path, _businessDate)) {
+        MX_INFO() << "channelId=" << _channelId << ", No definition cache for businessDate=" << _businessDate << ", path=" << path;
+        return;
+    }
+
+    cache.ForEachTickTable([&](const std::string& msg) {
+        std::vector<char> buffer(sizeof(TickTable) + sizeof(ETX), ' ');
+        std::memcpy(buffer.data(), msg.data(), std::min(msg.size(), sizeof(TickTable)));
+        buffer.back() = ETX;
+        _Process(reinterpret_cast<const TickTable*>(buffer.data()));
+    });
+
+    uint32_t restored = 0;
+    cache.ForEachInstrument([&](const MXCachedInstrument& cached) {
+        restored += _RestoreInstrument(cache, cached);
+    });
+
+    //Anything missing and the definition msgs are all processed again
+    const bool complete = restored == cache.GetInstrumentsNum();
+    _cachedDefinitionsTo = complete ? cache.GetLastSequence() : 0;
+    _restoredDefinitionsTo = cache.GetLastSequence();
+    _definitionsChanged = !complete;
+
+    MX_INFO() << "channelId=" << _channelId << ", Restored definitions - businessDate=" << _businessDate
+    << ", instruments=" << restored << "/" << cache.GetInstrumentsNum()
+    << ", tickTables=" << _tickTables.size()
+    << ", lastSeqNo=" << _cachedDefinitionsTo;
+}
+
+bool MX_Channel::_RestoreInstrument(const MXDefinitionCache& cache, const MXCachedInstrument& cached) {
+    InstrumentDefinition defn;
+    defn.productType = static_cast<decltype(defn.productType)>(cached.productType);
+    defn.currencyCode = static_cast<decltype(defn.currencyCode)>(cached.currencyCode);
+    defn.termType = static_cast<decltype(defn.termType)>(cached.termType);
+    defn.securityExchange = static_cast<decltype(defn.securityExchange)>(cached.securityExchange);
+    defn.priceDisplayType = static_cast<decltype(defn.priceDisplayType)>(cached.priceDisplayType);
+    defn.syntheticFlags = static_cast<decltype(defn.syntheticFlags)>(cached.syntheticFlags);
+    defn.persistenceFlags = static_cast<decltype(defn.persistenceFlags)>(cached.persistenceFlags);
+    defn.tickSizeNumerator = cached.tickSizeNumerator;
+    defn.tickValueNumerator = cached.tickValueNumerator;
+    defn.wireFormat.priceFactor = cached.priceFactor;
+    defn.priceDisplayDecimals = cached.priceDisplayDecimals;
+    defn.marketDepth = cached.marketDepth;
+    defn.impliedDepth = cached.impliedDepth;
+    defn.isImplieds = cached.isImplieds != 0;
+    defn.seriesKey = cache.GetString(cached.seriesKey);
+    defn.instrumentName = cache.GetString(cached.instrumentName);
+    defn.productSymbol = cache.GetString(cached.productSymbol);
+    defn.exchangeTicker = cache.GetString(cached.exchangeTicker);
+    defn.securityId = cache.GetString(cached.securityId);
+
+    MXDefinitionSource source;
+    source.tickTableName = cache.GetString(cached.tickTableName);
+    source.currency = cache.GetString(cached.currency);
+    source.isOption = cached.isOption != 0;
+    source.expiration = MXDefinitionCache::ToDate(cached.expiration);
+    source.lastTradeDt = MXDefinitionCache::ToDate(cached.lastTradeDt);
+    source.expiryDate = MXDefinitionCache::ToDate(cached.expiryDate);
+    defn.expiration = ToDateTime(source.expiration);
+    defn.lastTradeDt = ToDateTime(source.lastTradeDt);
+    defn.expiryDate = ToDateTime(source.expiryDate);
+
+    if(!source.tickTableName.empty()) {
+        auto it = _tickTables.find(source.tickTableName);
+        if(it == std::end(_tickTables)) {
+            assert(!"_RestoreInstrument() - tick table not found");
+            MX_WARN() << "channelId=" << _channelId << ", Restoring definition - tick table " << source.tickTableName << " was not found, securityId=" << defn.securityId;
+            return false;
+        }
+        defn.tickTable = it->second;
+    }
+
+    for(uint32_t i = 0; i < cached.jsonFields; ++i) {
+        const MXCachedJsonField& field = cache.GetJsonField(cached, i);
+        defn.instrumentJSONData.insert({cache.GetString(field.key), cache.GetString(field.value)});
+    }
+    for(uint32_t i = 0; i < cached.legs; ++i) {
+        const MXCachedLeg& cachedLeg = cache.GetLeg(cached, i);
+        LegInfo legInfo;
+        legInfo.securityId = cache.GetString(cachedLeg.securityId);
+        legInfo.side = static_cast<decltype(legInfo.side)>(cachedLeg.side);
+        legInfo.ratioQtyNumerator = cachedLeg.ratioQtyNumerator;
+        legInfo.ratioQtyDenominator = cachedLeg.ratioQtyDenominator;
+        defn.legList.push_back(legInfo);
+    }
+
+    MXInstrumentState& instrument = _instruments.Intern(cached.key);
+    if(!instrument.HasDecimals()) {
+        instrument.SetDecimals(cached.decimals);
+    }
+    source.group = instrument.source.group;
+    source.isStrategy = instrument.source.isStrategy;
+    instrument.source = source;
+    const bool isStrategy = cached.isStrategy != 0;
+    _AddToGroup(_instruments.GetHandle(instrument), cache.GetString(cached.group), isStrategy);
+    if(!isStrategy) {
+        OutrightInfo outrightInfo(defn.productSymbol, defn.tickValueNumerator, defn.wireFormat.priceFactor, source.currency, defn.securityId, source.isOption);
+        _outrights.insert({defn.securityId, outrightInfo});
+    }
+
+    _CacheInstrumentDefn(instrument, defn);
+    _CompleteInstrumentSetup(instrument, defn);
+    instrument.restored = true;
+    return true;
+}
+
+//End of a complete startup replay - every definition of the day up to here goes to the cache
+void MX_Channel::_SaveDefinitions() {
+    if(_definitionCacheDir.empty() || _businessDate.empty() || !_IsStartupRetransmission() || !_definitionsChanged) {
+        return;
+    }
+    if(_recoveryLostMsgs) {
+        MX_WARN() << "channelId=" << _channelId << ", Not writing the definition cache - the replay has holes";
+        return;
+    }
+
+    MXDefinitionCacheWriter writer;
+    for(const auto& pair : _tickTableMsgs) {
+        writer.AddTickTable(pair.second);
+    }
+
+    _descriptors.ForEach([&](const Descriptor_t, const MXInstrumentHandle handle) {
+        const MXInstrumentState& instrument = _instruments.Get(handle);
+        if(!instrument.definition) {
+            return;
+        }
+        const InstrumentDefinition& defn = *instrument.definition;
+        const MXDefinitionSource& source = instrument.source;
+
+        MXCachedInstrument& cached = writer.AddInstrument();
+        cached.key = instrument.key;
+        cached.productType = static_cast<int64_t>(defn.productType);
+        cached.currencyCode = static_cast<int64_t>(defn.currencyCode);
+        cached.termType = static_cast<int64_t>(defn.termType);
+        cached.securityExchange = static_cast<int64_t>(defn.securityExchange);
+        cached.priceDisplayType = static_cast<int64_t>(defn.priceDisplayType);
+        cached.syntheticFlags = static_cast<int64_t>(defn.syntheticFlags);
+        cached.persistenceFlags = static_cast<int64_t>(defn.persistenceFlags);
+        cached.tickSizeNumerator = defn.tickSizeNumerator;
+        cached.tickValueNumerator = defn.tickValueNumerator;
+        cached.decimals = instrument.decimals;
+        cached.priceFactor = defn.wireFormat.priceFactor;
+        cached.priceDisplayDecimals = defn.priceDisplayDecimals;
+        cached.marketDepth = defn.marketDepth;
+        cached.impliedDepth = defn.impliedDepth;
+        cached.isImplieds = defn.isImplieds;
+        cached.isStrategy = source.isStrategy;
+        cached.isOption = source.isOption;
+        cached.expiration = MXDefinitionCacheWriter::ToCachedDate(source.expiration);
+        cached.lastTradeDt = MXDefinitionCacheWriter::ToCachedDate(source.lastTradeDt);
+        cached.expiryDate = MXDefinitionCacheWriter::ToCachedDate(source.expiryDate);
+        cached.seriesKey = writer.AddString(defn.seriesKey);
+        cached.instrumentName = writer.AddString(defn.instrumentName);
+        cached.productSymbol = writer.AddString(defn.productSymbol);
+        cached.exchangeTicker = writer.AddString(defn.exchangeTicker);
+        cached.securityId = writer.AddString(defn.securityId);
+        cached.group = writer.AddString(source.group);
+        cached.tickTableName = writer.AddString(source.tickTableName);
+        cached.currency = writer.AddString(source.currency);
+
+        for(const auto& field : defn.instrumentJSONData) {
+            writer.AddJsonField(field.first, field.second);
+        }
+        for(const LegInfo& leg : defn.legList) {
+            MXCachedLeg& cachedLeg = writer.AddLeg();
+            cachedLeg.securityId = writer.AddString(leg.securityId);
+            cachedLeg.side = static_cast<int64_t>(leg.side);
+            cachedLeg.ratioQtyNumerator = leg.ratioQtyNumerator;
+            cachedLeg.ratioQtyDenominator = leg.ratioQtyDenominator;
+        }
+    });
+
+    const std::string path = _GetDefinitionCachePath();
+    if(!writer.Write(path, _businessDate, _lastRealtimeSequence)) {
+        MX_WARN() << "channelId=" << _channelId << ", Failed to write the definition cache - path=" << path;
+        return;
+    }
+    _definitionsChanged = false;
+    MX_INFO() << "channelId=" << _channelId << ", Wrote the definition cache - businessDate=" << _businessDate
+    << ", instruments=" << writer.GetInstrumentsNum()
+    << ", tickTables=" << _tickTableMsgs.size()
+    << ", lastSeqNo=" << _lastRealtimeSequence
+    << ", path=" << path;
 }
 
 void MX_Channel::_Process(const FutureDeliverables* msg) {
@@ -1347,14 +1809,14 @@ void MX_Channel::_Process(const FutureDeliverables* msg) {
     const std::string identifier = msg->GetIdentifier();
     const int numBonds = msg->GetBondsNum();
 
-    auto it = _instruments.find(identifier);
-    if(std::end(_instruments) == it){
+    MXInstrumentState* instrument = _instruments.Find(msg->GetInstrumentKey());
+    if(!instrument || !instrument->definition){
         assert(!"Processing FutureDeliverables - identifier not found");
         MX_WARN() << "channelId=" << _channelId << ", Processing FutureDeliverables - identifier=" << identifier << " not found";
         return;
     }
 
-    InstrumentDefinition defn = it->second;
+    InstrumentDefinition defn = *instrument->definition;
 
     MX_INFO() << "channelId=" << _channelId << ", FutureDeliverables -"
     << ", identifier=" << identifier
@@ -1407,7 +1869,7 @@ void MX_Channel::_Process(const FutureDeliverables* msg) {
         defn.instrumentJSONData.insert({"conversionFactor", std::to_string(conversionFactor)});
         defn.instrumentJSONData.insert({"outstandingBondValue", std::to_string(outstandingBondValue)});
 
-        _CompleteInstrumentSetup(msg, defn);
+        _CompleteInstrumentSetup(*instrument, defn);
 
         MX_INFO() << "channelId=" << _channelId << ", FutureDeliverables details -"
         << " id=" << identifier
@@ -1470,13 +1932,24 @@ void MX_Channel::_Process(const TickTable* msg) {
     }
 
     _tickTables[shortName] = ttTickTable;
+
+    //As received, up to the ETX - the definition cache replays it
+    const char* bytes = reinterpret_cast<const char*>(msg);
+    const char* etx = static_cast<const char*>(std::memchr(bytes, ETX, sizeof(TickTable)));
+    _tickTableMsgs[shortName].assign(bytes, etx ? etx : bytes + sizeof(TickTable));
+    _definitionsChanged = true;
 }
 
 void MX_Channel::_Process(const StartOfDay* msg) {
     MX_INFO() << "channelId=" << _channelId << ", StartOfDay=" << msg->GetBusinessDate() << ", inRecovery=" << _inRecovery;
+    _businessDate = msg->GetBusinessDate();
 
-    if(_inRecovery)
+    if(_inRecovery) {
+        if(_IsStartupRetransmission()) {
+            _RestoreDefinitions();
+        }
         return;
+    }
     
     _GoStable();
 }
@@ -1551,6 +2024,7 @@ std::string MX_Channel::_GetMetaDataAsStr(const InstrumentDefinition& defn) cons
 
 void MX_Channel::_GoStable() const {
     MX_INFO() << "channelId=" << _channelId << ", Going stable for channelId=" << _channelId;
+    _eventBatch.Flush();
     _sendApi->OnChannelStatus(_channelId, ChannelStatus::Stable);
 }
 
@@ -1616,11 +2090,11 @@ void MX_Channel::_ResetBook(const Descriptor_t indesc) const {
     event.channelId = _channelId;
     event.indesc = indesc;
     event.type = MarketEventType::BookReset;
-    _sendApi->OnSnapshot(&event); 
+    _eventBatch.SendSnapshot(event); 
 }
 
 bool MX_Channel::_IsStartupRetransmission() const {
-    return _fromSeq == 1;
+    return _isStartupRetransmission;
 }
 
 
@@ -1737,44 +2211,41 @@ int MX_Channel::_DecodeYear(const int year) const {
 }
 
 
+//Instruments without a definition get their descriptor with their first event, unless their events are dropped
+Descriptor_t MX_Channel::_GetDescriptor(MXInstrumentState& instrument) {
+    if(!instrument.HasDescriptor() && !_dropUndefinedInstrumentEvents) {
+        _descriptors.Assign(instrument, _instruments.GetHandle(instrument));
+    }
+    return instrument.indesc;
+}
+
+//Batched until the end of the packet, direct sends to _sendApi flush first to keep the order
+//NO_DESCRIPTOR only with dropUndefinedInstrumentEvents - an instrument without a definition
 inline void MX_Channel::_SendMarketEvent(MarketEvent& event) const {
-    _sendApi->OnIncremental(&event);
+    if(event.indesc == MXInstrumentState::NO_DESCRIPTOR)
+        return;
+
+    _eventBatch.Append(event);
 }
 
 inline void MX_Channel::_SendMarketEventEnd(MarketEvent& event) const{
-    if(_inRecovery)
+    if(_inRecovery || event.indesc == MXInstrumentState::NO_DESCRIPTOR)
         return;
 
     auto previousType = event.type;
     event.type = MarketEventType::EventEnd;
-    _sendApi->OnIncremental(&event); 
+    _eventBatch.Append(event);
     event.type = previousType;
 }
 
-uint16_t MX_Channel::_GetMessageCount(const PacketBufferPtr& packetBuffer, std::string& types) const {
-    char* readPtr = packetBuffer->m_buffer;
-    const uint32_t bytesReceived = packetBuffer->m_bytesReceived;
-
-    uint16_t count = 0;
-    while(readPtr - packetBuffer->m_buffer < bytesReceived) {
-        assert(*readPtr == STX);
-        const MsgHeader* header = reinterpret_cast<const MsgHeader*>(readPtr + sizeof(STX));
+std::string MX_Channel::_GetMessageTypes(char* buffer, const MXFrameIndex& frameIndex) const {
+    std::string types;
+    for(uint32_t i = 0; i < frameIndex.count; ++i) {
+        const MsgHeader* header = reinterpret_cast<const MsgHeader*>(frameIndex.GetMsg(buffer, i));
 
-        std::string msgType = header->GetMsgType();
-        if(!msgType.empty() && msgType.back() == ' ') {
-            msgType.pop_back();
-        }
-
-        types += msgType + "(" + std::to_string(header->GetSeqNum()) + ")" + ",";
-
-        ++count; //We have a msg
-        auto it = std::find(readPtr, packetBuffer->m_buffer + bytesReceived, ETX);
-        assert(*it == ETX && (it != packetBuffer->m_buffer + bytesReceived));
-        readPtr = ++it;
+        types += TrimRight(header->GetMsgType()) + "(" + std::to_string(header->GetSeqNum()) + ")" + ",";
     }
-
-    assert(count != 0);
-    return count;
+    return types;
 }
 
 
@@ -0,0 +1,217 @@
+/** Benchmark of the HSVF numeric decoders in mx_numeric.h against the byte at a time scalar parsing they replaced.
+
+    Decodes a set of random depth levels - the 2/5/7 char fields of a DepthLevel, exponent letters included - and the
+    10 and 4 char fields of the header and trades, both ways. Checks the results agree before timing anything.
+
+    Standalone, header only dependency:
+        g++ -std=c++17 -O2 -msse4.1 -I../include/mx -o mx_numeric_bench mx_numeric_bench.cpp
+        mx_numeric_bench [--levels N] [--rounds N]
+*/
+
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <random>
+#include <string>
+#include <vector>
+
+#include "mx_numeric.h"
+
+namespace ns {
+
+//Wire layout as in mx_message_definitions.h
+#pragma pack(push)
+#pragma pack(1)
+struct BenchDepthLevel {
+    char level;
+    char bidPrice[7];
+    char bidPriceFractionIndicator;
+    char bidSize[5];
+    char bidOrdersNum[2];
+    char askPrice[7];
+    char askPriceFractionIndicator;
+    char askSize[5];
+    char askOrdersNum[2];
+};
+#pragma pack(pop)
+
+//As GetMultiplierFromIndicatorCode() in mx_common.h
+inline uint32_t BenchMultiplier(const char marker) {
+    switch(marker) {
+        case 'C': return 100;
+        case 'D': return 1000;
+        case 'E': return 10000;
+        case 'F': return 100000;
+        case 'G': return 1000000;
+        case 'H': return 10000000;
+        case 'I': return 100000000;
+        case 'J': return 100000000;
+        default:  return 1;
+    }
+}
+
+//The scalar parsing as it was before mx_numeric.h
+template<typename T>
+T ScalarConvert(const char* buf, int len) {
+    T ret = 0;
+    for(int i = len; i > 0; --i) {
+        ret = ret * 10 + *buf - '0';
+        ++buf;
+    }
+    return ret;
+}
+
+template<typename T>
+T ScalarConvertWithLastByteCheck(const char* buf, int len) {
+    const bool shouldMultiply = buf[len - 1] > '9';
+    const uint32_t multiplier = shouldMultiply ? BenchMultiplier(buf[len - 1]) : 1;
+    T value = ScalarConvert<T>(buf, shouldMultiply ? len - 1: len);
+    return value * multiplier;
+}
+
+template<size_t LEN>
+int32_t SwarConvertWithLastByteCheck(const char (&buf)[LEN]) {
+    char exponent;
+    const int32_t value = static_cast<int32_t>(DecodeMXDigitsWithExponent<LEN>(buf, exponent));
+    return exponent ? value * BenchMultiplier(exponent) : value;
+}
+
+MXDecodedLevel DecodeScalar(const BenchDepthLevel& level) {
+    MXDecodedLevel decoded;
+    decoded.bidPrice = ScalarConvert<int64_t>(level.bidPrice, 7);
+    decoded.askPrice = ScalarConvert<int64_t>(level.askPrice, 7);
+    decoded.bidSize = ScalarConvertWithLastByteCheck<int32_t>(level.bidSize, 5);
+    decoded.askSize = ScalarConvertWithLastByteCheck<int32_t>(level.askSize, 5);
+    decoded.bidOrdersNum = ScalarConvertWithLastByteCheck<int32_t>(level.bidOrdersNum, 2);
+    decoded.askOrdersNum = ScalarConvertWithLastByteCheck<int32_t>(level.askOrdersNum, 2);
+    return decoded;
+}
+
+//As DepthLevel::Decode()
+MXDecodedLevel DecodeSwar(const BenchDepthLevel& level) {
+    const char* base = reinterpret_cast<const char*>(&level);
+    MXDecodedLevel decoded;
+    DecodeMXPricePair(base + offsetof(BenchDepthLevel, bidPrice) - 1, base + offsetof(BenchDepthLevel, askPrice) - 1, decoded.bidPrice, decoded.askPrice);
+    decoded.bidSize = SwarConvertWithLastByteCheck(level.bidSize);
+    decoded.askSize = SwarConvertWithLastByteCheck(level.askSize);
+    decoded.bidOrdersNum = SwarConvertWithLastByteCheck(level.bidOrdersNum);
+    decoded.askOrdersNum = SwarConvertWithLastByteCheck(level.askOrdersNum);
+    return decoded;
+}
+
+bool operator==(const MXDecodedLevel& a, const MXDecodedLevel& b) {
+    return a.bidPrice == b.bidPrice && a.askPrice == b.askPrice && a.bidSize == b.bidSize && a.askSize == b.askSize
+        && a.bidOrdersNum == b.bidOrdersNum && a.askOrdersNum == b.askOrdersNum;
+}
+
+//Random digits, the last one an exponent letter now and then
+template<size_t LEN>
+void FillDigits(char (&field)[LEN], std::mt19937& random, const bool exponent) {
+    for(size_t i = 0; i < LEN; ++i) {
+        field[i] = static_cast<char>('0' + random() % 10);
+    }
+    if(exponent && random() % 8 == 0) {
+        field[LEN - 1] = static_cast<char>('C' + random() % 7);
+    }
+}
+
+struct Fields {
+    char seqNum[10];
+    char quantity[4];
+};
+
+template<typename DecodeT>
+double TimeNs(const size_t rounds, const size_t items, DecodeT decode) {
+    const auto start = std::chrono::steady_clock::now();
+    for(size_t round = 0; round < rounds; ++round) {
+        for(size_t i = 0; i < items; ++i) {
+            decode(i);
+        }
+    }
+    const auto elapsed = std::chrono::steady_clock::now() - start;
+    return std::chrono::duration<double, std::nano>(elapsed).count() / (rounds * items);
+}
+
+//Keeps the decoded values alive without a store per item
+template<typename T>
+inline void Consume(const T& value) {
+    asm volatile("" : : "g"(&value) : "memory");
+}
+
+bool ParseArgs(const int argc, char** argv, size_t& levels, size_t& rounds) {
+    for(int i = 1; i < argc; ++i) {
+        const std::string arg = argv[i];
+        if(i + 1 >= argc) {
+            fprintf(stderr, "Missing value for %s\n", arg.c_str());
+            return false;
+        }
+        const std::string value = argv[++i];
+        if(arg == "--levels")       { levels = std::max<size_t>(1, std::stoull(value)); }
+        else if(arg == "--rounds")  { rounds = std::max<size_t>(1, std::stoull(value)); }
+        else {
+            fprintf(stderr, "Unknown option %s\n", arg.c_str());
+            return false;
+        }
+    }
+    return true;
+}
+
+}//end namespace
+
+int main(int argc, char** argv) {
+    using namespace ns;
+
+    size_t levelCount = 4096;
+    size_t rounds = 2000;
+    if(!ParseArgs(argc, argv, levelCount, rounds)) {
+        fprintf(stderr, "Usage: %s [--levels N] [--rounds N]\n", argv[0]);
+        return 1;
+    }
+
+    std::mt19937 random(42);
+    std::vector<BenchDepthLevel> levels(levelCount);
+    std::vector<Fields> fields(levelCount);
+    for(size_t i = 0; i < levelCount; ++i) {
+        BenchDepthLevel& level = levels[i];
+        level.level = static_cast<char>('1' + i % 5);
+        FillDigits(level.bidPrice, random, false);
+        FillDigits(level.bidSize, random, true);
+        FillDigits(level.bidOrdersNum, random, false);
+        FillDigits(level.askPrice, random, false);
+        FillDigits(level.askSize, random, true);
+        FillDigits(level.askOrdersNum, random, false);
+        level.bidPriceFractionIndicator = level.askPriceFractionIndicator = '3';
+        FillDigits(fields[i].seqNum, random, false);
+        FillDigits(fields[i].quantity, random, false);
+    }
+
+    for(size_t i = 0; i < levelCount; ++i) {
+        if(!(DecodeScalar(levels[i]) == DecodeSwar(levels[i]))
+           || ScalarConvert<uint64_t>(fields[i].seqNum, 10) != DecodeMXDigits<10>(fields[i].seqNum)
+           || ScalarConvert<uint64_t>(fields[i].quantity, 4) != DecodeMXDigits<4>(fields[i].quantity)) {
+            fprintf(stderr, "Mismatch at %zu\n", i);
+            return 1;
+        }
+    }
+
+#if defined(__SSE4_1__)
+    printf("Prices decoded with SSE4.1\n");
+#else
+    printf("Prices decoded with SWAR only - build with -msse4.1 for the SSE path\n");
+#endif
+
+    const double scalarLevel = TimeNs(rounds, levelCount, [&](const size_t i) { Consume(DecodeScalar(levels[i])); });
+    const double swarLevel = TimeNs(rounds, levelCount, [&](const size_t i) { Consume(DecodeSwar(levels[i])); });
+    const double scalarSeq = TimeNs(rounds, levelCount, [&](const size_t i) { Consume(ScalarConvert<uint64_t>(fields[i].seqNum, 10)); });
+    const double swarSeq = TimeNs(rounds, levelCount, [&](const size_t i) { Consume(DecodeMXDigits<10>(fields[i].seqNum)); });
+    const double scalarQty = TimeNs(rounds, levelCount, [&](const size_t i) { Consume(ScalarConvert<uint64_t>(fields[i].quantity, 4)); });
+    const double swarQty = TimeNs(rounds, levelCount, [&](const size_t i) { Consume(DecodeMXDigits<4>(fields[i].quantity)); });
+
+    printf("%-22s %10s %10s %8s\n", "", "scalar ns", "swar ns", "speedup");
+    printf("%-22s %10.2f %10.2f %7.2fx\n", "DepthLevel (6 fields)", scalarLevel, swarLevel, scalarLevel / swarLevel);
+    printf("%-22s %10.2f %10.2f %7.2fx\n", "seqNum (10 chars)", scalarSeq, swarSeq, scalarSeq / swarSeq);
+    printf("%-22s %10.2f %10.2f %7.2fx\n", "quantity (4 chars)", scalarQty, swarQty, scalarQty / swarQty);
+    return 0;
+}
@@ -0,0 +1,400 @@
+/** Local stand-in for the MX HSVF retransmission service - lets MXRecoveryHandler's LI/KI, RT/RB/RE, LO/KO flow be
+    exercised and timed end to end on one box.
+
+    Serves RT requests from a journal of HSVF msgs: either a file of raw STX...ETX msgs back to back (e.g. a previous
+    retransmission or realtime packets stripped of their packet header), or N synthetic heartbeats numbered 1..N.
+    Each RT is answered with RB, the journal msgs in range and RE. A request larger than --page-size is cut short, the
+    handler asks again for the rest. With --error-every N every Nth RT gets an ER and an empty RB/RE instead.
+
+    Standalone, plain POSIX sockets - no framework needed:
+        g++ -std=c++17 -O2 -o mx_retransmission_server mx_retransmission_server.cpp
+        mx_retransmission_server --port 15000 --synthetic 1000000 --page-size 10000 --latency-us 500
+*/
+
+#include <arpa/inet.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <signal.h>
+#include <sys/socket.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <cerrno>
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <iterator>
+#include <string>
+#include <thread>
+#include <vector>
+
+namespace ns {
+
+constexpr char STX = 0x02;
+constexpr char ETX = 0x03;
+
+//Wire layouts as in mx_message_definitions.h
+constexpr size_t SEQ_NUM_LEN = 10;
+constexpr size_t MSG_TYPE_LEN = 2;
+constexpr size_t HEADER_LEN = SEQ_NUM_LEN + MSG_TYPE_LEN;
+constexpr size_t LOGIN_FIELD_LEN = 16;          //LI - username, password
+constexpr size_t LINE_LEN = 2;                  //RT - line, then startMsgNumber and endMsgNumber
+constexpr size_t ERROR_CODE_LEN = 4;            //ER - errorCode, errorMsg
+constexpr size_t ERROR_MSG_LEN = 80;
+
+struct ServerConfig {
+    uint16_t port = 15000;
+    std::string journalPath;
+    uint64_t syntheticMsgs = 0;
+    uint64_t pageSize = 10000;
+    uint64_t latencyUs = 0;
+    uint64_t errorEvery = 0;
+    std::string username;
+    std::string password;
+};
+
+//One HSVF msg of the journal, STX and ETX included
+struct JournalEntry {
+    uint64_t seqNum;
+    size_t offset;
+    size_t len;
+};
+
+class Journal {
+public:
+    bool Load(const std::string& path) {
+        std::ifstream in(path, std::ios::binary);
+        if(!in) {
+            fprintf(stderr, "Cannot open journal %s\n", path.c_str());
+            return false;
+        }
+        _data.assign(std::istreambuf_iterator<char>(in), std::istreambuf_iterator<char>());
+
+        size_t pos = 0;
+        while(pos < _data.size()) {
+            if(_data[pos] != STX) {
+                ++pos;
+                continue;
+            }
+            const void* etx = std::memchr(_data.data() + pos, ETX, _data.size() - pos);
+            if(!etx) {
+                break;
+            }
+            const size_t end = static_cast<const char*>(etx) - _data.data() + 1;
+            if(end - pos >= 1 + HEADER_LEN + 1) {
+                _entries.push_back({ParseNumber(_data.data() + pos + 1, SEQ_NUM_LEN), pos, end - pos});
+            }
+            pos = end;
+        }
+        _Sort();
+        return true;
+    }
+
+    //Heartbeats 1..count - LongMsgHeader and the time field
+    void Generate(const uint64_t count) {
+        static const std::string timestamp(20, '0');
+        char seqNum[SEQ_NUM_LEN + 1];
+        for(uint64_t seq = 1; seq <= count; ++seq) {
+            snprintf(seqNum, sizeof(seqNum), "%010llu", static_cast<unsigned long long>(seq));
+            const size_t offset = _data.size();
+            _data.push_back(STX);
+            _data.insert(std::end(_data), seqNum, seqNum + SEQ_NUM_LEN);
+            _data.push_back('V');
+            _data.push_back(' ');
+            _data.insert(std::end(_data), std::begin(timestamp), std::end(timestamp));
+            _data.insert(std::end(_data), 6, '0');
+            _data.push_back(ETX);
+            _entries.push_back({seq, offset, _data.size() - offset});
+        }
+    }
+
+    template<typename OnEntryT>
+    void ForEach(const uint64_t from, const uint64_t to, OnEntryT onEntry) const {
+        auto it = std::lower_bound(std::begin(_entries), std::end(_entries), from,
+                                   [](const JournalEntry& entry, const uint64_t seq) { return entry.seqNum < seq; });
+        for(; it != std::end(_entries) && it->seqNum <= to; ++it) {
+            onEntry(_data.data() + it->offset, it->len);
+        }
+    }
+
+    size_t GetSize() const {
+        return _entries.size();
+    }
+
+    static uint64_t ParseNumber(const char* buf, const size_t len) {
+        uint64_t value = 0;
+        for(size_t i = 0; i < len; ++i) {
+            if(buf[i] >= '0' && buf[i] <= '9') {
+                value = value * 10 + (buf[i] - '0');
+            }
+        }
+        return value;
+    }
+
+private:
+    void _Sort() {
+        std::stable_sort(std::begin(_entries), std::end(_entries),
+                         [](const JournalEntry& a, const JournalEntry& b) { return a.seqNum < b.seqNum; });
+    }
+
+    std::vector<char> _data;
+    std::vector<JournalEntry> _entries;
+};
+
+//One client session, served until LO or disconnect
+class Session {
+public:
+    Session(const int fd, const ServerConfig& config, const Journal& journal)
+        : _fd(fd)
+        , _config(config)
+        , _journal(journal)
+    {
+    }
+
+    void Run() {
+        const auto start = std::chrono::steady_clock::now();
+        std::vector<char> in;
+        char readBuf[64 * 1024];
+        while(_open) {
+            const ssize_t bytes = recv(_fd, readBuf, sizeof(readBuf), 0);
+            if(bytes <= 0) {
+                break;
+            }
+            in.insert(std::end(in), readBuf, readBuf + bytes);
+
+            size_t pos = 0;
+            while(_open) {
+                auto etx = std::find(std::begin(in) + pos, std::end(in), ETX);
+                if(etx == std::end(in)) {
+                    break;
+                }
+                const size_t end = std::distance(std::begin(in), etx) + 1;
+                if(in[pos] == STX && end - pos >= 1 + HEADER_LEN + 1) {
+                    _OnMsg(in.data() + pos + 1, end - pos - 2);
+                } else {
+                    fprintf(stderr, "Dropping %zu bytes out of STX/ETX framing\n", end - pos);
+                }
+                pos = end;
+            }
+            in.erase(std::begin(in), std::begin(in) + pos);
+            _Flush();
+        }
+        _Flush();
+
+        const double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+        printf("Session done - requests=%llu, msgs=%llu, bytes=%llu, seconds=%.3f, msgsPerSec=%.0f\n",
+               static_cast<unsigned long long>(_requests), static_cast<unsigned long long>(_msgs),
+               static_cast<unsigned long long>(_bytes), seconds, seconds > 0 ? _msgs / seconds : 0.0);
+    }
+
+private:
+    //body - past STX, without ETX
+    void _OnMsg(const char* body, const size_t len) {
+        const std::string msgType(body + SEQ_NUM_LEN, MSG_TYPE_LEN);
+        if(msgType == "LI") {
+            _OnLogin(body, len);
+        } else if(msgType == "RT") {
+            _OnRetransmissionRequest(body, len);
+        } else if(msgType == "LO") {
+            _SendAdmin("KO");
+            _open = false;
+        } else {
+            fprintf(stderr, "Unhandled msgType=%s\n", msgType.c_str());
+        }
+    }
+
+    void _OnLogin(const char* body, const size_t len) {
+        if(len < HEADER_LEN + 2 * LOGIN_FIELD_LEN) {
+            _SendError("0001", "Malformed login");
+            _open = false;
+            return;
+        }
+        const std::string username = _Trim(std::string(body + HEADER_LEN, LOGIN_FIELD_LEN));
+        const std::string password = _Trim(std::string(body + HEADER_LEN + LOGIN_FIELD_LEN, LOGIN_FIELD_LEN));
+        if((!_config.username.empty() && username != _config.username)
+        || (!_config.password.empty() && password != _config.password)) {
+            _SendError("0002", "Invalid username or password");
+            _open = false;
+            return;
+        }
+        printf("Login username=%s\n", username.c_str());
+        _SendAdmin("KI");
+    }
+
+    void _OnRetransmissionRequest(const char* body, const size_t len) {
+        if(len < HEADER_LEN + LINE_LEN + 2 * SEQ_NUM_LEN) {
+            _SendError("0003", "Malformed retransmission request");
+            return;
+        }
+        const uint64_t from = Journal::ParseNumber(body + HEADER_LEN + LINE_LEN, SEQ_NUM_LEN);
+        const uint64_t requestedTo = Journal::ParseNumber(body + HEADER_LEN + LINE_LEN + SEQ_NUM_LEN, SEQ_NUM_LEN);
+        ++_requests;
+
+        if(_config.latencyUs) {
+            _Flush();
+            std::this_thread::sleep_for(std::chrono::microseconds(_config.latencyUs));
+        }
+
+        if(_config.errorEvery && _requests % _config.errorEvery == 0) {
+            //Injected failure - the empty page makes the handler ask again
+            _SendError("0004", "Injected retransmission error");
+            _SendAdmin("RB");
+            _SendAdmin("RE");
+            return;
+        }
+
+        const uint64_t to = std::min(requestedTo, from + _config.pageSize - 1);
+        _SendAdmin("RB");
+        _journal.ForEach(from, to, [this](const char* msg, const size_t msgLen) {
+            _Append(msg, msgLen);
+            ++_msgs;
+        });
+        _SendAdmin("RE");
+    }
+
+    void _SendAdmin(const char* msgType) {
+        std::string msg;
+        msg += STX;
+        msg += "0000000001";
+        msg.append(msgType, MSG_TYPE_LEN);
+        msg += ETX;
+        _Append(msg.data(), msg.size());
+    }
+
+    void _SendError(const char* code, const std::string& text) {
+        std::string msg;
+        msg += STX;
+        msg += "0000000001ER";
+        msg.append(code, ERROR_CODE_LEN);
+        msg += text.substr(0, ERROR_MSG_LEN);
+        msg.append(ERROR_MSG_LEN - std::min(ERROR_MSG_LEN, text.size()), ' ');
+        msg += ETX;
+        _Append(msg.data(), msg.size());
+        fprintf(stderr, "ER %s %s\n", code, text.c_str());
+    }
+
+    void _Append(const char* data, const size_t len) {
+        _out.insert(std::end(_out), data, data + len);
+        if(_out.size() >= FLUSH_BYTES) {
+            _Flush();
+        }
+    }
+
+    void _Flush() {
+        size_t sent = 0;
+        while(sent < _out.size()) {
+            const ssize_t bytes = send(_fd, _out.data() + sent, _out.size() - sent, 0);
+            if(bytes < 0) {
+                if(errno == EINTR) {
+                    continue;
+                }
+                _open = false;
+                break;
+            }
+            sent += bytes;
+        }
+        _bytes += sent;
+        _out.clear();
+    }
+
+    static std::string _Trim(const std::string& field) {
+        const size_t first = field.find_first_not_of(' ');
+        const size_t last = field.find_last_not_of(' ');
+        return first == std::string::npos ? std::string() : field.substr(first, last - first + 1);
+    }
+
+    static constexpr size_t FLUSH_BYTES = 256 * 1024;
+
+    const int _fd;
+    const ServerConfig& _config;
+    const Journal& _journal;
+    std::vector<char> _out;
+    bool _open = true;
+    uint64_t _requests = 0;
+    uint64_t _msgs = 0;
+    uint64_t _bytes = 0;
+};
+
+bool ParseArgs(const int argc, char** argv, ServerConfig& config) {
+    for(int i = 1; i < argc; ++i) {
+        const std::string arg = argv[i];
+        if(i + 1 >= argc) {
+            fprintf(stderr, "Missing value for %s\n", arg.c_str());
+            return false;
+        }
+        const std::string value = argv[++i];
+        if(arg == "--port")              { config.port = static_cast<uint16_t>(std::stoul(value)); }
+        else if(arg == "--journal")      { config.journalPath = value; }
+        else if(arg == "--synthetic")    { config.syntheticMsgs = std::stoull(value); }
+        else if(arg == "--page-size")    { config.pageSize = std::max<uint64_t>(1, std::stoull(value)); }
+        else if(arg == "--latency-us")   { config.latencyUs = std::stoull(value); }
+        else if(arg == "--error-every")  { config.errorEvery = std::stoull(value); }
+        else if(arg == "--username")     { config.username = value; }
+        else if(arg == "--password")     { config.password = value; }
+        else {
+            fprintf(stderr, "Unknown option %s\n", arg.c_str());
+            return false;
+        }
+    }
+    return config.journalPath.empty() != (config.syntheticMsgs == 0);
+}
+
+}//end namespace
+
+int main(int argc, char** argv) {
+    using namespace ns;
+
+    setvbuf(stdout, nullptr, _IOLBF, 0);
+    ServerConfig config;
+    if(!ParseArgs(argc, argv, config)) {
+        fprintf(stderr, "Usage: %s [--port P] (--journal FILE | --synthetic N) [--page-size N] [--latency-us N]"
+                        " [--error-every N] [--username U] [--password P]\n", argv[0]);
+        return 1;
+    }
+
+    Journal journal;
+    if(!config.journalPath.empty()) {
+        if(!journal.Load(config.journalPath)) {
+            return 1;
+        }
+    } else {
+        journal.Generate(config.syntheticMsgs);
+    }
+    printf("Journal msgs=%zu\n", journal.GetSize());
+
+    signal(SIGPIPE, SIG_IGN);
+    const int listenFd = socket(AF_INET, SOCK_STREAM, 0);
+    const int on = 1;
+    setsockopt(listenFd, SOL_SOCKET, SO_REUSEADDR, &on, sizeof(on));
+    sockaddr_in addr{};
+    addr.sin_family = AF_INET;
+    addr.sin_addr.s_addr = htonl(INADDR_ANY);
+    addr.sin_port = htons(config.port);
+    if(listenFd < 0 || bind(listenFd, reinterpret_cast<sockaddr*>(&addr), sizeof(addr)) != 0 || listen(listenFd, 1) != 0) {
+        fprintf(stderr, "Cannot listen on port %u - %s\n", config.port, strerror(errno));
+        return 1;
+    }
+    printf("Listening on port %u, pageSize=%llu, latencyUs=%llu, errorEvery=%llu\n", config.port,
+           static_cast<unsigned long long>(config.pageSize), static_cast<unsigned long long>(config.latencyUs),
+           static_cast<unsigned long long>(config.errorEvery));
+
+    //One session at a time, as the handler uses one connection per recovery
+    while(true) {
+        const int fd = accept(listenFd, nullptr, nullptr);
+        if(fd < 0) {
+            if(errno == EINTR) {
+                continue;
+            }
+            fprintf(stderr, "accept failed - %s\n", strerror(errno));
+            break;
+        }
+        setsockopt(fd, IPPROTO_TCP, TCP_NODELAY, &on, sizeof(on));
+        Session(fd, config, journal).Run();
+        close(fd);
+    }
+    close(listenFd);
+    return 0;
+}
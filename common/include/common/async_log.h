@@ -0,0 +1,230 @@
+#ifndef _COMMON_ASYNC_LOG_H_
+#define _COMMON_ASYNC_LOG_H_
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <memory>
+#include <mutex>
+#include <sstream>
+#include <string>
+#include <thread>
+#include <type_traits>
+#include <vector>
+
+namespace ns {
+
+enum class AsyncLogLevel : uint8_t {
+    Debug,
+    Info,
+    Warn,
+    Error
+};
+
+/** Fixed size binary log record. Arguments are appended as [tag][payload], nothing is formatted on the caller thread.
+    Strings longer than what is left in the record are truncated
+*/
+struct AsyncLogRecord {
+    static constexpr size_t SIZE = 256;
+    static constexpr size_t PAYLOAD_SIZE = SIZE - sizeof(uint32_t) - 2 * sizeof(uint8_t) - sizeof(uint16_t);
+
+    enum Tag : uint8_t {
+        TAG_I64,
+        TAG_U64,
+        TAG_F64,
+        TAG_CHAR,
+        TAG_BOOL,
+        TAG_STR
+    };
+
+    uint32_t id = 0;
+    AsyncLogLevel level = AsyncLogLevel::Info;
+    uint8_t truncated = 0;
+    uint16_t len = 0;
+    char payload[PAYLOAD_SIZE];
+};
+static_assert(sizeof(AsyncLogRecord) == AsyncLogRecord::SIZE, "AsyncLogRecord must stay one fixed slot");
+
+/** Per thread single producer / single consumer ring of records. The owning thread writes, the formatter thread reads */
+class AsyncLogRing {
+public:
+    static constexpr size_t CAPACITY = 16 * 1024;
+
+    AsyncLogRing()
+        : _records(new AsyncLogRecord[CAPACITY])
+    {
+    }
+
+    bool TryPush(const AsyncLogRecord& record) {
+        const size_t tail = _tail.load(std::memory_order_relaxed);
+        if(tail - _head.load(std::memory_order_acquire) == CAPACITY) {
+            return false;
+        }
+        //Only the used part of the payload is copied
+        std::memcpy(&_records[tail % CAPACITY], &record, offsetof(AsyncLogRecord, payload) + record.len);
+        _tail.store(tail + 1, std::memory_order_release);
+        return true;
+    }
+
+    template<typename OnRecordT>
+    size_t Drain(OnRecordT onRecord) {
+        size_t head = _head.load(std::memory_order_relaxed);
+        const size_t tail = _tail.load(std::memory_order_acquire);
+        const size_t count = tail - head;
+        for(; head != tail; ++head) {
+            onRecord(_records[head % CAPACITY]);
+        }
+        _head.store(head, std::memory_order_release);
+        return count;
+    }
+
+    void AddDropped(const uint32_t id) {
+        _droppedId.store(id, std::memory_order_relaxed);
+        _dropped.fetch_add(1, std::memory_order_relaxed);
+    }
+
+    uint64_t TakeDropped(uint32_t& id) {
+        id = _droppedId.load(std::memory_order_relaxed);
+        return _dropped.exchange(0, std::memory_order_relaxed);
+    }
+
+private:
+    std::unique_ptr<AsyncLogRecord[]> _records;
+    alignas(64) std::atomic<size_t> _head{0};
+    alignas(64) std::atomic<size_t> _tail{0};
+    std::atomic<uint64_t> _dropped{0};
+    std::atomic<uint32_t> _droppedId{0};
+};
+
+/** Process wide backend shared by the adapters. Rings are registered on the first log call of each thread and drained
+    by one formatter thread which hands the formatted line to the regular logger.
+    Every level goes through the thread's ring, so a thread's lines come out in the order it wrote them. Debug/Info are
+    dropped when the ring is full, Warn/Error wait for room.
+    Shutdown() joins the formatter, it runs at exit before the statics constructed ahead of the first log call are
+    destroyed. Lines logged after it are formatted on the caller thread
+*/
+class AsyncLogger {
+public:
+    static AsyncLogger& Instance();
+
+    //Lines below level are skipped before their arguments are evaluated. Set by the channels' Init from the level the
+    //regular logger is configured with, Info until then
+    static void SetLevel(const AsyncLogLevel level) {
+        _minLevel.store(static_cast<uint8_t>(level), std::memory_order_relaxed);
+    }
+
+    static bool IsEnabled(const AsyncLogLevel level) {
+        return static_cast<uint8_t>(level) >= _minLevel.load(std::memory_order_relaxed);
+    }
+
+    void Commit(const AsyncLogRecord& record);
+    void Shutdown();
+    ~AsyncLogger();
+
+private:
+    AsyncLogger();
+    AsyncLogRing& _GetThreadRing();
+    void _Run();
+    size_t _DrainAll();
+    static void _Emit(const AsyncLogRecord& record, std::ostringstream& ss);
+
+    static inline std::atomic<uint8_t> _minLevel{static_cast<uint8_t>(AsyncLogLevel::Info)};
+
+    std::mutex _mutex;
+    std::vector<std::shared_ptr<AsyncLogRing>> _rings;
+    std::atomic<bool> _running{true};
+    std::thread _thread;
+    std::ostringstream _ss;    //formatter thread only
+};
+
+/** Temporary returned by the adapters' log macros. Encodes each streamed argument and commits the record on destruction */
+class AsyncLogLine {
+public:
+    AsyncLogLine(const AsyncLogLevel level, const uint32_t id) {
+        _record.level = level;
+        _record.id = id;
+    }
+
+    ~AsyncLogLine() {
+        AsyncLogger::Instance().Commit(_record);
+    }
+
+    AsyncLogLine(const AsyncLogLine&) = delete;
+    AsyncLogLine& operator=(const AsyncLogLine&) = delete;
+
+    template<typename T>
+    AsyncLogLine& operator<<(const T& value) {
+        using ValueT = typename std::decay<T>::type;
+        if constexpr (std::is_same<ValueT, bool>::value) {
+            _Put(AsyncLogRecord::TAG_BOOL, static_cast<uint8_t>(value));
+        } else if constexpr (std::is_same<ValueT, char>::value || std::is_same<ValueT, signed char>::value || std::is_same<ValueT, unsigned char>::value) {
+            _Put(AsyncLogRecord::TAG_CHAR, static_cast<char>(value));
+        } else if constexpr (std::is_enum<ValueT>::value) {
+            _Put(AsyncLogRecord::TAG_I64, static_cast<int64_t>(value));
+        } else if constexpr (std::is_integral<ValueT>::value && std::is_signed<ValueT>::value) {
+            _Put(AsyncLogRecord::TAG_I64, static_cast<int64_t>(value));
+        } else if constexpr (std::is_integral<ValueT>::value) {
+            _Put(AsyncLogRecord::TAG_U64, static_cast<uint64_t>(value));
+        } else if constexpr (std::is_floating_point<ValueT>::value) {
+            _Put(AsyncLogRecord::TAG_F64, static_cast<double>(value));
+        } else if constexpr (std::is_same<ValueT, const char*>::value || std::is_same<ValueT, char*>::value) {
+            _PutString(value, std::strlen(value));
+        } else if constexpr (std::is_same<ValueT, std::string>::value) {
+            _PutString(value.data(), value.size());
+        } else {
+            //Anything else falls back to formatting on the caller thread
+            std::ostringstream ss;
+            ss << value;
+            const std::string str = ss.str();
+            _PutString(str.data(), str.size());
+        }
+        return *this;
+    }
+
+private:
+    template<typename ValueT>
+    void _Put(const uint8_t tag, const ValueT value) {
+        if(_record.len + 1 + sizeof(ValueT) > AsyncLogRecord::PAYLOAD_SIZE) {
+            _record.truncated = 1;
+            return;
+        }
+        _record.payload[_record.len++] = static_cast<char>(tag);
+        std::memcpy(_record.payload + _record.len, &value, sizeof(ValueT));
+        _record.len += sizeof(ValueT);
+    }
+
+    void _PutString(const char* str, size_t len) {
+        const size_t header = 1 + sizeof(uint16_t);
+        if(_record.len + header >= AsyncLogRecord::PAYLOAD_SIZE) {
+            _record.truncated = 1;
+            return;
+        }
+        const size_t available = AsyncLogRecord::PAYLOAD_SIZE - _record.len - header;
+        if(len > available) {
+            len = available;
+            _record.truncated = 1;
+        }
+        const uint16_t strLen = static_cast<uint16_t>(len);
+        _record.payload[_record.len++] = static_cast<char>(AsyncLogRecord::TAG_STR);
+        std::memcpy(_record.payload + _record.len, &strLen, sizeof(strLen));
+        _record.len += sizeof(strLen);
+        std::memcpy(_record.payload + _record.len, str, len);
+        _record.len += len;
+    }
+
+    AsyncLogRecord _record;
+};
+
+//Turns "line << args" into a void expression, so a disabled level is one compare: Voidify() & line is lower precedence
+struct AsyncLogVoidify {
+    void operator&(const AsyncLogLine&) const {
+    }
+};
+
+}//end namespace
+
+#define ASYNC_LOG(level, id) \
+    !ns::AsyncLogger::IsEnabled(level) ? (void)0 : ns::AsyncLogVoidify() & ns::AsyncLogLine(level, id)
+
+#endif
@@ -0,0 +1,111 @@
+#ifndef _COMMON_EVENT_BATCH_H_
+#define _COMMON_EVENT_BATCH_H_
+
+#include <cassert>
+#include <cstddef>
+#include <new>
+
+namespace ns {
+
+/** Optional extension of IAdapterSend. A consumer implementing it next to IAdapterSend receives the incremental
+    events of a whole packet in one call. events points into adapter owned storage, valid for the duration of the call
+*/
+class IBatchSend {
+public:
+    virtual ~IBatchSend() = default;
+    virtual void OnIncrementalBatch(MarketEvent* events, const size_t count) = 0;
+};
+
+/** Marker extension of IAdapterSend. A consumer implementing it accepts IAdapterSend/IBatchSend calls from several
+    threads at once - required by the adapters' multi threaded modes, which send from every worker without a lock
+*/
+class IConcurrentSend {
+public:
+    virtual ~IConcurrentSend() = default;
+};
+
+/** Incremental events collected while a packet is decoded and handed over in one go at packet end, shared by the adapters.
+    Storage is allocated once, cache line aligned. If the capacity is reached mid packet the batch is flushed early,
+    events are never dropped. Consumers without IBatchSend get the usual OnIncremental call per event.
+    One batch per thread - batches on different threads sharing an IAdapterSend need it to be an IConcurrentSend
+*/
+class EventBatch {
+public:
+    static constexpr size_t DEFAULT_CAPACITY = 1024;
+    static constexpr size_t ALIGNMENT = 64;
+
+    explicit EventBatch(const size_t capacity = DEFAULT_CAPACITY)
+        : _capacity(capacity)
+    {
+        _events = static_cast<MarketEvent*>(::operator new(_capacity * sizeof(MarketEvent), std::align_val_t(ALIGNMENT)));
+        for(size_t i = 0; i < _capacity; ++i) {
+            new (&_events[i]) MarketEvent();
+        }
+    }
+
+    ~EventBatch() {
+        for(size_t i = 0; i < _capacity; ++i) {
+            _events[i].~MarketEvent();
+        }
+        ::operator delete(_events, std::align_val_t(ALIGNMENT));
+    }
+
+    EventBatch(const EventBatch&) = delete;
+    EventBatch& operator=(const EventBatch&) = delete;
+
+    void SetSendApi(IAdapterSend* sendApi) {
+        assert(_size == 0);
+        _sendApi = sendApi;
+        _batchApi = dynamic_cast<IBatchSend*>(sendApi);
+    }
+
+    void Append(const MarketEvent& event) {
+        if(_size == _capacity) {
+            Flush();
+        }
+        _events[_size++] = event;
+    }
+
+    void Flush() {
+        if(_size == 0) {
+            return;
+        }
+        _Send();
+    }
+
+    //Snapshot events are not batched - anything pending goes out first to keep the order
+    void SendSnapshot(MarketEvent& event) {
+        _Send();
+        _sendApi->OnSnapshot(&event);
+    }
+
+    size_t GetSize() const {
+        return _size;
+    }
+
+private:
+    void _Send() {
+        if(_size == 0) {
+            return;
+        }
+
+        if(_batchApi) {
+            _batchApi->OnIncrementalBatch(_events, _size);
+        } else {
+            for(size_t i = 0; i < _size; ++i) {
+                _sendApi->OnIncremental(&_events[i]);
+            }
+        }
+        _size = 0;
+    }
+
+    IAdapterSend* _sendApi = nullptr;
+    IBatchSend* _batchApi = nullptr;
+    MarketEvent* _events = nullptr;
+    const size_t _capacity;
+    size_t _size = 0;
+};
+
+}//end namespace
+
+#endif
@@ -0,0 +1,218 @@
+#ifndef _COMMON_PACKET_RING_H_
+#define _COMMON_PACKET_RING_H_
+
+#include <algorithm>
+#include <cstdint>
+#include <cstring>
+#include <vector>
+
+namespace ns {
+
+enum class PacketRingOverflowPolicy : uint8_t {
+    CopyCompact,    //copy packets past the pinned limit into the arena and release the pool buffer
+    Abandon         //reject the packet, the owner drops the buffer and restarts recovery
+};
+
+struct PacketRingConfig {
+    //Hard limit on buffered packets, pinned and compacted
+    size_t maxPackets = 256 * 1024;
+    //Slots allocated by the first push of a recovery, doubled on demand up to maxPackets
+    size_t initialPackets = 1024;
+    //Packets allowed to hold on to a PacketBufferPool buffer
+    size_t maxPinnedPackets = 4 * 1024;
+    //Upper bound of the compaction arena, grown on demand
+    size_t arenaBytes = 64 * 1024 * 1024;
+    PacketRingOverflowPolicy policy = PacketRingOverflowPolicy::CopyCompact;
+};
+
+/** Bounded FIFO of packets buffered during recovery, shared by the adapters.
+    The first maxPinnedPackets keep their pool buffer (zero copy). Past that, depending on the policy, packets are
+    copied into a private arena so the shared PacketBufferPool is never drained by one recovering feed, or rejected.
+    Slots and arena grow with the backlog, bounded by maxPackets and arenaBytes, and are freed once the ring is emptied.
+    Push failures are left to the owner to log, GetOverflows() counts them
+*/
+class PacketRing {
+public:
+    explicit PacketRing(const PacketRingConfig& config = PacketRingConfig())
+        : _config(config)
+    {
+    }
+
+    //Returns false if the packet could not be buffered - the owner has to abandon the current recovery
+    bool Push(const MessageMeta& mm) {
+        const auto& packetBuffer = mm.pb;
+        const size_t len = packetBuffer->m_bytesReceived;
+
+        if(_size == _config.maxPackets) {
+            return _Reject();
+        }
+        if(_size == _entries.size()) {
+            _Grow();
+        }
+
+        Entry& entry = _entries[(_head + _size) % _entries.size()];
+        if(_pinnedPackets < _config.maxPinnedPackets) {
+            entry.mm = mm;
+            entry.compacted = false;
+            ++_pinnedPackets;
+        } else {
+            if(_config.policy != PacketRingOverflowPolicy::CopyCompact || !_Reserve(len)) {
+                return _Reject();
+            }
+            entry.arenaOffset = _arenaUsed;
+            entry.compacted = true;
+            std::memcpy(_arena.data() + _arenaUsed, packetBuffer->m_buffer, len);
+            _arenaUsed += len;
+            ++_compactedPackets;
+        }
+        entry.len = static_cast<uint32_t>(len);
+
+        ++_size;
+        _bytes += len;
+        _highWaterPackets = std::max(_highWaterPackets, _size);
+        _highWaterBytes = std::max(_highWaterBytes, _bytes);
+        return true;
+    }
+
+    //Hands every buffered packet to onPacket(char* buffer, size_t len) in arrival order and empties the ring
+    template<typename OnPacketT>
+    void Drain(OnPacketT onPacket) {
+        DrainWhile([&](char* buffer, const size_t len) {
+            onPacket(buffer, len);
+            return true;
+        });
+    }
+
+    /** Hands buffered packets to onPacket(char* buffer, size_t len) in arrival order for as long as it returns true,
+        the packet it returns false for stays at the head
+    */
+    template<typename OnPacketT>
+    void DrainWhile(OnPacketT onPacket) {
+        while(_size > 0) {
+            Entry& entry = _entries[_head];
+            char* buffer = entry.compacted ? _arena.data() + entry.arenaOffset : entry.mm.pb->m_buffer;
+            if(!onPacket(buffer, static_cast<size_t>(entry.len))) {
+                return;
+            }
+            _Pop();
+        }
+        Clear();
+    }
+
+    //Empties the ring and gives its slots and arena back
+    void Clear() {
+        while(_size > 0) {
+            _Pop();
+        }
+        std::vector<Entry>().swap(_entries);
+        std::vector<char>().swap(_arena);
+        _head = 0;
+        _bytes = 0;
+        _pinnedPackets = 0;
+        _arenaHead = 0;
+        _arenaUsed = 0;
+    }
+
+    bool Empty() const {
+        return _size == 0;
+    }
+
+    size_t GetSize() const                 { return _size; }
+    size_t GetCapacity() const             { return _entries.size(); }
+    size_t GetBytes() const                { return _bytes; }
+    size_t GetPinnedPackets() const        { return _pinnedPackets; }
+    size_t GetArenaBytes() const           { return _arenaUsed; }
+    size_t GetHighWaterPackets() const     { return _highWaterPackets; }
+    size_t GetHighWaterBytes() const       { return _highWaterBytes; }
+    uint64_t GetCompactedPackets() const   { return _compactedPackets; }
+    uint64_t GetOverflows() const          { return _overflows; }
+
+private:
+    struct Entry {
+        MessageMeta mm;
+        size_t arenaOffset = 0;
+        uint32_t len = 0;
+        bool compacted = false;
+    };
+
+    //Unwraps the buffered packets to the front of the larger slot array
+    void _Grow() {
+        const size_t capacity = std::min(std::max(_config.initialPackets, _entries.size() * 2), _config.maxPackets);
+        std::vector<Entry> entries(std::max<size_t>(capacity, 1));
+        for(size_t i = 0; i < _size; ++i) {
+            entries[i] = std::move(_entries[(_head + i) % _entries.size()]);
+        }
+        _entries.swap(entries);
+        _head = 0;
+    }
+
+    void _Pop() {
+        Entry& entry = _entries[_head];
+        if(!entry.compacted) {
+            entry.mm = MessageMeta{};   //give the buffer back to the pool
+            --_pinnedPackets;
+        } else {
+            _arenaHead = entry.arenaOffset + entry.len;
+        }
+        _bytes -= entry.len;
+        _head = (_head + 1) % _entries.size();
+        --_size;
+
+        //No compacted packet left - the arena starts over
+        if(_size == _pinnedPackets) {
+            _arenaHead = 0;
+            _arenaUsed = 0;
+        }
+    }
+
+    bool _Reserve(const size_t len) {
+        if(_arenaUsed + len > _config.arenaBytes && _arenaHead > 0) {
+            _ReclaimArena();
+        }
+        const size_t needed = _arenaUsed + len;
+        if(needed > _config.arenaBytes) {
+            return false;
+        }
+        if(needed > _arena.size()) {
+            _arena.resize(std::min(std::max(needed, _arena.size() * 2), _config.arenaBytes));
+        }
+        return true;
+    }
+
+    //Compacted packets are in arrival order in the arena - the ones already drained are a prefix, moved over
+    void _ReclaimArena() {
+        std::memmove(_arena.data(), _arena.data() + _arenaHead, _arenaUsed - _arenaHead);
+        for(size_t i = 0; i < _size; ++i) {
+            Entry& entry = _entries[(_head + i) % _entries.size()];
+            if(entry.compacted) {
+                entry.arenaOffset -= _arenaHead;
+            }
+        }
+        _arenaUsed -= _arenaHead;
+        _arenaHead = 0;
+    }
+
+    bool _Reject() {
+        ++_overflows;
+        return false;
+    }
+
+    PacketRingConfig _config;
+    std::vector<Entry> _entries;
+    size_t _head = 0;
+    size_t _size = 0;
+    size_t _bytes = 0;
+    size_t _pinnedPackets = 0;
+    std::vector<char> _arena;
+    size_t _arenaHead = 0;              //start of the oldest compacted packet still buffered
+    size_t _arenaUsed = 0;
+
+    size_t _highWaterPackets = 0;
+    size_t _highWaterBytes = 0;
+    uint64_t _compactedPackets = 0;
+    uint64_t _overflows = 0;
+};
+
+}//end namespace
+
+#endif
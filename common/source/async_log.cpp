@@ -0,0 +1,174 @@
+#include <cassert>
+#include <cstdlib>
+
+#include "common/async_log.h"
+#include "logger/logger.h"
+
+namespace ns {
+
+AsyncLogger& AsyncLogger::Instance() {
+    static AsyncLogger instance;
+    //Registered after the instance is constructed, so it runs before the instance and anything constructed ahead of it is destroyed
+    static const int atExit = std::atexit([] { Instance().Shutdown(); });
+    (void)atExit;
+    return instance;
+}
+
+AsyncLogger::AsyncLogger()
+{
+    _thread = std::thread(&AsyncLogger::_Run, this);
+}
+
+AsyncLogger::~AsyncLogger()
+{
+    Shutdown();
+}
+
+void AsyncLogger::Shutdown() {
+    if(!_running.exchange(false)) {
+        return;
+    }
+    if(_thread.joinable()) {
+        _thread.join();
+    }
+
+    //Whatever was logged before shutdown
+    _DrainAll();
+}
+
+AsyncLogRing& AsyncLogger::_GetThreadRing() {
+    thread_local std::shared_ptr<AsyncLogRing> ring;
+    if(!ring) {
+        ring = std::make_shared<AsyncLogRing>();
+        std::lock_guard<std::mutex> lock(_mutex);
+        _rings.push_back(ring);
+    }
+    return *ring;
+}
+
+void AsyncLogger::Commit(const AsyncLogRecord& record) {
+    if(!_running.load(std::memory_order_relaxed)) {
+        std::ostringstream ss;
+        _Emit(record, ss);
+        return;
+    }
+
+    AsyncLogRing& ring = _GetThreadRing();
+    if(record.level < AsyncLogLevel::Warn) {
+        if(!ring.TryPush(record)) {
+            ring.AddDropped(record.id);
+        }
+        return;
+    }
+
+    //Warnings and errors are never dropped, the caller waits for the formatter
+    while(!ring.TryPush(record)) {
+        if(!_running.load(std::memory_order_relaxed)) {
+            std::ostringstream ss;
+            _Emit(record, ss);
+            return;
+        }
+        std::this_thread::yield();
+    }
+}
+
+void AsyncLogger::_Run() {
+    while(_running.load(std::memory_order_relaxed)) {
+        if(_DrainAll() == 0) {
+            std::this_thread::sleep_for(std::chrono::milliseconds(1));
+        }
+    }
+}
+
+size_t AsyncLogger::_DrainAll() {
+    size_t count = 0;
+    std::lock_guard<std::mutex> lock(_mutex);
+    for(auto it = std::begin(_rings); it != std::end(_rings); ) {
+        AsyncLogRing& ring = **it;
+        //Read before draining - once the owning thread is gone nothing it logged can be pushed after the drain
+        const bool orphaned = it->use_count() == 1;
+        std::atomic_thread_fence(std::memory_order_acquire);
+        count += ring.Drain([this](const AsyncLogRecord& record) { _Emit(record, _ss); });
+
+        uint32_t id;
+        const uint64_t dropped = ring.TakeDropped(id);
+        if(dropped > 0) {
+            LOG(WARNING, id) << "Async log ring full - dropped " << dropped << " records";
+        }
+
+        if(orphaned) {
+            it = _rings.erase(it);
+        } else {
+            ++it;
+        }
+    }
+    return count;
+}
+
+void AsyncLogger::_Emit(const AsyncLogRecord& record, std::ostringstream& ss) {
+    ss.str("");
+    ss.clear();
+
+    const char* readPtr = record.payload;
+    const char* endPtr = record.payload + record.len;
+    while(readPtr < endPtr) {
+        const uint8_t tag = static_cast<uint8_t>(*readPtr++);
+        switch(tag) {
+        case AsyncLogRecord::TAG_I64: {
+            int64_t value;
+            std::memcpy(&value, readPtr, sizeof(value));
+            readPtr += sizeof(value);
+            ss << value;
+        }
+        break;
+        case AsyncLogRecord::TAG_U64: {
+            uint64_t value;
+            std::memcpy(&value, readPtr, sizeof(value));
+            readPtr += sizeof(value);
+            ss << value;
+        }
+        break;
+        case AsyncLogRecord::TAG_F64: {
+            double value;
+            std::memcpy(&value, readPtr, sizeof(value));
+            readPtr += sizeof(value);
+            ss << value;
+        }
+        break;
+        case AsyncLogRecord::TAG_CHAR: {
+            ss << *readPtr++;
+        }
+        break;
+        case AsyncLogRecord::TAG_BOOL: {
+            ss << static_cast<bool>(*readPtr++);
+        }
+        break;
+        case AsyncLogRecord::TAG_STR: {
+            uint16_t len;
+            std::memcpy(&len, readPtr, sizeof(len));
+            readPtr += sizeof(len);
+            ss.write(readPtr, len);
+            readPtr += len;
+        }
+        break;
+        default: {
+            assert(!"AsyncLogger - unhandled tag");
+            readPtr = endPtr;
+        }
+        break;
+        }//end switch
+    }
+
+    if(record.truncated) {
+        ss << " [truncated]";
+    }
+
+    switch(record.level) {
+    case AsyncLogLevel::Debug:  LOG(DEBUG, record.id) << ss.str(); break;
+    case AsyncLogLevel::Info:   LOG(INFO, record.id) << ss.str(); break;
+    case AsyncLogLevel::Warn:   LOG(WARNING, record.id) << ss.str(); break;
+    case AsyncLogLevel::Error:  LOG(ERROR, record.id) << ss.str(); break;
+    }
+}
+
+}//end namespace